@@ -0,0 +1,60 @@
+#ifndef ENHANCER_ALIGNEDMEMORY_H
+#define ENHANCER_ALIGNEDMEMORY_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <new>
+#ifdef WIN32
+    #include <malloc.h>
+#endif
+
+/*
+    Aligned allocations that also build with MinGW and MSVC: their C runtime has no std::aligned_alloc, and memory from
+    _aligned_malloc has to be given back with _aligned_free. Everything that is allocated here is freed with AlignedMemory::release.
+*/
+
+class AlignedMemory {
+public:
+    //size has to be a multiple of alignment (a requirement of std::aligned_alloc); nullptr if there is not enough memory.
+    static void* allocate(size_t alignment, size_t size) {
+#ifdef WIN32
+        return _aligned_malloc(size, alignment);
+#else
+        return std::aligned_alloc(alignment, size);
+#endif
+    }
+
+    //Changes the size of a block from allocate, like realloc, and keeps it aligned. The block may move. If there is not enough memory,
+    //nullptr is returned and the block is left as it was, unless it was already moved: then it is freed and std::bad_alloc is thrown.
+    static void* reallocate(void* memory, size_t alignment, size_t size) {
+#ifdef WIN32
+        return _aligned_realloc(memory, size, alignment);
+#else
+        //glibc shrinks a heap block in place and a mapped one with mremap, which returns the pages at the end to the system
+        void* resized = std::realloc(memory, size);
+        if (!resized || reinterpret_cast<uintptr_t>(resized) % alignment == 0) return resized;
+
+        //realloc only promises the alignment of malloc if it moves the block, in that case it is copied once more
+        void* aligned = allocate(alignment, size);
+        if (!aligned) {
+            std::free(resized);
+            throw std::bad_alloc();
+        }
+        std::memcpy(aligned, resized, size);
+        std::free(resized);
+        return aligned;
+#endif
+    }
+
+    static void release(void* memory) {
+#ifdef WIN32
+        _aligned_free(memory);
+#else
+        std::free(memory);
+#endif
+    }
+};
+
+#endif //ENHANCER_ALIGNEDMEMORY_H
@@ -0,0 +1,653 @@
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+
+#include "AsyncFileIO.h"
+#include "BufferPool.h"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+    #define ENHANCER_IO_URING
+    #include <linux/io_uring.h>
+    #include <sys/syscall.h>
+    #include <sys/mman.h>
+    #include <sys/eventfd.h>
+    #include <sys/stat.h>
+    #include <poll.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <cerrno>
+#endif
+
+namespace {
+    //O_DIRECT transfers have to be aligned to the logical block size of the device, 4 KB covers all common ones
+    const size_t directAlignment = 4096;
+
+    //a single read or write transfers at most this much, the rest follows in further operations
+    const size_t maxTransfer = size_t(1) << 30;
+}
+
+struct AsyncFileIO::Request {
+    enum Kind {Read, Write} kind;
+    enum Stage {Opening, Transferring, Closing} stage = Opening;
+
+    int index = -1;   //of the input, for reads
+    std::string path;
+    int fd = -1;
+
+    //the bytes of the file; for O_DIRECT writes they are copied into an aligned buffer, padded to whole blocks
+    unsigned char* buffer = nullptr;
+    size_t size = 0, transferSize = 0, transferred = 0;
+    std::vector<unsigned char> bytes;
+    bool direct = false, ownsAlignedBuffer = false;
+
+    bool failed = false;
+    int pendingOperations = 0;
+    WriteCallback callback;
+
+#ifdef ENHANCER_IO_URING
+    struct statx status;
+#endif
+
+    ~Request() {
+        if (ownsAlignedBuffer) std::free(buffer);
+    }
+};
+
+#ifdef ENHANCER_IO_URING
+//The submission and completion queues shared with the kernel, see io_uring(7).
+struct AsyncFileIO::Ring {
+    int fd = -1;
+    unsigned entries = 0;
+
+    void* sqRing = MAP_FAILED;
+    void* cqRing = MAP_FAILED;
+    size_t sqRingSize = 0, cqRingSize = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqesSize = 0;
+
+    unsigned *sqHead, *sqTail, *sqMask, *sqArray;
+    unsigned *cqHead, *cqTail, *cqMask;
+    io_uring_cqe* cqes;
+
+    //entries that have been filled in but not yet submitted
+    unsigned toSubmit = 0;
+
+    bool setUp(unsigned requestedEntries) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        fd = static_cast<int>(syscall(__NR_io_uring_setup, requestedEntries, &params));
+        if (fd < 0) return false;
+
+        entries = params.sq_entries;
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+        //newer kernels map both rings with a single mmap
+        bool singleMapping = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMapping) sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+
+        sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (sqRing == MAP_FAILED) return false;
+        cqRing = singleMapping ? sqRing : mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED) return false;
+
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe*>(mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+        if (sqes == MAP_FAILED) return false;
+
+        auto* sq = static_cast<unsigned char*>(sqRing);
+        sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+        auto* cq = static_cast<unsigned char*>(cqRing);
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    ~Ring() {
+        if (sqes != MAP_FAILED) munmap(sqes, sqesSize);
+        if (cqRing != MAP_FAILED && cqRing != sqRing) munmap(cqRing, cqRingSize);
+        if (sqRing != MAP_FAILED) munmap(sqRing, sqRingSize);
+        if (fd >= 0) close(fd);
+    }
+
+    //The next free submission queue entry, cleared. The caller makes sure that no more than entries operations are in flight.
+    io_uring_sqe* nextEntry() {
+        unsigned tail = *sqTail;
+        unsigned index = tail & *sqMask;
+        io_uring_sqe* entry = &sqes[index];
+        std::memset(entry, 0, sizeof(*entry));
+
+        sqArray[index] = index;
+        //the kernel may only see the new tail once the entry is complete
+        __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+        toSubmit++;
+        return entry;
+    }
+
+    //Submits the filled entries and waits until at least minComplete operations are complete. Returns false on errors other than EINTR.
+    bool enter(unsigned minComplete) {
+        long result = syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, IORING_ENTER_GETEVENTS, nullptr, 0);
+        if (result < 0) return errno == EINTR || errno == EAGAIN || errno == EBUSY;
+
+        toSubmit -= std::min(toSubmit, static_cast<unsigned>(result));
+        return true;
+    }
+};
+#else
+struct AsyncFileIO::Ring {};
+#endif
+
+AsyncFileIO::AsyncFileIO(const std::vector<std::filesystem::path>& inputs, const Options& options)
+        : inputs(inputs), options(options), inputStates(inputs.size(), NotRead), inputFiles(inputs.size()) {
+    this->options.readAhead = std::max(this->options.readAhead, 0);
+    this->options.queueDepth = std::max(this->options.queueDepth, 4u);
+
+    //the first files are needed right away, they are read while the workers start up
+    readTarget = std::min(std::max(this->options.readAhead, 1), static_cast<int>(inputs.size()));
+
+#ifdef ENHANCER_IO_URING
+    if (this->options.useIoUring) {
+        ring = std::make_unique<Ring>();
+        wakeUpEvent = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (wakeUpEvent < 0 || !ring->setUp(this->options.queueDepth)) ring.reset();
+    }
+#endif
+
+    if (ring) thread = std::thread(&AsyncFileIO::ringLoop, this);
+    else thread = std::thread(&AsyncFileIO::blockingLoop, this);
+}
+
+AsyncFileIO::~AsyncFileIO() {
+    finish();
+
+    //inputs that were read ahead but never taken
+    for (size_t index = 0; index < inputFiles.size(); index++) {
+        if (inputStates[index] == Read) releaseInput(inputFiles[index]);
+    }
+
+#ifdef ENHANCER_IO_URING
+    if (wakeUpEvent >= 0) close(wakeUpEvent);
+#endif
+}
+
+AsyncFileIO::InputFile AsyncFileIO::takeInput(int index) {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    //the files behind this one are read while it is being processed
+    int target = std::min(index + 1 + options.readAhead, static_cast<int>(inputs.size()));
+    if (target > readTarget) {
+        readTarget = target;
+        lock.unlock();
+        wakeUp();
+        lock.lock();
+    }
+
+    inputReady.wait(lock, [&] { return inputStates[index] == Read; });
+    inputStates[index] = Taken;
+
+    InputFile input = inputFiles[index];
+    inputFiles[index] = InputFile();
+    return input;
+}
+
+void AsyncFileIO::releaseInput(InputFile& input) {
+    BufferPool::release(input.data);
+    input = InputFile();
+}
+
+void AsyncFileIO::writeOutput(const std::string& path, std::vector<unsigned char> bytes, WriteCallback done) {
+    auto request = std::make_unique<Request>();
+    request->kind = Request::Write;
+    request->path = path;
+    request->bytes = std::move(bytes);
+    request->size = request->bytes.size();
+    request->callback = std::move(done);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queuedWrites.push_back(std::move(request));
+    }
+    wakeUp();
+}
+
+bool AsyncFileIO::finish() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeUp();
+    if (thread.joinable()) thread.join();
+
+    return allWritesSucceeded;
+}
+
+bool AsyncFileIO::usesIoUring() const {
+    return ring != nullptr && !ringFailed;
+}
+
+AsyncFileIO::Statistics AsyncFileIO::getStatistics() const {
+    return {filesRead.load(), bytesRead.load(), filesWritten.load(), bytesWritten.load(), submissions.load(), operations.load()};
+}
+
+bool AsyncFileIO::ioUringIsAvailable() {
+#ifdef ENHANCER_IO_URING
+    Ring probe;
+    return probe.setUp(4);
+#else
+    return false;
+#endif
+}
+
+void AsyncFileIO::wakeUp() {
+#ifdef ENHANCER_IO_URING
+    if (usesIoUring()) {
+        uint64_t one = 1;
+        ssize_t written = write(wakeUpEvent, &one, sizeof(one));
+        (void) written;   //the counter can only be full if the I/O thread is already awake
+        return;
+    }
+#endif
+    workQueued.notify_one();
+}
+
+std::vector<std::unique_ptr<AsyncFileIO::Request>> AsyncFileIO::takeWork(size_t maxRequests, bool& stop) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::unique_ptr<Request>> work;
+
+    //the writes come first, they give the memory of the encoded files back
+    while (work.size() < maxRequests && !queuedWrites.empty()) {
+        work.push_back(std::move(queuedWrites.front()));
+        queuedWrites.pop_front();
+    }
+
+    //nobody takes inputs after finish()
+    while (!stopping && work.size() < maxRequests && nextRead < readTarget) {
+        auto request = std::make_unique<Request>();
+        request->kind = Request::Read;
+        request->index = nextRead;
+        request->path = inputs[nextRead].string();
+        inputStates[nextRead++] = Reading;
+        work.push_back(std::move(request));
+    }
+
+    stop = stopping && queuedWrites.empty();
+    return work;
+}
+
+void AsyncFileIO::completeRead(Request& request, bool success) {
+    if (success) {
+        filesRead++;
+        bytesRead += request.size;
+    }
+    else {
+        BufferPool::release(request.buffer);
+        request.buffer = nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        inputFiles[request.index] = {request.buffer, success ? request.size : 0, success};
+        inputStates[request.index] = Read;
+    }
+    request.buffer = nullptr;
+    inputReady.notify_all();
+}
+
+void AsyncFileIO::completeWrite(Request& request, bool success) {
+    if (success) {
+        filesWritten++;
+        bytesWritten += request.size;
+    }
+    else {
+        std::lock_guard<std::mutex> lock(mutex);
+        allWritesSucceeded = false;
+    }
+
+    if (request.callback) request.callback(success);
+}
+
+void AsyncFileIO::ringLoop() {
+#ifdef ENHANCER_IO_URING
+    //operations carry their request in user_data; the statx of a read is tagged in the lowest bit, user_data 0 is the wake-up event
+    const uint64_t statxTag = 1;
+    unsigned inFlight = 0;
+    std::vector<std::unique_ptr<Request>> active;
+
+    auto armWakeUp = [&] {
+        io_uring_sqe* entry = ring->nextEntry();
+        entry->opcode = IORING_OP_POLL_ADD;
+        entry->fd = wakeUpEvent;
+        entry->poll32_events = POLLIN;
+        entry->user_data = 0;
+        inFlight++;
+    };
+
+    auto submitOpen = [&](Request& request) {
+        io_uring_sqe* entry = ring->nextEntry();
+        entry->opcode = IORING_OP_OPENAT;
+        entry->fd = AT_FDCWD;
+        entry->addr = reinterpret_cast<uint64_t>(request.path.c_str());
+        if (request.kind == Request::Read) {
+            entry->open_flags = O_RDONLY | O_CLOEXEC;
+        }
+        else {
+            entry->open_flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | (request.direct ? O_DIRECT : 0);
+            entry->len = 0644;
+        }
+        entry->user_data = reinterpret_cast<uint64_t>(&request);
+        request.pendingOperations++;
+        inFlight++;
+        operations++;
+    };
+
+    auto submitStatx = [&](Request& request) {
+        io_uring_sqe* entry = ring->nextEntry();
+        entry->opcode = IORING_OP_STATX;
+        entry->fd = AT_FDCWD;
+        entry->addr = reinterpret_cast<uint64_t>(request.path.c_str());
+        entry->len = STATX_SIZE;
+        entry->off = reinterpret_cast<uint64_t>(&request.status);
+        entry->user_data = reinterpret_cast<uint64_t>(&request) | statxTag;
+        request.pendingOperations++;
+        inFlight++;
+        operations++;
+    };
+
+    auto submitTransfer = [&](Request& request) {
+        io_uring_sqe* entry = ring->nextEntry();
+        entry->opcode = (request.kind == Request::Read) ? IORING_OP_READ : IORING_OP_WRITE;
+        entry->fd = request.fd;
+        entry->addr = reinterpret_cast<uint64_t>(request.buffer + request.transferred);
+        entry->len = static_cast<uint32_t>(std::min(request.transferSize - request.transferred, maxTransfer));
+        entry->off = request.transferred;
+        entry->user_data = reinterpret_cast<uint64_t>(&request);
+        request.stage = Request::Transferring;
+        request.pendingOperations++;
+        inFlight++;
+        operations++;
+    };
+
+    auto submitClose = [&](Request& request) {
+        io_uring_sqe* entry = ring->nextEntry();
+        entry->opcode = IORING_OP_CLOSE;
+        entry->fd = request.fd;
+        entry->user_data = reinterpret_cast<uint64_t>(&request);
+        request.stage = Request::Closing;
+        request.pendingOperations++;
+        inFlight++;
+        operations++;
+    };
+
+    auto finishRequest = [&](Request& request) {
+        if (request.kind == Request::Read) completeRead(request, !request.failed);
+        else completeWrite(request, !request.failed);
+
+        active.erase(std::find_if(active.begin(), active.end(), [&](const std::unique_ptr<Request>& other) { return other.get() == &request; }));
+    };
+
+    //a request that failed after its file was opened still closes it
+    auto closeOrFinish = [&](Request& request) {
+        if (request.fd >= 0) submitClose(request);
+        else finishRequest(request);
+    };
+
+    auto startTransfer = [&](Request& request) {
+        if (request.kind == Request::Read) {
+            request.size = request.status.stx_size;
+            request.transferSize = request.size;
+            try {
+                request.buffer = static_cast<unsigned char*>(BufferPool::acquire(std::max<size_t>(request.size, 1)));
+            }
+            catch (const std::bad_alloc&) {
+                request.failed = true;
+            }
+        }
+        else if (request.direct) {
+            //O_DIRECT writes whole blocks from aligned memory, the padding is cut off again before the file is closed
+            request.transferSize = (request.size + directAlignment - 1) / directAlignment * directAlignment;
+            request.buffer = static_cast<unsigned char*>(std::aligned_alloc(directAlignment, std::max(request.transferSize, directAlignment)));
+            if (request.buffer) {
+                request.ownsAlignedBuffer = true;
+                std::memcpy(request.buffer, request.bytes.data(), request.size);
+                std::memset(request.buffer + request.size, 0, request.transferSize - request.size);
+            }
+            else {
+                request.failed = true;
+            }
+        }
+        else {
+            request.buffer = request.bytes.data();
+            request.transferSize = request.size;
+        }
+
+        if (request.failed || request.transferSize == 0) closeOrFinish(request);
+        else submitTransfer(request);
+    };
+
+    auto complete = [&](Request& request, bool isStatx, int result) {
+        request.pendingOperations--;
+
+        switch (request.stage) {
+            case Request::Opening:
+                if (request.kind == Request::Write && result == -EINVAL && request.direct) {
+                    //the file system doesn't support O_DIRECT (e.g. tmpfs), the file is written through the page cache then
+                    request.direct = false;
+                    submitOpen(request);
+                    return;
+                }
+                if (result < 0) request.failed = true;
+                else if (!isStatx) request.fd = result;
+
+                //a read waits for its open and its statx
+                if (request.pendingOperations > 0) return;
+                if (request.failed) closeOrFinish(request);
+                else startTransfer(request);
+                return;
+
+            case Request::Transferring:
+                if (result == -EINTR || result == -EAGAIN) {
+                    submitTransfer(request);
+                    return;
+                }
+
+                //a read that ends early means that the file shrank while it was read
+                if (result <= 0 || (request.direct && result % directAlignment != 0 && request.transferred + result < request.transferSize)) {
+                    request.failed = true;
+                    submitClose(request);
+                    return;
+                }
+
+                request.transferred += result;
+                if (request.transferred < request.transferSize) {
+                    submitTransfer(request);
+                    return;
+                }
+
+                //there is no truncate operation on older kernels, but it only changes the size of the file
+                if (request.transferSize != request.size && ftruncate(request.fd, static_cast<off_t>(request.size)) != 0) request.failed = true;
+                submitClose(request);
+                return;
+
+            case Request::Closing:
+                //writes on network file systems may only report their errors when the file is closed
+                if (result < 0 && request.kind == Request::Write) request.failed = true;
+                request.fd = -1;
+                finishRequest(request);
+                return;
+        }
+    };
+
+    armWakeUp();
+    int nrOfEnters = 0;
+
+    while (true) {
+        //every new request needs up to two operations at a time
+        bool stop;
+        std::vector<std::unique_ptr<Request>> work = takeWork((ring->entries - inFlight) / 2, stop);
+        if (stop && active.empty() && work.empty()) return;
+
+        for (std::unique_ptr<Request>& request : work) {
+            Request& started = *request;
+            active.push_back(std::move(request));
+
+            if (started.kind == Request::Write) {
+                started.direct = options.directOutput;
+                submitOpen(started);
+            }
+            else {
+                submitOpen(started);
+                submitStatx(started);
+            }
+        }
+
+        //submits everything at once and sleeps until something completes (or new work is queued)
+        if (ring->toSubmit > 0) submissions++;
+        if (options.failRingAfter > 0 && ++nrOfEnters > options.failRingAfter) break;
+        if (!ring->enter(1)) break;
+
+        unsigned head = *ring->cqHead;
+        unsigned tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+        while (head != tail) {
+            io_uring_cqe completion = ring->cqes[head & *ring->cqMask];
+            head++;
+            __atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+            inFlight--;
+
+            if (completion.user_data == 0) {
+                uint64_t counter;
+                ssize_t drained = read(wakeUpEvent, &counter, sizeof(counter));
+                (void) drained;
+                armWakeUp();
+                continue;
+            }
+
+            auto* request = reinterpret_cast<Request*>(completion.user_data & ~statxTag);
+            complete(*request, (completion.user_data & statxTag) != 0, completion.res);
+            tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+        }
+    }
+
+    //The ring failed (which only happens when the system is out of resources): the rest is done with blocking calls. From now on the other
+    //threads wake the blocking loop through workQueued. Whatever they queued before they saw the flag is found by its first check, because
+    //the flag is set under the same mutex as the queues.
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ringFailed = true;
+    }
+
+    //The kernel may still read into or write from the buffers of the active requests, so they are only retried once all their operations
+    //are complete. Only the wake-up poll never completes on its own, it is cancelled.
+    const uint64_t cancelData = 2;
+    bool drained = ring->enter(0);
+    if (drained) {
+        io_uring_sqe* entry = ring->nextEntry();
+        entry->opcode = IORING_OP_ASYNC_CANCEL;
+        entry->addr = 0;
+        entry->user_data = cancelData;
+        inFlight++;
+    }
+
+    while (drained && inFlight > 0) {
+        if (!ring->enter(1)) {
+            drained = false;
+            break;
+        }
+
+        unsigned head = *ring->cqHead;
+        unsigned tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+        while (head != tail) {
+            io_uring_cqe completion = ring->cqes[head & *ring->cqMask];
+            head++;
+            __atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+            inFlight--;
+            if (completion.user_data == 0 || completion.user_data == cancelData) continue;
+
+            //the transfers are done again, only the files that are open matter
+            auto* request = reinterpret_cast<Request*>(completion.user_data & ~statxTag);
+            bool isStatx = (completion.user_data & statxTag) != 0;
+            request->pendingOperations--;
+            if (request->stage == Request::Opening && !isStatx && completion.res >= 0) request->fd = completion.res;
+            else if (request->stage == Request::Closing) request->fd = -1;
+        }
+    }
+
+    for (std::unique_ptr<Request>& request : active) {
+        if (request->pendingOperations > 0) {
+            //the ring couldn't be drained either, so the request and its buffer are left to the kernel and the file fails
+            Request* abandoned = request.release();
+            abandoned->buffer = nullptr;
+            if (abandoned->kind == Request::Read) completeRead(*abandoned, false);
+            else completeWrite(*abandoned, false);
+            continue;
+        }
+
+        if (request->fd >= 0) close(request->fd);
+        request->fd = -1;
+        if (request->kind == Request::Read) {
+            BufferPool::release(request->buffer);
+            request->buffer = nullptr;
+            readBlocking(*request);
+        }
+        else {
+            writeBlocking(*request);
+        }
+    }
+    active.clear();
+    blockingLoop();
+#endif
+}
+
+void AsyncFileIO::blockingLoop() {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workQueued.wait(lock, [&] { return stopping || !queuedWrites.empty() || nextRead < readTarget; });
+        }
+
+        bool stop;
+        std::vector<std::unique_ptr<Request>> work = takeWork(1, stop);
+        if (work.empty()) {
+            if (stop) return;
+            continue;
+        }
+
+        if (work.front()->kind == Request::Read) readBlocking(*work.front());
+        else writeBlocking(*work.front());
+    }
+}
+
+void AsyncFileIO::readBlocking(Request& request) {
+    std::ifstream file(request.path, std::ios::binary | std::ios::ate);
+    std::streamsize fileSize = file ? static_cast<std::streamsize>(file.tellg()) : -1;
+
+    bool success = false;
+    if (fileSize >= 0) {
+        request.size = static_cast<size_t>(fileSize);
+        try {
+            request.buffer = static_cast<unsigned char*>(BufferPool::acquire(std::max<size_t>(request.size, 1)));
+            file.seekg(0);
+            success = static_cast<bool>(file.read(reinterpret_cast<char*>(request.buffer), fileSize));
+        }
+        catch (const std::bad_alloc&) {
+            success = false;
+        }
+    }
+
+    completeRead(request, success);
+}
+
+void AsyncFileIO::writeBlocking(Request& request) {
+    std::ofstream file(request.path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(request.bytes.data()), static_cast<std::streamsize>(request.bytes.size()));
+    file.close();
+
+    completeWrite(request, !file.fail());
+}
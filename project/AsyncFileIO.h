@@ -0,0 +1,141 @@
+#ifndef ENHANCER_ASYNCFILEIO_H
+#define ENHANCER_ASYNCFILEIO_H
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+/*
+    This class moves all file I/O of a batch off the compute threads: the input files are read into memory ahead of the workers,
+    and the encoded output files are written behind them, both on a single I/O thread.
+
+    On Linux the I/O thread drives an io_uring (set up with the raw io_uring_setup / io_uring_enter syscalls, no liburing), so the opens,
+    reads, writes and closes of many files are in flight at the same time and go to the kernel in batches: a file is opened (and its
+    size queried with statx) with one submission, read with one, and closed with one, no matter how many files are queued next to it.
+    Workers only block when the file they need hasn't been read yet. Output files can be opened with O_DIRECT, which writes them
+    without going through the page cache; their last block is padded for that, and cut back to size afterwards.
+
+    Where io_uring isn't available (older kernels, seccomp filters, other systems) the I/O thread does the same work with blocking
+    calls, so the compute threads still never touch the file system.
+*/
+
+class AsyncFileIO {
+public:
+    struct Options {
+        //Number of input files that are read ahead of the file a worker takes.
+        int readAhead = 4;
+
+        //Open the output files with O_DIRECT (if the file system supports it).
+        bool directOutput = false;
+
+        //Use io_uring if the kernel supports it, instead of blocking calls on the I/O thread.
+        bool useIoUring = true;
+
+        //Number of operations that can be in flight at the same time.
+        unsigned queueDepth = 64;
+
+        //For tests: the ring fails after this many calls into the kernel, as if the system had run out of resources (0 = never).
+        int failRingAfter = 0;
+    };
+
+    AsyncFileIO(const std::vector<std::filesystem::path>& inputs, const Options& options);
+
+    //Waits for the queued writes (see finish).
+    ~AsyncFileIO();
+
+    AsyncFileIO(const AsyncFileIO&) = delete;
+    AsyncFileIO& operator=(const AsyncFileIO&) = delete;
+
+    //A file that has been read into memory; the bytes come from the BufferPool and go back with releaseInput.
+    struct InputFile {
+        unsigned char* data = nullptr;
+        size_t size = 0;
+        bool ok = false;
+    };
+
+    //Waits until inputs[index] has been read and takes it over. Every input can only be taken once.
+    InputFile takeInput(int index);
+
+    static void releaseInput(InputFile& input);
+
+    //Called on the I/O thread once the file is written and closed (true) or could not be written (false).
+    using WriteCallback = std::function<void(bool success)>;
+
+    //Queues bytes to be written to a new file at path (an existing file is replaced).
+    void writeOutput(const std::string& path, std::vector<unsigned char> bytes, WriteCallback done);
+
+    //Waits until all queued writes are done and stops the I/O thread. Returns whether all of them succeeded.
+    bool finish();
+
+    //Whether the I/O thread uses io_uring (false when it fell back to blocking calls).
+    bool usesIoUring() const;
+
+    //Counters since the construction.
+    struct Statistics {
+        uint64_t filesRead, bytesRead;
+        uint64_t filesWritten, bytesWritten;
+        uint64_t submissions;   //calls into the kernel to submit operations (io_uring_enter); many operations share one
+        uint64_t operations;    //operations that went through the ring
+    };
+
+    Statistics getStatistics() const;
+
+    //Whether this system supports io_uring.
+    static bool ioUringIsAvailable();
+
+private:
+    struct Request;
+    struct Ring;
+
+    const std::vector<std::filesystem::path>& inputs;
+    Options options;
+
+    std::unique_ptr<Ring> ring;
+    int wakeUpEvent = -1;
+
+    //set (under mutex) when the ring has failed and the I/O thread has moved on to blocking calls, which wait on workQueued instead
+    std::atomic<bool> ringFailed{false};
+
+    std::mutex mutex;
+    std::condition_variable inputReady, workQueued;
+
+    //read state of every input, and inputs[0, nextRead) have been handed to the I/O thread
+    enum InputState {NotRead, Reading, Read, Taken};
+    std::vector<InputState> inputStates;
+    std::vector<InputFile> inputFiles;
+    int nextRead = 0, readTarget = 0;
+
+    std::deque<std::unique_ptr<Request>> queuedWrites;
+    bool stopping = false;
+    bool allWritesSucceeded = true;
+
+    std::thread thread;
+
+    std::atomic<uint64_t> filesRead{0}, bytesRead{0}, filesWritten{0}, bytesWritten{0}, submissions{0}, operations{0};
+
+    //Wakes the I/O thread up after new work has been queued.
+    void wakeUp();
+
+    //Takes the next requests that the I/O thread should start on, as many as the queue has room for.
+    std::vector<std::unique_ptr<Request>> takeWork(size_t maxRequests, bool& stop);
+
+    void completeRead(Request& request, bool success);
+    void completeWrite(Request& request, bool success);
+
+    void ringLoop();
+    void blockingLoop();
+
+    void readBlocking(Request& request);
+    void writeBlocking(Request& request);
+};
+
+#endif //ENHANCER_ASYNCFILEIO_H
@@ -2,23 +2,65 @@
 #include <filesystem>
 #include <omp.h>
 #include <fstream>
+#include <algorithm>
+#include <memory>
+#include <sstream>
+#include <numeric>
+#include <atomic>
+#include <functional>
 
 #include "BatchProcessor.h"
 #include "CommandLineInterface.h"
 #include "termcolor.hpp"
 #include "EnhancerImage.h"
+#include "GrayscaleKernels.h"
+#include "ThresholdKernels.h"
+#include "BufferPool.h"
+#include "FilePrefetcher.h"
+#include "AsyncFileIO.h"
+#include "ImagePipeline.h"
+#include "ThreadPool.h"
+#include "BatchSchedule.h"
+#include "TuningProfile.h"
 
 BatchProcessor::BatchProcessor(CommandLineInterface& cli) : cli(cli) {
+    //the grayscale and thresholding kernels are chosen from the CPU features once, here at startup, unless the user (or the profile) picked others
+    selectKernels();
+    cli.printDebugInformation(std::string("Grayscale conversion kernel: ") + GrayscaleKernels::name(GrayscaleKernels::selectedInstructionSet()) + "\n", CommandLineInterface::MessageType::Information);
+    cli.printDebugInformation(std::string("Thresholding kernel: ") + ThresholdKernels::name(ThresholdKernels::selectedInstructionSet()) + "\n", CommandLineInterface::MessageType::Information);
+
     //run the benchmarks or start processing the files from the folder, depending on the mode the user choose.
     if (cli.benchmarkMode()) {
         benchmark_nrOfThreads();
     }
+    else if (cli.tuneMode()) {
+        tune();
+    }
     else {
         processFolder(BatchProcessor::OperationType::AdaptiveThresholding);
     }
 };
 
+void BatchProcessor::selectKernels() {
+    GrayscaleKernels::selectInstructionSet(cli.getGrayscaleKernel() < 0 ? GrayscaleKernels::bestInstructionSet() : static_cast<GrayscaleKernels::InstructionSet>(cli.getGrayscaleKernel()));
+    ThresholdKernels::selectInstructionSet(cli.getThresholdingKernel() < 0 ? ThresholdKernels::bestInstructionSet() : static_cast<ThresholdKernels::InstructionSet>(cli.getThresholdingKernel()));
+}
+
 void BatchProcessor::processFolder(BatchProcessor::OperationType type) {
+    //OpenMP can't automatically iterate over a directory_iterator, so we collect the paths in a vector first:
+    std::vector<std::filesystem::path> files;
+    for(const auto& entry : std::filesystem::directory_iterator(cli.getInputPath())) {
+        //get the file extension
+        std::string fileExtension = entry.path().extension().string();
+
+        //add the file to the vector if it has a supported extension
+        if (EnhancerImage::extensionIsSupported(fileExtension)) files.push_back(entry.path());
+    }
+
+    processFiles(type, std::move(files));
+}
+
+void BatchProcessor::processFiles(BatchProcessor::OperationType type, std::vector<std::filesystem::path> files) {
     //create the output directory, if it doesn't already exist
     try {
         std::filesystem::path outputDir(cli.getInputPath());
@@ -31,74 +73,297 @@ void BatchProcessor::processFolder(BatchProcessor::OperationType type) {
         std::cerr << e.what() << std::endl;
     }
 
+    double startingTime = omp_get_wtime();
+    int processed = 0;
+    BufferPool::resetStatistics();
+    ThreadPool::Statistics threadPoolStatistics = ThreadPool::shared().getStatistics();
 
-    //OpenMP can't automatically iterate over a directory_iterator, so we collect the paths in a vector first:
-    std::vector<std::filesystem::path> files;
-    for(const auto& entry : std::filesystem::directory_iterator(cli.getInputPath())) {
-        //get the file extension
-        std::string fileExtension = entry.path().extension().string();
+    //the largest images are started first, so that no large scan is left for the end of the batch while the other threads are idle.
+    //directoryIndex maps the position of a file in the processing order to its position in the directory.
+    std::vector<int> directoryIndex(files.size());
+    std::iota(directoryIndex.begin(), directoryIndex.end(), 0);
+    if (cli.getLargestFirst()) {
+        directoryIndex = BatchSchedule::largestFirst(BatchSchedule::estimatePixels(files, cli.getDecodeScale()));
+        std::vector<std::filesystem::path> directoryOrder = std::move(files);
+        files.clear();
+        for (int index : directoryIndex) files.push_back(directoryOrder[index]);
+    }
+    std::vector<double> imageSeconds(files.size(), 0.0);
 
-        //add the file to the vector if it has a supported extension
-        if (EnhancerImage::extensionIsSupported(fileExtension)) files.push_back(entry.path());
+    //thresholding only needs the brightness, so colour images are decoded straight into a single luma channel (unless the user turned it off)
+    bool decodeLuma = (type == OperationType::AdaptiveThresholding) && cli.getLumaDecoding();
+    bool tiled = (type == OperationType::AdaptiveThresholding) && cli.getMemoryLimit() > 0;
+
+    //With --pipeline every step of the processing runs on threads of its own, including the reading and writing of the files.
+    //Tiled images are never read into memory as a whole, they keep streaming from their files.
+    std::vector<int> pipelineThreads = cli.getPipelineThreads();
+    bool pipelined = !pipelineThreads.empty() && !tiled;
+
+    //The number of images that are worked on at the same time: one per thread of the image loop, or of the process stage of the pipeline.
+    //The memory limit holds for the whole batch, so tiled images are binarized one at a time, and their tiles get the threads instead.
+    int imagesInFlight = pipelined ? pipelineThreads[ImagePipeline::Process] : cli.getNumberOfThreads_adaptiveThresholding();
+    if (tiled) imagesInFlight = 1;
+
+    //With --adaptiveSplit every thread gets whole images while there are at least as many images in flight as threads. After that, the
+    //images that are being worked on are split into bands, and the threads that have no image of their own help with them. The split is
+    //chosen again before every pass over an image, so a large image gets more threads as the batch empties.
+    int nrOfPoolThreads = ThreadPool::shared().nrOfWorkers() + 1;
+    std::atomic<int> unfinishedImages{static_cast<int>(files.size())};
+    std::atomic<int> passes{0}, splitPasses{0};
+    auto threadSplit = [&]() {
+        int nrOfThreads = BatchSchedule::threadsPerImage(nrOfPoolThreads, unfinishedImages, imagesInFlight);
+        passes++;
+        if (nrOfThreads > 1) splitPasses++;
+        return nrOfThreads;
+    };
+    auto threadsFor = [&](int nrOfThreads) { return cli.getAdaptiveSplit() ? threadSplit() : nrOfThreads; };
+
+    //With --ioUring the files are read and written on an I/O thread, which also reads ahead, so the prefetcher only counts hits and stalls then.
+    std::unique_ptr<AsyncFileIO> asyncIO;
+    if (cli.getIoUring() && !tiled && !pipelined) {
+        AsyncFileIO::Options ioOptions;
+        ioOptions.readAhead = std::max(cli.getPrefetchDistance(), 1);
+        ioOptions.directOutput = cli.getDirectOutput();
+        asyncIO = std::make_unique<AsyncFileIO>(files, ioOptions);
     }
 
-    double startingTime = omp_get_wtime();
-    int processed = 0;
+    //the next files are read into the page cache while the workers decode the current ones
+    FilePrefetcher prefetcher(files, (asyncIO || pipelined) ? 0 : cli.getPrefetchDistance());
 
-    //iterate through the files in the given input directory
-    //we use the dynamic schedule, because the workload is not balanced; images can have greatly different sizes / resolutions
-#pragma omp parallel for schedule(dynamic, 1) num_threads(cli.getNumberOfThreads_adaptiveThresholding())
-    for (int i = 0; i < files.size(); i++) {
-        std::filesystem::path entry = files[i];
+    //debugging information (the function only prints if the user hasn't set the --verbose flag to false)
+    //we print in a critical section, to make sure that the output is correctly displayed.
+    //printing takes very little time compared to processing so the critical section should not slow down the overall program too much.
+    auto reportResult = [&](const std::filesystem::path& newPath, bool result) {
+        unfinishedImages--;
 
-        //Load the image
-        EnhancerImage image(entry.string());
+#pragma omp critical
+        {
+            cli.printDebugInformation(std::to_string(++processed) + " / " + std::to_string(files.size()) + " ", CommandLineInterface::MessageType::Information);
+            if (result) cli.printDebugInformation(newPath.filename().string() + " has been saved successfully.\n", CommandLineInterface::MessageType::Success);
+            else cli.printDebugInformation(newPath.filename().string() + " could not be saved.\n", CommandLineInterface::MessageType::Error);
+        }
+    };
 
+    auto loadImage = [&](int index, EnhancerImage::LoadMode mode) {
+        if (!asyncIO) return EnhancerImage(files[index].string(), mode, cli.getDecodeScale());
+
+        //the file has usually been read already, while the previous images were processed
+        //a file that couldn't be read gives an empty image, like one that can't be decoded
+        AsyncFileIO::InputFile input = asyncIO->takeInput(index);
+        EnhancerImage image(input.ok ? input.data : nullptr, input.ok ? input.size : 0, mode, cli.getDecodeScale());
+        AsyncFileIO::releaseInput(input);
+        return image;
+    };
+
+    //Processes a loaded image and chooses the path and the file type of the result.
+    auto processImage = [&](EnhancerImage& image, const std::filesystem::path& entry, std::filesystem::path& newPath, EnhancerImage::Filetype& outputType) {
         std::string newFilename;
+        outputType = EnhancerImage::jpg;
 
         switch (type) {
             case OperationType::AdaptiveThresholding:
                 //Apply the adaptive thresholding method to make the image more readable
-                image.applyAdaptiveThresholding(cli.getNumberOfThreads_grayscaleConversion(), cli.getWindowWidth(), cli.getThresholdPercentage());
-                newFilename = entry.stem().string()+"_binarized.jpg";
+                if (cli.getStreamingThresholding()) image.applyAdaptiveThresholding_streaming(cli.getWindowWidth(), cli.getThresholdPercentage(), cli.getPackedOutput());
+                else {
+                    EnhancerImage::ThresholdingOptions options = thresholdingOptions();
+                    if (cli.getAdaptiveSplit()) options.threadSplit = threadSplit;
+                    image.applyAdaptiveThresholding(cli.getNumberOfThreads_grayscaleConversion(), cli.getNumberOfThreads_thresholding(), cli.getWindowWidth(), cli.getThresholdPercentage(), options);
+                }
+
+                //1 bit per pixel images are saved as 1-bit PNGs, they would have to be expanded for JPEG.
+                outputType = image.isBilevel() ? EnhancerImage::png : EnhancerImage::jpg;
+                newFilename = entry.stem().string() + (image.isBilevel() ? "_binarized.png" : "_binarized.jpg");
                 break;
 
             case OperationType::GrayscaleConversion:
-                image.convertToGrayscale(cli.getNumberOfThreads_grayscaleConversion());
+                if (cli.getInPlace()) image.convertToGrayscale_inPlace(threadsFor(cli.getNumberOfThreads_grayscaleConversion()), true);
+                else image.convertToGrayscale(threadsFor(cli.getNumberOfThreads_grayscaleConversion()));
                 newFilename = entry.stem().string()+"_grayscale.jpg";
                 break;
         }
 
-        //Save the processed image back to the disk
-        std::filesystem::path newPath(cli.getInputPath());
+        newPath = cli.getInputPath();
         newPath = newPath / cli.getOutputDirectory() / newFilename;  //the "/" operator of the filesystem library uses the correct separator acc. to the OS ("/" on linux "\" on windows)
-        int result = image.saveImage(newPath.string(), EnhancerImage::jpg);
+        return true;
+    };
 
-        //debugging information (the function only prints if the user hasn't set the --verbose flag to false)
-        //we print in a critical section, to make sure that the output is correctly displayed.
-        //printing takes very little time compared to processing so the critical section should not slow down the overall program too much.
-#pragma omp critical
-        {
-            cli.printDebugInformation(std::to_string(++processed) + " / " + std::to_string(files.size()) + " ", CommandLineInterface::MessageType::Information);
-            if (result) cli.printDebugInformation(newPath.filename().string() + " has been saved successfully.\n", CommandLineInterface::MessageType::Success);
-            else cli.printDebugInformation(newPath.filename().string() + " could not be saved.\n", CommandLineInterface::MessageType::Error);
-        }
+    std::unique_ptr<ImagePipeline> pipeline;
+    if (pipelined) {
+        ImagePipeline::Options pipelineOptions;
+        std::copy(pipelineThreads.begin(), pipelineThreads.end(), pipelineOptions.threads);
+        pipelineOptions.queueDepth = cli.getQueueDepth();
+        pipelineOptions.loadMode = decodeLuma ? EnhancerImage::Luma : EnhancerImage::Original;
+        pipelineOptions.decodeScale = cli.getDecodeScale();
+
+        pipeline = std::make_unique<ImagePipeline>(pipelineOptions, processImage, [&](const std::filesystem::path& input, const std::filesystem::path& output, bool success) {
+            reportResult(output.empty() ? input : output, success);
+        });
+        pipeline->run(files);
     }
+    else {
+        //iterate through the files in the given input directory
+        //we use the dynamic schedule, because the workload is not balanced; images can have greatly different sizes / resolutions.
+        //The images and the bands inside them are tasks of the same thread pool, so the nested parallelism doesn't start any threads.
+        ThreadPool::shared().parallelForDynamic(0, static_cast<int>(files.size()), imagesInFlight, [&](int i, int) {
+            std::filesystem::path entry = files[i];
+            double imageStartingTime = omp_get_wtime();
+            prefetcher.startFile(i);
+
+            //with a memory limit the image is never loaded as a whole: it goes through the tiled thresholder straight into a 1-bit PNG file
+            if (tiled) {
+                std::filesystem::path newPath(cli.getInputPath());
+                newPath = newPath / cli.getOutputDirectory() / (entry.stem().string() + "_binarized.png");
+                bool result = EnhancerImage::binarizeTiled(entry.string(), newPath.string(), decodeLuma ? EnhancerImage::Luma : EnhancerImage::Original, cli.getDecodeScale(),
+                                                           cli.getWindowWidth(), cli.getThresholdPercentage(), static_cast<size_t>(cli.getMemoryLimit()) * 1024 * 1024, threadsFor(cli.getNumberOfThreads_thresholding()),
+                                                           cli.getTileSize());
+                reportResult(newPath, result);
+                imageSeconds[i] = omp_get_wtime() - imageStartingTime;
+                return;
+            }
+
+            //Load the image
+            EnhancerImage image = loadImage(i, decodeLuma ? EnhancerImage::Luma : EnhancerImage::Original);
+
+            //as in the pipeline, an image that couldn't be loaded is reported under the path of the input and not processed
+            if (image.getData() == nullptr) {
+                reportResult(entry, false);
+                imageSeconds[i] = omp_get_wtime() - imageStartingTime;
+                return;
+            }
+
+            std::filesystem::path newPath;
+            EnhancerImage::Filetype outputType;
+            processImage(image, entry, newPath, outputType);
+
+            //Save the processed image back to the disk
+            if (asyncIO) {
+                //the file is written on the I/O thread, which reports it once it is closed
+                std::vector<unsigned char> encoded;
+                if (image.encodeImage(outputType, encoded)) asyncIO->writeOutput(newPath.string(), std::move(encoded), [&reportResult, newPath](bool success) { reportResult(newPath, success); });
+                else reportResult(newPath, false);
+            }
+            else {
+                reportResult(newPath, image.saveImage(newPath.string(), outputType));
+            }
+            imageSeconds[i] = omp_get_wtime() - imageStartingTime;
+        });
+    }
+
+    if (asyncIO) asyncIO->finish();
 
     double runtime = omp_get_wtime() - startingTime;
 
     std::cout << "Finished processing in " << runtime << " seconds" << std::endl;
+
+    //the measured times of the images, replayed in the order of the directory, show how long the batch would have taken without sorting
+    if (!pipeline && cli.getLargestFirst() && files.size() > 1) {
+        std::vector<double> durations(files.size());
+        for (size_t i = 0; i < files.size(); i++) durations[directoryIndex[i]] = imageSeconds[i];
+        std::vector<int> directoryOrder(files.size());
+        std::iota(directoryOrder.begin(), directoryOrder.end(), 0);
+
+        int nrOfThreads = std::min(imagesInFlight, ThreadPool::shared().nrOfWorkers() + 1);
+        std::ostringstream line;
+        line << "Largest first: makespan " << BatchSchedule::makespan(durations, directoryIndex, nrOfThreads) << " seconds instead of "
+             << BatchSchedule::makespan(durations, directoryOrder, nrOfThreads) << " seconds in directory order (replayed from the image times on " << nrOfThreads << " threads)\n";
+        cli.printDebugInformation(line.str(), CommandLineInterface::MessageType::Information);
+    }
+
+    //the passes that were split are the ones that ran while there were fewer images left than threads
+    if (cli.getAdaptiveSplit()) {
+        cli.printDebugInformation("Adaptive split: " + std::to_string(splitPasses) + " of " + std::to_string(passes) + " passes over the images were split into bands for "
+                                  + std::to_string(nrOfPoolThreads) + " threads\n", CommandLineInterface::MessageType::Information);
+    }
+
+    //the busiest stage limits the throughput of the pipeline, full queues in front of it show where the images pile up
+    if (pipeline) {
+        for (int stage = 0; stage < ImagePipeline::nrOfStages; stage++) {
+            ImagePipeline::StageStatistics stageStatistics = pipeline->getStageStatistics(static_cast<ImagePipeline::Stage>(stage));
+            std::string line = std::string("Pipeline ") + ImagePipeline::name(static_cast<ImagePipeline::Stage>(stage)) + ": " + std::to_string(stageStatistics.threads) + " threads, "
+                               + std::to_string(static_cast<int>(stageStatistics.utilization * 100 + 0.5)) + "% busy";
+
+            if (stage < ImagePipeline::nrOfStages - 1) {
+                BoundedQueueStatistics queueStatistics = pipeline->getQueueStatistics(static_cast<ImagePipeline::Stage>(stage));
+                std::ostringstream averageDepth;
+                averageDepth.precision(2);
+                averageDepth << std::fixed << queueStatistics.averageDepth;
+                line += "; queue behind it: " + averageDepth.str() + " of " + std::to_string(queueStatistics.capacity) + " images on average, at most "
+                        + std::to_string(queueStatistics.maxDepth) + ", " + std::to_string(queueStatistics.fullWaits) + " waits on a full queue";
+            }
+            cli.printDebugInformation(line + "\n", CommandLineInterface::MessageType::Information);
+        }
+    }
+
+    //a stall means that a worker had to wait for (a part of) its file to be read from the disk; the pipeline reads its files in a stage of its own
+    prefetcher.stop();
+    if (!pipeline) {
+        FilePrefetcher::Statistics prefetchStatistics = prefetcher.getStatistics();
+        cli.printDebugInformation("Prefetcher: " + std::to_string(prefetchStatistics.hits) + " hits, " + std::to_string(prefetchStatistics.stalls) + " stalls, "
+                                  + std::to_string(prefetchStatistics.prefetched) + " files prefetched\n", CommandLineInterface::MessageType::Information);
+    }
+
+    //with io_uring the opens, reads, writes and closes of many files share a submission
+    if (asyncIO) {
+        AsyncFileIO::Statistics ioStatistics = asyncIO->getStatistics();
+        cli.printDebugInformation(std::string("I/O backend: ") + (asyncIO->usesIoUring() ? "io_uring, " : "blocking calls on the I/O thread, ") + std::to_string(ioStatistics.filesRead) + " files read, "
+                                  + std::to_string(ioStatistics.filesWritten) + " written, " + std::to_string(ioStatistics.operations) + " operations in " + std::to_string(ioStatistics.submissions) + " submissions\n",
+                                  CommandLineInterface::MessageType::Information);
+    }
+
+    //every worker keeps the buffers of its previous image, so only the first images of a thread (and larger ones) need fresh memory
+    BufferPool::Statistics poolStatistics = BufferPool::getStatistics();
+    cli.printDebugInformation("Buffer pool: " + std::to_string(poolStatistics.reuses) + " of " + std::to_string(poolStatistics.requests) + " buffers reused, "
+                              + std::to_string(poolStatistics.bytesAllocated / (1024 * 1024)) + " MB freshly allocated\n", CommandLineInterface::MessageType::Information);
+
+    //the images and their bands share the threads of the pool, idle threads steal the tasks of the busy ones
+    ThreadPool::Statistics threadPoolStatisticsAfter = ThreadPool::shared().getStatistics();
+    cli.printDebugInformation("Thread pool: " + std::to_string(ThreadPool::shared().nrOfWorkers() + 1) + " threads, " + std::to_string(threadPoolStatisticsAfter.tasks - threadPoolStatistics.tasks) + " tasks shared, "
+                              + std::to_string(threadPoolStatisticsAfter.steals - threadPoolStatistics.steals) + " stolen\n", CommandLineInterface::MessageType::Information);
 }
 
 
+EnhancerImage::ThresholdingOptions BatchProcessor::thresholdingOptions() {
+    EnhancerImage::ThresholdingOptions options;
+    options.fuseGrayscaleAndIntegral = cli.getFuseGrayscaleAndIntegral();
+    options.packedOutput = cli.getPackedOutput();
+    options.inPlace = cli.getInPlace();
+    options.shrinkBuffer = cli.getInPlace();
+
+    switch (cli.getIntegralWidth()) {
+        case 32:
+            options.integralWidth = EnhancerImage::IntegralWidth::Bits32;
+            break;
+
+        case 64:
+            options.integralWidth = EnhancerImage::IntegralWidth::Bits64;
+            break;
+
+        default:
+            options.integralWidth = EnhancerImage::IntegralWidth::Automatic;
+            break;
+    }
+
+    return options;
+}
+
 void BatchProcessor::benchmark_nrOfThreads() {
     std::ofstream csvFile_grayscale{"threads_benchmark_grayscaleconversion.csv"};
     std::ofstream csvFile_adaptive{"threads_benchmark_adaptivethresholding.csv"};
     std::ofstream csvFile_grayscaleandadaptive{"threads_benchmark_allparallelized.csv"};
+    std::ofstream csvFile_integral{"threads_benchmark_integralimage.csv"};
+    std::ofstream csvFile_thresholding{"threads_benchmark_thresholding.csv"};
+    std::ofstream csvFile_fused{"threads_benchmark_fusedgrayscaleintegral.csv"};
+    std::ofstream csvFile_integralWidth{"threads_benchmark_integralwidth.csv"};
+    std::ofstream csvFile_decodeScale{"threads_benchmark_decodescale.csv"};
 
     csvFile_grayscale << "number_of_threads, runtime_in_seconds\n";
     csvFile_adaptive << "number_of_threads, runtime_in_seconds\n";
     csvFile_grayscaleandadaptive << "number_of_threads, runtime_in_seconds\n";
+    csvFile_integral << "number_of_threads, runtime_in_seconds\n";
+    csvFile_thresholding << "number_of_threads, runtime_in_seconds\n";
+    csvFile_fused << "number_of_threads, separate_runtime_in_seconds, fused_runtime_in_seconds\n";
+    csvFile_integralWidth << "number_of_threads, runtime_64bit_in_seconds, runtime_32bit_in_seconds, speedup, integral_memory_64bit_in_bytes, integral_memory_32bit_in_bytes\n";
+    csvFile_decodeScale << "decode_scale, runtime_in_seconds, decoded_pixels\n";
 
     int nrOfThreads_max = omp_get_num_procs() * 2;     //we use up to 2 times the amount of the logical cores, to show the performance effects.
     std::string originalOutputDirectory = cli.getOutputDirectory();
@@ -106,6 +371,10 @@ void BatchProcessor::benchmark_nrOfThreads() {
     //Surpress output (we will be running the benchmarks many times)
     cli.setVerbose(false);
 
+    //the benchmarks compare the numbers of threads, so they aren't chosen per image
+    bool adaptiveSplit = cli.getAdaptiveSplit();
+    cli.setAdaptiveSplit(false);
+
     std::cout << termcolor::green << "Starting benchmark 1: Parallelized grayscale conversion only" << termcolor::reset << std::endl;
     cli.setOutputDirectory(originalOutputDirectory + "_parallelGrayscale_benchmark");
     cli.setNumberOfThreads_adaptiveThresholding(1);  //we want the files to be processed one-by-one in this benchmark
@@ -144,7 +413,285 @@ void BatchProcessor::benchmark_nrOfThreads() {
         csvFile_grayscaleandadaptive << i << ", " << runtime << "\n";
     }
 
+    std::cout << termcolor::green << "Starting benchmark 4: Parallelized integral image construction" << termcolor::reset << std::endl;
+    //only the construction of the integral image is timed here, loading and grayscale conversion are excluded.
+    std::vector<std::filesystem::path> files;
+    for(const auto& entry : std::filesystem::directory_iterator(cli.getInputPath())) {
+        if (EnhancerImage::extensionIsSupported(entry.path().extension().string())) files.push_back(entry.path());
+    }
+    for(int i = 1; i < nrOfThreads_max; i++) {
+        double runtime = 0;
+
+        for (const auto& file : files) {
+            EnhancerImage image(file.string());
+            if (image.nrOfChannels > 1) image.convertToGrayscale(1);
+
+            auto *integralImage = new uint64_t [static_cast<size_t>(image.width) * image.height];
+
+            double startingTime = omp_get_wtime();
+            EnhancerImage::buildIntegralImage(image.view(), integralImage, i);
+            runtime += omp_get_wtime() - startingTime;
+
+            delete[] integralImage;
+        }
+
+        csvFile_integral << i << ", " << runtime << "\n";
+    }
+
+    std::cout << termcolor::green << "Starting benchmark 5: Parallelized thresholding pass, files processed one-by-one" << termcolor::reset << std::endl;
+    cli.setOutputDirectory(originalOutputDirectory + "_parallelThresholding_benchmark");
+    cli.setNumberOfThreads_adaptiveThresholding(1);
+    cli.setNumberOfThreads_grayscaleConversion(1);
+    for(int i = 1; i < nrOfThreads_max; i++) {
+        cli.setNumberOfThreads_thresholding(i);
+
+        double startingTime = omp_get_wtime();
+        processFolder(OperationType::AdaptiveThresholding);
+        double runtime = omp_get_wtime() - startingTime;
+
+        csvFile_thresholding << i << ", " << runtime << "\n";
+    }
+    cli.setNumberOfThreads_thresholding(1);
+
+    std::cout << termcolor::green << "Starting benchmark 6: Grayscale conversion + integral image, two separate passes vs. one fused pass" << termcolor::reset << std::endl;
+    //only the two stages are timed, including the allocation of the grayscale buffer that both paths need.
+    for(int i = 1; i < nrOfThreads_max; i++) {
+        double runtime_separate = 0, runtime_fused = 0;
+
+        for (const auto& file : files) {
+            EnhancerImage separate(file.string());
+            if (separate.nrOfChannels < 3) continue;
+            auto *integralImage = new uint64_t [static_cast<size_t>(separate.width) * separate.height];
+
+            double startingTime = omp_get_wtime();
+            separate.convertToGrayscale(i);
+            EnhancerImage::buildIntegralImage(separate.view(), integralImage, i);
+            runtime_separate += omp_get_wtime() - startingTime;
+
+            EnhancerImage fused(file.string());
+
+            startingTime = omp_get_wtime();
+            EnhancerImage grayscale(fused.width, fused.height, 1);
+            EnhancerImage::buildGrayscaleAndIntegralImage(fused.view(), grayscale.view(), integralImage, i);
+            runtime_fused += omp_get_wtime() - startingTime;
+
+            delete[] integralImage;
+        }
+
+        csvFile_fused << i << ", " << runtime_separate << ", " << runtime_fused << "\n";
+    }
+
+    std::cout << termcolor::green << "Starting benchmark 7: Adaptive thresholding with a 64-bit vs. a 32-bit integral image" << termcolor::reset << std::endl;
+    //loading is excluded, both runs use the same number of threads for every stage.
+    int halfWindow_max = 0;
+    for(int i = 1; i < nrOfThreads_max; i++) {
+        double runtime_64 = 0, runtime_32 = 0;
+        size_t memory_64 = 0, memory_32 = 0;
+
+        for (const auto& file : files) {
+            for (auto width : {EnhancerImage::IntegralWidth::Bits64, EnhancerImage::IntegralWidth::Bits32}) {
+                EnhancerImage image(file.string());
+                size_t nrOfPixels = static_cast<size_t>(image.width) * image.height;
+                int halfWindow = static_cast<int>(image.width * cli.getWindowWidth()) / 2;
+                bool uses32Bits = (width == EnhancerImage::IntegralWidth::Bits32) && EnhancerImage::integralFitsIn32Bits(halfWindow);
+                if (halfWindow > halfWindow_max) halfWindow_max = halfWindow;
+
+                EnhancerImage::ThresholdingOptions options = thresholdingOptions();
+                options.integralWidth = width;
+
+                double startingTime = omp_get_wtime();
+                image.applyAdaptiveThresholding(i, i, cli.getWindowWidth(), cli.getThresholdPercentage(), options);
+                double runtime = omp_get_wtime() - startingTime;
+
+                if (width == EnhancerImage::IntegralWidth::Bits64) {
+                    runtime_64 += runtime;
+                    memory_64 += nrOfPixels * sizeof(uint64_t);
+                }
+                else {
+                    runtime_32 += runtime;
+                    memory_32 += nrOfPixels * (uses32Bits ? sizeof(uint32_t) : sizeof(uint64_t));
+                }
+            }
+        }
+
+        csvFile_integralWidth << i << ", " << runtime_64 << ", " << runtime_32 << ", " << (runtime_32 > 0 ? runtime_64 / runtime_32 : 0) << ", " << memory_64 << ", " << memory_32 << "\n";
+
+        if (i == 1) {
+            std::cout << "32-bit integral images saved " << (memory_64 - memory_32) / (1024.0 * 1024.0) << " MB over all images, single-threaded speedup: " << (runtime_32 > 0 ? runtime_64 / runtime_32 : 0) << "x" << std::endl;
+        }
+    }
+    if (!EnhancerImage::integralFitsIn32Bits(halfWindow_max)) {
+        std::cout << termcolor::yellow << "Some windows were too large for a 32-bit integral image, those images used the 64-bit version in both runs." << termcolor::reset << std::endl;
+    }
+
+    std::cout << termcolor::green << "Starting benchmark 8: Decoding the images at 1, 1/2, 1/4 and 1/8 scale" << termcolor::reset << std::endl;
+    //only the loading is timed, on a single thread. Only JPEG files are decoded at a reduced size, so the other files are skipped.
+    for (int scale : {1, 2, 4, 8}) {
+        double runtime = 0;
+        size_t decodedPixels = 0;
+
+        for (const auto& file : files) {
+            std::string extension = file.extension().string();
+            std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c){ return std::tolower(c); });
+            if (extension != ".jpg") continue;
+
+            double startingTime = omp_get_wtime();
+            EnhancerImage image(file.string(), EnhancerImage::Original, scale);
+            runtime += omp_get_wtime() - startingTime;
+
+            decodedPixels += static_cast<size_t>(image.width) * image.height;
+        }
+
+        csvFile_decodeScale << "1/" << scale << ", " << runtime << ", " << decodedPixels << "\n";
+    }
+
     cli.setOutputDirectory(originalOutputDirectory);
+    cli.setAdaptiveSplit(adaptiveSplit);
 
     std::cout << termcolor::green << "Benchmarks are completed" << termcolor::reset << std::endl;
-}
\ No newline at end of file
+}
+
+void BatchProcessor::tune() {
+    std::vector<std::filesystem::path> files;
+    for(const auto& entry : std::filesystem::directory_iterator(cli.getInputPath())) {
+        if (EnhancerImage::extensionIsSupported(entry.path().extension().string())) files.push_back(entry.path());
+    }
+    if (files.empty()) {
+        std::cout << termcolor::red << "There are no images in the input folder to tune the settings with." << termcolor::reset << std::endl;
+        return;
+    }
+
+    //a few images with the same mix of sizes as the folder keep the sweep short
+    std::vector<std::filesystem::path> sample;
+    for (int index : TuningProfile::sample(BatchSchedule::estimatePixels(files, cli.getDecodeScale()), 8)) sample.push_back(files[index]);
+
+    std::string originalOutputDirectory = cli.getOutputDirectory();
+    cli.setOutputDirectory(originalOutputDirectory + "_tune");
+
+    //Surpress output (the sample is processed many times)
+    cli.setVerbose(false);
+
+    //the faster of two runs, the first run of a setting also fills the page cache and the buffer pool
+    auto measure = [&]() {
+        double fastest = 0;
+        for (int run = 0; run < 2; run++) {
+            double startingTime = omp_get_wtime();
+            processFiles(OperationType::AdaptiveThresholding, sample);
+            double runtime = omp_get_wtime() - startingTime;
+            if (run == 0 || runtime < fastest) fastest = runtime;
+        }
+        return fastest;
+    };
+
+    //Tries the values of one setting with the fastest values of the settings before it, and keeps the fastest one. The current value
+    //comes first, and another one has to be at least 2% faster to replace it: smaller differences are within the noise of the runs.
+    auto sweep = [&](const std::string& setting, const std::vector<std::string>& candidates, const std::function<void(size_t)>& apply) {
+        std::cout << termcolor::green << "Tuning the " << setting << termcolor::reset << std::endl;
+
+        size_t fastest = 0;
+        double fastestRuntime = 0;
+        for (size_t candidate = 0; candidate < candidates.size(); candidate++) {
+            apply(candidate);
+            double runtime = measure();
+            std::cout << "  " << candidates[candidate] << ": " << runtime << " seconds" << std::endl;
+
+            if (candidate == 0 || runtime < fastestRuntime * 0.98) {
+                fastest = candidate;
+                fastestRuntime = runtime;
+            }
+        }
+
+        apply(fastest);
+        std::cout << "  fastest: " << candidates[fastest] << std::endl;
+        return fastestRuntime;
+    };
+
+    std::cout << termcolor::green << "Tuning the settings on " << sample.size() << " of the " << files.size() << " images" << termcolor::reset << std::endl;
+    double startingRuntime = measure();
+    double runtime = startingRuntime;
+
+    //the threads: first the number of images that are processed at the same time, then how the threads are split inside an image
+    int nrOfCores = omp_get_num_procs();
+    std::vector<int> threadCounts{nrOfCores};
+    for (int nrOfThreads = 1; nrOfThreads < nrOfCores; nrOfThreads *= 2) threadCounts.push_back(nrOfThreads);
+
+    std::vector<std::string> labels;
+    for (int nrOfThreads : threadCounts) labels.push_back(std::to_string(nrOfThreads) + " images at a time");
+    cli.setAdaptiveSplit(true);
+    runtime = sweep("number of images at a time", labels, [&](size_t candidate) { cli.setNumberOfThreads_adaptiveThresholding(threadCounts[candidate]); });
+
+    std::vector<int> splits;
+    for (int nrOfThreads : {1, 2, nrOfCores}) {
+        if (std::find(splits.begin(), splits.end(), nrOfThreads) == splits.end() && nrOfThreads <= nrOfCores) splits.push_back(nrOfThreads);
+    }
+    labels = {"chosen from the images left"};
+    for (int nrOfThreads : splits) labels.push_back(std::to_string(nrOfThreads) + " threads per image");
+    //with the adaptive split the fixed numbers go back to their default, which is what a later --adaptiveSplit false falls back to
+    runtime = sweep("thread split inside the images", labels, [&](size_t candidate) {
+        cli.setAdaptiveSplit(candidate == 0);
+        cli.setNumberOfThreads_grayscaleConversion(candidate == 0 ? 1 : splits[candidate - 1]);
+        cli.setNumberOfThreads_thresholding(candidate == 0 ? 1 : splits[candidate - 1]);
+    });
+
+    //the variants of the adaptive thresholding, which all give the same pixels
+    std::vector<int> integralWidths{cli.getIntegralWidth(), cli.getIntegralWidth() == 64 ? 0 : 64};
+    runtime = sweep("integral image width", {integralWidths[0] == 0 ? "auto" : std::to_string(integralWidths[0]), integralWidths[1] == 0 ? "auto" : "64"},
+                    [&](size_t candidate) { cli.setIntegralWidth(integralWidths[candidate]); });
+
+    bool fuse = cli.getFuseGrayscaleAndIntegral();
+    runtime = sweep("fused grayscale conversion and integral image", {fuse ? "fused" : "separate", fuse ? "separate" : "fused"},
+                    [&](size_t candidate) { cli.setFuseGrayscaleAndIntegral((candidate == 0) == fuse); });
+
+    bool inPlace = cli.getInPlace();
+    runtime = sweep("in-place processing", {inPlace ? "in place" : "new buffers", inPlace ? "new buffers" : "in place"},
+                    [&](size_t candidate) { cli.setInPlace((candidate == 0) == inPlace); });
+
+    bool streaming = cli.getStreamingThresholding();
+    runtime = sweep("streaming thresholding", {streaming ? "streaming" : "integral image", streaming ? "integral image" : "streaming"},
+                    [&](size_t candidate) { cli.setStreamingThresholding((candidate == 0) == streaming); });
+
+    //the SIMD kernels, "auto" is the best instruction set of the CPU and stays that way if the profile is used on another CPU
+    std::vector<int> grayscaleKernels{-1};
+    labels = {std::string("auto (") + GrayscaleKernels::name(GrayscaleKernels::bestInstructionSet()) + ")"};
+    for (auto instructionSet : {GrayscaleKernels::Scalar, GrayscaleKernels::SSSE3, GrayscaleKernels::AVX2, GrayscaleKernels::AVX512}) {
+        if (!GrayscaleKernels::isSupported(instructionSet) || instructionSet == GrayscaleKernels::bestInstructionSet()) continue;
+        grayscaleKernels.push_back(instructionSet);
+        labels.push_back(GrayscaleKernels::name(instructionSet));
+    }
+    runtime = sweep("grayscale conversion kernel", labels, [&](size_t candidate) {
+        cli.setGrayscaleKernel(grayscaleKernels[candidate]);
+        selectKernels();
+    });
+
+    std::vector<int> thresholdingKernels{-1};
+    labels = {std::string("auto (") + ThresholdKernels::name(ThresholdKernels::bestInstructionSet()) + ")"};
+    for (auto instructionSet : {ThresholdKernels::Scalar, ThresholdKernels::AVX2}) {
+        if (!ThresholdKernels::isSupported(instructionSet) || instructionSet == ThresholdKernels::bestInstructionSet()) continue;
+        thresholdingKernels.push_back(instructionSet);
+        labels.push_back(ThresholdKernels::name(instructionSet));
+    }
+    runtime = sweep("thresholding kernel", labels, [&](size_t candidate) {
+        cli.setThresholdingKernel(thresholdingKernels[candidate]);
+        selectKernels();
+    });
+
+    //the tiles are only used with a memory limit
+    if (cli.getMemoryLimit() > 0) {
+        std::vector<int> tileSizes{0, 1024, 512, 256};
+        runtime = sweep("tile size", {"as large as the memory limit allows", "1024 pixels", "512 pixels", "256 pixels"},
+                        [&](size_t candidate) { cli.setTileSize(tileSizes[candidate]); });
+    }
+
+    cli.setOutputDirectory(originalOutputDirectory);
+
+    std::ostringstream summary;
+    summary << "The sample of " << sample.size() << " images took " << runtime << " seconds with these settings, " << startingRuntime << " seconds with the settings the tuning started from";
+    if (cli.saveProfile({"The fastest settings for this machine, found by enhancer --tune on " + cli.getInputPath(), summary.str(),
+                         "The arguments on the command line override these, --profile none ignores them"})) {
+        std::cout << termcolor::green << "Saved the fastest settings to " << cli.getProfilePath() << termcolor::reset << std::endl;
+    }
+    else {
+        std::cout << termcolor::red << "The settings could not be saved to " << cli.getProfilePath() << termcolor::reset << std::endl;
+    }
+    std::cout << summary.str() << std::endl;
+}
@@ -1,7 +1,11 @@
 #ifndef ENHANCER_BATCHPROCESSOR_H
 #define ENHANCER_BATCHPROCESSOR_H
 
+#include <vector>
+#include <filesystem>
+
 #include "CommandLineInterface.h"
+#include "EnhancerImage.h"
 
 /*
     This class takes a CommandLineInterface instance in its constructor, and uses the user inputs
@@ -17,9 +21,20 @@ public:
 
     void benchmark_nrOfThreads();
 
+    //Tries the settings that don't change the results one after the other on a sample of the input folder, keeps the fastest value
+    //of each, and saves them to the profile of the CommandLineInterface.
+    void tune();
+
 private:
     enum OperationType {GrayscaleConversion, AdaptiveThresholding};
     void processFolder(BatchProcessor::OperationType type);
+    void processFiles(BatchProcessor::OperationType type, std::vector<std::filesystem::path> files);
+
+    //Makes the kernels use the instruction sets chosen with --grayscaleKernel and --thresholdingKernel (the best ones of the CPU by default).
+    void selectKernels();
+
+    //Collects the implementation choices of the user (--fuseGrayscaleAndIntegral, --integralWidth, --packedOutput) for EnhancerImage.
+    EnhancerImage::ThresholdingOptions thresholdingOptions();
     CommandLineInterface& cli;
 };
 
@@ -0,0 +1,64 @@
+#include <algorithm>
+#include <numeric>
+#include <queue>
+#include <functional>
+#include <string>
+
+#include "BatchSchedule.h"
+#include "stb_image.h"
+
+std::vector<uint64_t> BatchSchedule::estimatePixels(const std::vector<std::filesystem::path>& files, int decodeScale) {
+    std::vector<uint64_t> pixels(files.size(), 0);
+
+    for (size_t i = 0; i < files.size(); i++) {
+        int width, height, nrOfChannels;
+        if (!stbi_info(files[i].string().c_str(), &width, &height, &nrOfChannels)) continue;
+
+        //the header holds the full size, JPEG files shrink while they are decoded (rounded up like the decoder does)
+        std::string extension = files[i].extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c){ return std::tolower(c); });
+        if (extension == ".jpg" && decodeScale > 1) {
+            width = (width + decodeScale - 1) / decodeScale;
+            height = (height + decodeScale - 1) / decodeScale;
+        }
+
+        pixels[i] = static_cast<uint64_t>(width) * static_cast<uint64_t>(height);
+    }
+
+    return pixels;
+}
+
+std::vector<int> BatchSchedule::largestFirst(const std::vector<uint64_t>& costs) {
+    std::vector<int> order(costs.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&costs](int a, int b) { return costs[a] > costs[b]; });
+    return order;
+}
+
+double BatchSchedule::makespan(const std::vector<double>& durations, const std::vector<int>& order, int nrOfThreads) {
+    if (order.empty()) return 0.0;
+    nrOfThreads = std::max(std::min(nrOfThreads, static_cast<int>(order.size())), 1);
+
+    //the times at which the threads are free again, the earliest one takes the next image
+    std::priority_queue<double, std::vector<double>, std::greater<double>> freeAt;
+    for (int thread = 0; thread < nrOfThreads; thread++) freeAt.push(0.0);
+
+    double end = 0.0;
+    for (int image : order) {
+        double start = freeAt.top();
+        freeAt.pop();
+        freeAt.push(start + durations[image]);
+        end = std::max(end, start + durations[image]);
+    }
+
+    return end;
+}
+
+int BatchSchedule::threadsPerImage(int nrOfThreads, int unfinishedImages, int imagesInFlight) {
+    //the images that are still waiting for a thread of the image loop don't keep any thread busy
+    if (imagesInFlight > 0) unfinishedImages = std::min(unfinishedImages, imagesInFlight);
+    if (unfinishedImages < 1) return std::max(nrOfThreads, 1);
+
+    //rounded up: a few bands more than threads are shared out by the thread pool, a thread without a band would stay idle
+    return std::max((nrOfThreads + unfinishedImages - 1) / unfinishedImages, 1);
+}
@@ -0,0 +1,37 @@
+#ifndef ENHANCER_BATCHSCHEDULE_H
+#define ENHANCER_BATCHSCHEDULE_H
+
+#include <vector>
+#include <filesystem>
+#include <cstdint>
+
+/*
+    The order in which the images of a batch are handed to the threads.
+
+    The images are taken by whichever thread is free next, so a large scan that comes last in the directory keeps one thread busy
+    while all the others wait. Starting the largest images first (longest processing time first) leaves the small ones to fill the gaps
+    at the end. The size of an image is estimated from its number of pixels, which stb reads from the header of the file without decoding it.
+    Once fewer images are in flight than there are threads, these images are split into bands instead (see threadsPerImage).
+*/
+
+class BatchSchedule {
+public:
+    //The number of pixels every file is decoded to, read from the file headers (JPEG files are decoded at 1/decodeScale of their size).
+    //Files whose header can't be read are estimated as 0 pixels.
+    static std::vector<uint64_t> estimatePixels(const std::vector<std::filesystem::path>& files, int decodeScale);
+
+    //The indices of the costs from the largest to the smallest cost; equal costs keep their order.
+    static std::vector<int> largestFirst(const std::vector<uint64_t>& costs);
+
+    //The time until the last image is done, if the images are taken in the given order by nrOfThreads threads that each take the next
+    //image as soon as they are free, with durations[i] being the time image i takes.
+    static double makespan(const std::vector<double>& durations, const std::vector<int>& order, int nrOfThreads);
+
+    //The number of threads an image gets when nrOfThreads threads work on a batch with unfinishedImages images that aren't done yet, of which
+    //at most imagesInFlight are worked on at the same time (e.g. --numberOfThreads_adaptiveThresholding): one while there is an image for
+    //every thread, and then an equal share of the threads that have no image of their own, so that the images in flight are split into bands
+    //instead of leaving the threads idle.
+    static int threadsPerImage(int nrOfThreads, int unfinishedImages, int imagesInFlight);
+};
+
+#endif //ENHANCER_BATCHSCHEDULE_H
@@ -0,0 +1,61 @@
+#include "BilevelImage.h"
+#include "BilevelPNGWriter.h"
+
+BilevelImage::BilevelImage(int width, int height) : width(width), height(height) {
+    wordsPerRow = (static_cast<size_t>(width) + 63) / 64;
+    words.assign(wordsPerRow * height, 0);
+}
+
+uint64_t* BilevelImage::row(int y) {
+    return words.data() + static_cast<size_t>(y) * wordsPerRow;
+}
+
+const uint64_t* BilevelImage::row(int y) const {
+    return words.data() + static_cast<size_t>(y) * wordsPerRow;
+}
+
+bool BilevelImage::getPixel(int x, int y) const {
+    return (row(y)[x / 64] >> (63 - x % 64)) & 1;
+}
+
+void BilevelImage::packRow(int y, const unsigned char* pixels) {
+    uint64_t* destination = row(y);
+    uint64_t word = 0;
+
+    for (int x = 0; x < width; x++) {
+        word = (word << 1) | (pixels[x] != 0);
+        if (x % 64 == 63) {
+            destination[x / 64] = word;
+            word = 0;
+        }
+    }
+
+    //move the last, partially filled word to the top bits
+    if (width % 64 != 0) destination[width / 64] = word << (64 - width % 64);
+}
+
+void BilevelImage::unpackRow(int y, unsigned char* pixels) const {
+    const uint64_t* source = row(y);
+
+    for (int x = 0; x < width; x++) {
+        pixels[x] = ((source[x / 64] >> (63 - x % 64)) & 1) ? 255 : 0;
+    }
+}
+
+size_t BilevelImage::getMemoryUsage() const {
+    return words.size() * sizeof(uint64_t);
+}
+
+bool BilevelImage::savePNG(const std::string& path) const {
+    BilevelPNGWriter writer(path, width, height);
+    for (int y = 0; y < height; y++) writer.writePackedRow(row(y));
+
+    return writer.finish();
+}
+
+bool BilevelImage::encodePNG(std::vector<unsigned char>& output) const {
+    BilevelPNGWriter writer(output, width, height);
+    for (int y = 0; y < height; y++) writer.writePackedRow(row(y));
+
+    return writer.finish();
+}
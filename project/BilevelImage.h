@@ -0,0 +1,49 @@
+#ifndef ENHANCER_BILEVELIMAGE_H
+#define ENHANCER_BILEVELIMAGE_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/*
+    This class stores a binarized (black & white) image with one bit per pixel, which is 8 times smaller than one byte per pixel.
+
+    Every row starts at a new 64-bit word and the pixels are packed MSB-first: pixel x of a row is bit (63 - x % 64) of word x / 64.
+    A set bit is a white pixel (255), a cleared bit a black one (0). The unused bits at the end of a row are always 0.
+*/
+
+class BilevelImage {
+public:
+    int width, height;
+
+    //Number of 64-bit words that hold one row.
+    size_t wordsPerRow;
+
+    //Creates an all-black image.
+    BilevelImage(int width, int height);
+
+    uint64_t* row(int y);
+    const uint64_t* row(int y) const;
+
+    bool getPixel(int x, int y) const;
+
+    //Packs a row of 8-bit pixels, every non-zero pixel becomes white.
+    void packRow(int y, const unsigned char* pixels);
+
+    //Expands a row into 8-bit pixels with the values 0 and 255.
+    void unpackRow(int y, unsigned char* pixels) const;
+
+    size_t getMemoryUsage() const;
+
+    //Saves the image as a 1 bit per pixel grayscale PNG file. Returns false on failure.
+    bool savePNG(const std::string& path) const;
+
+    //Appends the same PNG file to output.
+    bool encodePNG(std::vector<unsigned char>& output) const;
+
+private:
+    std::vector<uint64_t> words;
+};
+
+#endif //ENHANCER_BILEVELIMAGE_H
@@ -0,0 +1,172 @@
+#include <cstdlib>
+#include <algorithm>
+
+#include "BilevelPNGWriter.h"
+
+//stb_image_write compiles its DEFLATE compressor with external linkage (see CreateStbImplementations.cpp), but it doesn't declare it in its header.
+extern "C" unsigned char* stbi_deflate_segment(unsigned char* data, int data_len, int* out_len, int quality, int last);
+
+namespace {
+    uint32_t crc32(const unsigned char* buffer, size_t length, uint32_t crc = 0) {
+        static uint32_t table[256] = {0};
+        static const bool tableIsReady = [] {
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t value = i;
+                for (int bit = 0; bit < 8; bit++) value = (value & 1) ? (0xEDB88320u ^ (value >> 1)) : (value >> 1);
+                table[i] = value;
+            }
+            return true;
+        }();
+        (void) tableIsReady;
+
+        crc = ~crc;
+        for (size_t i = 0; i < length; i++) crc = table[(crc ^ buffer[i]) & 0xFF] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    void appendBigEndian(std::vector<unsigned char>& buffer, uint32_t value) {
+        for (int shift = 24; shift >= 0; shift -= 8) buffer.push_back(static_cast<unsigned char>(value >> shift));
+    }
+}
+
+BilevelPNGWriter::BilevelPNGWriter(const std::string& path, int width, int height, size_t segmentSize)
+        : file(path, std::ios::binary), width(width), height(height) {
+    //PNG packs 1-bit pixels MSB-first, behind the filter type byte (0 = no filter) that every row starts with.
+    bytesPerRow = (static_cast<size_t>(width) + 7) / 8;
+
+    //a segment holds at least one row
+    this->segmentSize = std::max(segmentSize, bytesPerRow + 1);
+    segment.reserve(this->segmentSize);
+
+    if (!file) {
+        failed = true;
+        return;
+    }
+    writeHeader();
+}
+
+BilevelPNGWriter::BilevelPNGWriter(std::vector<unsigned char>& output, int width, int height, size_t segmentSize)
+        : memory(&output), width(width), height(height) {
+    bytesPerRow = (static_cast<size_t>(width) + 7) / 8;
+    this->segmentSize = std::max(segmentSize, bytesPerRow + 1);
+    segment.reserve(this->segmentSize);
+
+    writeHeader();
+}
+
+void BilevelPNGWriter::writeHeader() {
+    const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    if (memory) memory->insert(memory->end(), signature, signature + sizeof(signature));
+    else file.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+    //width, height, bit depth 1, colour type 0 (grayscale), default compression and filter method, no interlacing
+    std::vector<unsigned char> header;
+    appendBigEndian(header, static_cast<uint32_t>(width));
+    appendBigEndian(header, static_cast<uint32_t>(height));
+    header.insert(header.end(), {1, 0, 0, 0, 0});
+    writeChunk("IHDR", header.data(), header.size());
+}
+
+void BilevelPNGWriter::writeChunk(const char* type, const unsigned char* data, size_t length) {
+    std::vector<unsigned char> chunk;
+    appendBigEndian(chunk, static_cast<uint32_t>(length));
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data, data + length);
+    appendBigEndian(chunk, crc32(chunk.data() + 4, length + 4));
+
+    if (memory) memory->insert(memory->end(), chunk.begin(), chunk.end());
+    else file.write(reinterpret_cast<const char*>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+}
+
+bool BilevelPNGWriter::isOpen() const {
+    return !failed;
+}
+
+void BilevelPNGWriter::writeRow(const unsigned char* pixels) {
+    if (failed || rowsWritten >= height) return;
+
+    segment.push_back(0);
+    for (size_t i = 0; i < bytesPerRow; i++) {
+        unsigned char byte = 0;
+        for (int bit = 0; bit < 8; bit++) {
+            size_t x = i * 8 + bit;
+            byte = static_cast<unsigned char>((byte << 1) | (x < static_cast<size_t>(width) && pixels[x] != 0));
+        }
+        segment.push_back(byte);
+    }
+
+    rowsWritten++;
+    if (segment.size() + bytesPerRow + 1 > segmentSize) flushSegment(rowsWritten == height);
+}
+
+void BilevelPNGWriter::writePackedRow(const uint64_t* words) {
+    if (failed || rowsWritten >= height) return;
+
+    //every row is just the bytes of its words in big-endian order
+    segment.push_back(0);
+    for (size_t i = 0; i < bytesPerRow; i++) {
+        segment.push_back(static_cast<unsigned char>(words[i / 8] >> (56 - 8 * (i % 8))));
+    }
+
+    rowsWritten++;
+    if (segment.size() + bytesPerRow + 1 > segmentSize) flushSegment(rowsWritten == height);
+}
+
+void BilevelPNGWriter::flushSegment(bool last) {
+    //the checksum of the zlib stream is taken over the uncompressed rows, 5552 bytes at a time before the sums could overflow
+    for (size_t start = 0; start < segment.size(); start += 5552) {
+        size_t end = std::min(segment.size(), start + 5552);
+        for (size_t i = start; i < end; i++) {
+            adlerA += segment[i];
+            adlerB += adlerA;
+        }
+        adlerA %= 65521;
+        adlerB %= 65521;
+    }
+
+    int compressedLength = 0;
+    unsigned char* compressed = stbi_deflate_segment(segment.data(), static_cast<int>(segment.size()), &compressedLength, 8, last);
+    if (!compressed) {
+        failed = true;
+        return;
+    }
+
+    std::vector<unsigned char> data;
+    data.reserve(compressedLength + 6);
+
+    //the zlib header (32K window, FLEVEL = 1) in front of the first segment, the checksum behind the last one
+    if (!headerWritten) {
+        data.insert(data.end(), {0x78, 0x5e});
+        headerWritten = true;
+    }
+    data.insert(data.end(), compressed, compressed + compressedLength);
+    if (last) appendBigEndian(data, (adlerB << 16) | adlerA);
+    std::free(compressed);
+
+    writeChunk("IDAT", data.data(), data.size());
+    segment.clear();
+
+    if (!memory && !file) failed = true;
+}
+
+bool BilevelPNGWriter::finish() {
+    if (failed || rowsWritten != height) return false;
+
+    //the last segment is flushed here, unless the last row filled it up
+    if (!segment.empty() || !headerWritten) flushSegment(true);
+
+    writeChunk("IEND", nullptr, 0);
+    if (memory) return !failed;
+
+    file.close();
+    return !failed && !file.fail();
+}
+
+int BilevelPNGWriter::getRowsWritten() const {
+    return rowsWritten;
+}
+
+size_t BilevelPNGWriter::memoryUsage(size_t segmentSize) {
+    //the rows, the compressed segment (which is at most a little larger than the rows) and the hash table of the compressor
+    return 2 * segmentSize + 16384 * sizeof(void*);
+}
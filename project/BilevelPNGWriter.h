@@ -0,0 +1,73 @@
+#ifndef ENHANCER_BILEVELPNGWRITER_H
+#define ENHANCER_BILEVELPNGWRITER_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+#include <cstddef>
+
+/*
+    This class writes a 1 bit per pixel grayscale PNG file row by row, so that an image can be saved while it is still being binarized,
+    without ever holding all of its rows.
+
+    The rows are collected until a segment of segmentSize bytes is full, which is then compressed on its own (see stbi_deflate_segment)
+    and written as an IDAT chunk right away. The checksum of the zlib stream is summed up as the rows come in. Only the rows of the current
+    segment and its compressed bytes are held in memory, however large the image is.
+*/
+
+class BilevelPNGWriter {
+public:
+    static constexpr size_t defaultSegmentSize = 1024 * 1024;
+
+    //Creates the file and writes the PNG header; isOpen() tells whether that worked.
+    BilevelPNGWriter(const std::string& path, int width, int height, size_t segmentSize = defaultSegmentSize);
+
+    //Appends the PNG file to output instead, e.g. to hand it to an asynchronous writer.
+    BilevelPNGWriter(std::vector<unsigned char>& output, int width, int height, size_t segmentSize = defaultSegmentSize);
+
+    BilevelPNGWriter(const BilevelPNGWriter&) = delete;
+    BilevelPNGWriter& operator=(const BilevelPNGWriter&) = delete;
+
+    bool isOpen() const;
+
+    //Adds the next row as 8-bit pixels (width bytes), every non-zero pixel becomes white.
+    void writeRow(const unsigned char* pixels);
+
+    //Adds the next row as a row of a BilevelImage (MSB-first words, see BilevelImage).
+    void writePackedRow(const uint64_t* words);
+
+    //Compresses the rest of the rows and ends the file. Returns false if not all rows were written or anything failed.
+    bool finish();
+
+    int getRowsWritten() const;
+
+    //Number of bytes the writer needs at most for a segment and its compressed version.
+    static size_t memoryUsage(size_t segmentSize = defaultSegmentSize);
+
+private:
+    std::ofstream file;
+    std::vector<unsigned char>* memory = nullptr;
+    int width, height;
+    size_t bytesPerRow, segmentSize;
+
+    //PNG rows of the current segment, each one behind its filter type byte
+    std::vector<unsigned char> segment;
+
+    int rowsWritten = 0;
+    bool failed = false;
+    bool headerWritten = false;
+
+    //Adler-32 of all PNG rows so far
+    uint32_t adlerA = 1, adlerB = 0;
+
+    void writeHeader();
+
+    //A PNG chunk is its length, its type, its data and the CRC of type + data.
+    void writeChunk(const char* type, const unsigned char* data, size_t length);
+
+    //Compresses the current segment and writes it as an IDAT chunk.
+    void flushSegment(bool last);
+};
+
+#endif //ENHANCER_BILEVELPNGWRITER_H
@@ -0,0 +1,176 @@
+#ifndef ENHANCER_BOUNDEDQUEUE_H
+#define ENHANCER_BOUNDEDQUEUE_H
+
+#include <atomic>
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/*
+    A bounded queue for any number of producer and consumer threads, which connects the stages of the ImagePipeline.
+
+    The queue is lock-free (D. Vyukov's bounded MPMC queue): every cell carries a sequence number that tells whether it is free for the
+    producer or filled for the consumer of a given position, and producers and consumers only claim positions with a compare-and-swap.
+    A full queue makes push wait (backpressure), so a fast stage can't run ahead of a slow one and pile up decoded images in memory.
+    Waiting threads first yield and then sleep for a growing time, so an idle stage doesn't keep a core busy.
+
+    When the producers are done the queue is closed; pop then returns false as soon as the queue is empty.
+*/
+
+//The same for all value types, so that queues of different types can be reported together.
+struct BoundedQueueStatistics {
+    size_t capacity;
+    size_t maxDepth;       //most values that were in the queue at once
+    double averageDepth;   //number of values in the queue, averaged over all pushes
+    uint64_t pushes;
+    uint64_t fullWaits;    //pushes that had to wait because the consumers fell behind
+    uint64_t emptyWaits;   //pops that had to wait because the producers fell behind
+};
+
+template<typename T>
+class BoundedQueue {
+public:
+    //The capacity is rounded up to a power of two, and is at least 2: with a single cell, the sequence number of a filled cell would be
+    //the one of a cell that is free for the next position.
+    explicit BoundedQueue(size_t capacity) {
+        size_t roundedCapacity = 2;
+        while (roundedCapacity < capacity) roundedCapacity *= 2;
+
+        mask = roundedCapacity - 1;
+        cells.reset(new Cell[roundedCapacity]);
+        for (size_t i = 0; i < roundedCapacity; i++) cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    size_t capacity() const {
+        return mask + 1;
+    }
+
+    //Moves value into the queue, unless the queue is full.
+    bool tryPush(T& value) {
+        size_t position = enqueuePosition.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells[position & mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+
+            if (difference == 0) {
+                //the cell is free for this position, it belongs to us once we moved the position on
+                if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    recordDepth(position + 1);
+                    return true;
+                }
+            }
+            else if (difference < 0) {
+                //the consumer of the previous round hasn't taken the cell yet
+                return false;
+            }
+            else {
+                position = enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    //Moves the oldest value out of the queue, unless the queue is empty.
+    bool tryPop(T& value) {
+        size_t position = dequeuePosition.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells[position & mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+
+            if (difference == 0) {
+                if (dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    value = std::move(cell.value);
+                    //the cell is free for the producer of the next round
+                    cell.sequence.store(position + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (difference < 0) {
+                return false;
+            }
+            else {
+                position = dequeuePosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    //Waits until there is room in the queue.
+    void push(T value) {
+        if (tryPush(value)) return;
+
+        fullWaits.fetch_add(1, std::memory_order_relaxed);
+        for (int attempt = 0; !tryPush(value); attempt++) backOff(attempt);
+    }
+
+    //Waits until there is a value in the queue; returns false once the queue is closed and empty.
+    bool pop(T& value) {
+        if (tryPop(value)) return true;
+
+        emptyWaits.fetch_add(1, std::memory_order_relaxed);
+        for (int attempt = 0; ; attempt++) {
+            //a value may have been pushed right before the queue was closed
+            bool wasClosed = closed.load(std::memory_order_acquire);
+            if (tryPop(value)) return true;
+            if (wasClosed) return false;
+            backOff(attempt);
+        }
+    }
+
+    //Tells the consumers that nothing will be pushed anymore.
+    void close() {
+        closed.store(true, std::memory_order_release);
+    }
+
+    //Counters since the construction.
+    using Statistics = BoundedQueueStatistics;
+
+    Statistics getStatistics() const {
+        uint64_t nrOfPushes = pushes.load();
+        double average = nrOfPushes ? static_cast<double>(depthSum.load()) / nrOfPushes : 0.0;
+        return {capacity(), maxDepth.load(), average, nrOfPushes, fullWaits.load(), emptyWaits.load()};
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+
+    //the producers and the consumers each have their own cache line
+    alignas(64) std::atomic<size_t> enqueuePosition{0};
+    alignas(64) std::atomic<size_t> dequeuePosition{0};
+    alignas(64) std::atomic<bool> closed{false};
+
+    std::atomic<size_t> maxDepth{0};
+    std::atomic<uint64_t> depthSum{0}, pushes{0}, fullWaits{0}, emptyWaits{0};
+
+    void recordDepth(size_t enqueued) {
+        size_t dequeued = dequeuePosition.load(std::memory_order_relaxed);
+        //the consumers may have moved on in between, which can only make the depth look larger than it was
+        size_t depth = std::min(enqueued > dequeued ? enqueued - dequeued : 0, capacity());
+
+        pushes.fetch_add(1, std::memory_order_relaxed);
+        depthSum.fetch_add(depth, std::memory_order_relaxed);
+        size_t previous = maxDepth.load(std::memory_order_relaxed);
+        while (depth > previous && !maxDepth.compare_exchange_weak(previous, depth, std::memory_order_relaxed)) {}
+    }
+
+    static void backOff(int attempt) {
+        if (attempt < 64) std::this_thread::yield();
+        else std::this_thread::sleep_for(std::chrono::microseconds(std::min(50 << std::min((attempt - 64) / 16, 5), 1000)));
+    }
+};
+
+#endif //ENHANCER_BOUNDEDQUEUE_H
@@ -0,0 +1,116 @@
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <atomic>
+#include <vector>
+#include <map>
+
+#include "BufferPool.h"
+#include "AlignedMemory.h"
+
+namespace {
+    //Every buffer starts with a header that remembers its size class; the header is as large as the alignment,
+    //so the memory handed out is 64-byte aligned as well.
+    const size_t alignment = 64;
+
+    struct FreeBuffers {
+        //ordered, so the smallest class that is large enough can be found with lower_bound
+        std::map<size_t, std::vector<void*>> bySizeClass;
+
+        ~FreeBuffers() {
+            for (auto& sizeClass : bySizeClass) {
+                for (void* block : sizeClass.second) AlignedMemory::release(block);
+            }
+        }
+    };
+
+    //constructed on the first use in every thread and freed when the thread ends
+    thread_local FreeBuffers freeBuffers;
+
+    std::atomic<uint64_t> requests{0}, reuses{0}, bytesAllocated{0};
+}
+
+size_t BufferPool::sizeClass(size_t bytes) {
+    const size_t smallestClass = 4096;
+    if (bytes <= smallestClass) return smallestClass;
+
+    //2^k < bytes <= 2^(k+1), the classes between them are 4 equal steps apart
+    int k = 63 - __builtin_clzll(static_cast<unsigned long long>(bytes - 1));
+    size_t base = size_t(1) << k;
+    size_t step = base / 4;
+    return base + (bytes - base + step - 1) / step * step;
+}
+
+void* BufferPool::acquire(size_t bytes) {
+    size_t size = sizeClass(bytes);
+    requests.fetch_add(1, std::memory_order_relaxed);
+
+    //the smallest free buffer that is large enough, but at most twice the size, so that a small image doesn't hold on to a huge buffer
+    //(scans often differ a little in size, an exact class match alone would rarely find a buffer)
+    void* block = nullptr;
+    for (auto sizeClass = freeBuffers.bySizeClass.lower_bound(size); sizeClass != freeBuffers.bySizeClass.end() && sizeClass->first <= 2 * size; ++sizeClass) {
+        if (!sizeClass->second.empty()) {
+            block = sizeClass->second.back();
+            sizeClass->second.pop_back();
+            reuses.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+    }
+
+    if (!block) {
+        //aligned_alloc needs a size that is a multiple of the alignment, every size class is a multiple of 1 KB
+        block = AlignedMemory::allocate(alignment, size + alignment);
+        if (!block) throw std::bad_alloc();
+        *static_cast<size_t*>(block) = size;
+        bytesAllocated.fetch_add(size, std::memory_order_relaxed);
+    }
+
+    return static_cast<unsigned char*>(block) + alignment;
+}
+
+void BufferPool::release(void* buffer) {
+    if (!buffer) return;
+
+    void* block = static_cast<unsigned char*>(buffer) - alignment;
+    size_t size = *static_cast<size_t*>(block);
+
+    std::vector<void*>& available = freeBuffers.bySizeClass[size];
+    if (available.size() < maxBuffersPerClass) available.push_back(block);
+    else AlignedMemory::release(block);
+}
+
+size_t BufferPool::capacity(const void* buffer) {
+    return *reinterpret_cast<const size_t*>(static_cast<const unsigned char*>(buffer) - alignment);
+}
+
+void* BufferPool::shrink(void* buffer, size_t bytes) {
+    if (!buffer) return nullptr;
+
+    size_t size = sizeClass(bytes);
+    void* block = static_cast<unsigned char*>(buffer) - alignment;
+    if (size >= *static_cast<size_t*>(block)) return buffer;
+
+    //shrinking in place gives the pages at the end back to the system (see AlignedMemory::reallocate)
+    void* shrunk = AlignedMemory::reallocate(block, alignment, size + alignment);
+    if (!shrunk) return buffer;
+
+    *static_cast<size_t*>(shrunk) = size;
+    return static_cast<unsigned char*>(shrunk) + alignment;
+}
+
+void BufferPool::clear() {
+    for (auto& sizeClass : freeBuffers.bySizeClass) {
+        for (void* block : sizeClass.second) AlignedMemory::release(block);
+        sizeClass.second.clear();
+    }
+}
+
+BufferPool::Statistics BufferPool::getStatistics() {
+    return {requests.load(), reuses.load(), bytesAllocated.load()};
+}
+
+void BufferPool::resetStatistics() {
+    requests = 0;
+    reuses = 0;
+    bytesAllocated = 0;
+}
@@ -0,0 +1,58 @@
+#ifndef ENHANCER_BUFFERPOOL_H
+#define ENHANCER_BUFFERPOOL_H
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+    This class hands out the large pixel buffers (grayscale, integral and binarized images) and takes them back for reuse.
+
+    Every thread keeps its own free buffers, so getting and returning a buffer never takes a lock, and a worker that processes
+    one image after the other gets the memory of the previous image back, which is already paged in.
+    The buffer sizes are rounded up to size classes (4 steps per power of two, at least 4 KB). A request takes the smallest free buffer
+    whose class is large enough and at most twice the requested class, so images of similar sizes share buffers.
+    A buffer may be returned on another thread than the one it came from, it then moves to the pool of that thread.
+*/
+
+class BufferPool {
+public:
+    //Returns a 64-byte aligned buffer of at least the given size, with undefined contents. Throws std::bad_alloc if there is no memory left.
+    static void* acquire(size_t bytes);
+
+    template<typename T>
+    static T* acquire(size_t count) {
+        return static_cast<T*>(acquire(count * sizeof(T)));
+    }
+
+    //Gives a buffer from acquire() back to the pool of the calling thread. nullptr is ignored.
+    static void release(void* buffer);
+
+    //The usable size of a buffer from acquire(), which is its size class.
+    static size_t capacity(const void* buffer);
+
+    //Gives the end of a buffer back to the system with an (aligned) realloc, so that it only keeps the size class of bytes. The contents up to bytes
+    //are kept, and the buffer usually stays where it is; the returned pointer replaces buffer. A buffer that is already small enough is returned as is.
+    static void* shrink(void* buffer, size_t bytes);
+
+    //Frees all buffers in the pool of the calling thread.
+    static void clear();
+
+    //Counters over all threads since the last reset.
+    struct Statistics {
+        uint64_t requests;
+        uint64_t reuses;
+        uint64_t bytesAllocated;   //memory that had to be freshly allocated, because the pool had no buffer of the size class
+    };
+
+    static Statistics getStatistics();
+    static void resetStatistics();
+
+    //The size class a request of this many bytes is rounded up to.
+    static size_t sizeClass(size_t bytes);
+
+private:
+    //How many free buffers of one size class a thread keeps, further buffers are given back to the system.
+    static const size_t maxBuffersPerClass = 4;
+};
+
+#endif //ENHANCER_BUFFERPOOL_H
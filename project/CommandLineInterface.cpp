@@ -10,10 +10,15 @@
 
 #include "CommandLineInterface.h"
 #include "termcolor.hpp"
+#include "ImagePipeline.h"
+#include "GrayscaleKernels.h"
+#include "ThresholdKernels.h"
+#include "TuningProfile.h"
 
 CommandLineInterface::CommandLineInterface(int argc, char** argv): argc(argc), argv(argv), windowWidth(0.125), thresholdPercentage(0.15) {
     numberOfThreads_adaptiveThresholding = omp_get_num_procs();
     numberOfThreads_grayscaleConversion = 1;
+    numberOfThreads_thresholding = 1;
     parseArguments();
 }
 
@@ -26,9 +31,30 @@ void CommandLineInterface::printHelp() {
                                 "-w, --windowWidth <val>:", "[Optional] The window width that will be used in the adaptive thresholding method. This is a number between 0-1 and it is defined in terms of the width of the image, e.g. 0.125 (one-eighth).",
                                 "-t, --thresholdPercentage <val>:", "[Optional] The threshold percentage that will be used in the adaptive thresholding method. This is a number between 0-1 and it is defined as a percentage, e.g. 0.15 (fifteen percent).",
                                 "-nt_a, --numberOfThreads_adaptiveThresholding <val>", "[Optional] Allows you to set the number of threads that will be created by the program when processing individual image files. Default is the number of logical cores. Set this to 1 if you want the program to run sequentially.",
-                                "-nt_g, --numberOfThreads_grayscaleConversion <val>", "[Optional] Allows you to set the number of threads that will be created by the program when converting a single image into grayscale. Default is 1.",
+                                "-nt_g, --numberOfThreads_grayscaleConversion <val>", "[Optional] Allows you to set the number of threads that will be created by the program when converting a single image into grayscale. Default is chosen for every image (see --adaptiveSplit), 1 without it.",
+                                "-nt_t, --numberOfThreads_thresholding <val>", "[Optional] Allows you to set the number of threads that will be created by the program when applying the threshold to the pixels of a single image. Default is chosen for every image (see --adaptiveSplit), 1 without it.",
+                                "-fu, --fuseGrayscaleAndIntegral <true/false>", "[Optional] Convert colour images into grayscale and build the integral image in a single pass over the image (default = true). Set this to false to use two separate passes, e.g. to compare the two in benchmarks.",
+                                "-st, --streamingThresholding <true/false>", "[Optional] Apply the adaptive thresholding row by row with a sliding window instead of a full integral image (default = false). This needs far less memory per image, but uses a single thread per image.",
+                                "-iw, --integralWidth <auto/32/64>", "[Optional] Number of bits per element of the integral image used by the adaptive thresholding method (default = auto). The 32-bit integral image needs half the memory, and is used automatically whenever the window size allows it. If the window is too large for 32 bits, the 64-bit version is used instead.",
+                                "-pk, --packedOutput <true/false>", "[Optional] Store the binarized images with 1 bit per pixel instead of 1 byte per pixel and save them as 1-bit PNG files instead of JPEG files (default = false).",
+                                "-ip, --inPlace <true/false>", "[Optional] Convert the images into grayscale and binarize them inside their own buffer instead of allocating new buffers for the results, and give the memory that only held colour pixels back afterwards (default = false). This lowers the peak memory per image, but colour images are no longer converted in the same pass as the integral image.",
+                                "-ld, --lumaDecoding <true/false>", "[Optional] Decode the images straight into a single grayscale (luma) channel before the adaptive thresholding, instead of decoding all colour channels and averaging them (default = true). For JPEG files this skips most of the colour decoding work.",
+                                "-ds, --decodeScale <1, 1/2, 1/4, 1/8>", "[Optional] Decode JPEG files at a fraction of their width and height, e.g. for previews or a 150 dpi first pass over 600 dpi scans (default = 1). The scaling is done while decoding, so the decoding gets cheaper with the number of pixels. Other file types are always loaded at full size.",
+                                "-ml, --memoryLimit <megabytes>", "[Optional] Binarize every image in tiles with at most this much memory, for scans that are too large to be held in memory as a whole (default = 0, off). Baseline JPEG files are decoded row by row and never held as a whole, and the results are written as 1-bit PNG files while they are binarized. The limit holds for the whole batch: the images are binarized one at a time, and the threads share the tiles of an image instead.",
+                                "-pf, --prefetchDistance <files>", "[Optional] Number of input files that are read into memory in the background ahead of the files that are being processed, so that decoding doesn't have to wait for the disk (default = 4). Set this to 0 to turn the prefetching off.",
+                                "-io, --ioUring <true/false>", "[Optional] Read the input files and write the results on a separate I/O thread with io_uring (Linux only), so that the processing threads never wait for the file system (default = false). The opens, reads and writes of many files are submitted to the kernel together, which helps most with network volumes. Falls back to blocking calls on the I/O thread where io_uring isn't available.",
+                                "-dio, --directOutput <true/false>", "[Optional] Write the results with O_DIRECT, past the page cache, when --ioUring is used (default = false).",
+                                "-pl, --pipeline <read,decode,process,encode,write>", "[Optional] Process the images in a pipeline of five stages with the given numbers of threads, e.g. 1,2,4,2,1 (default = off). The files are read, decoded, processed, encoded and written by separate threads that pass the images on through bounded queues, and at the end the program reports how busy every stage was, so the slowest stage can be given more threads.",
+                                "-qd, --queueDepth <images>", "[Optional] Number of images the queues between the stages of --pipeline hold (default = 4). A stage waits when the queue behind it is full, so this limits the number of images in memory.",
+                                "-lf, --largestFirst <true/false>", "[Optional] Process the images from the largest to the smallest number of pixels, which are read from the file headers first, instead of in the order of the directory (default = true). This keeps a large scan from being left for the end while the other threads are idle.",
+                                "-as, --adaptiveSplit <true/false>", "[Optional] Choose the number of threads of every image from the number of images that are left (default = true): every thread works on whole images while there are enough of them, and the last images of the batch are split into bands for the threads that have run out of images. Giving -nt_g or -nt_t turns this off.",
+                                "-gk, --grayscaleKernel <auto/scalar/ssse3/avx2/avx512>", "[Optional] The SIMD instruction set of the grayscale conversion (default = auto, the best one the CPU supports). All of them give the same pixels.",
+                                "-tk, --thresholdingKernel <auto/scalar/avx2>", "[Optional] The SIMD instruction set of the thresholding pass (default = auto, the best one the CPU supports). All of them give the same pixels.",
+                                "-ts, --tileSize <pixels>", "[Optional] The largest width and height of the tiles of --memoryLimit (default = 0, as large as the memory limit allows). Smaller tiles can be faster when they fit into the cache.",
+                                "-tu, --tune", "[Optional] Find the fastest settings for this machine: the numbers of threads, the integral image width, the fused, in-place and streaming variants, the SIMD kernels and (with --memoryLimit) the tile size are tried one after the other on a sample of up to 8 images of the input folder, and the fastest ones are saved to the profile. All of them give the same pixels. The results of the sample are saved into <outputDirectory>_tune.",
+                                "-pr, --profile <path/none>", "[Optional] The profile that holds the settings found by --tune (default = ~/.config/enhancer/profile, or %APPDATA%\\enhancer\\profile on Windows). It is read on every run (except --tune and --benchmark) before the other arguments, so the arguments on the command line override it. Set this to none to ignore the profile.",
                                 "-v, --verbose <true/false>", "[Optional] Print debugging information (default = true)",
-                                "-bm, --benchmark", "[Optional] Run benchmarks that tests the change in runtime depending on the number of threads used. There are currently 3 benchmarks that test the grayscale conversion speed in isolation, adaptive thresholding speed with one level of parallelization and adaptive thresholding with two levels of parallelization. You can plot the resulting CSV file using your scripting language of choice, like Python or R.",
+                                "-bm, --benchmark", "[Optional] Run benchmarks that tests the change in runtime depending on the number of threads used. There are currently 8 benchmarks that test the grayscale conversion speed in isolation, adaptive thresholding speed with one level of parallelization, adaptive thresholding with two levels of parallelization, the integral image construction in isolation, the parallelized thresholding pass the fused grayscale + integral image pass against the two separate passes the 32-bit integral image against the 64-bit one and the JPEG decoding time at the different decode scales. You can plot the resulting CSV file using your scripting language of choice, like Python or R.",
                                 "-h, --help:", "Show help.",
                                 "Usage example: ", "./enhancer.exe --inputPath test_input --outputPath test_output"
                               };
@@ -37,15 +63,46 @@ void CommandLineInterface::printHelp() {
 }
 
 void CommandLineInterface::parseArguments() {
+    std::string errorMessages = parseArguments(argc, argv);
+
+    if(!errorMessages.empty()) {
+        std::cout << termcolor::red << "Invalid, missing or unknown arguments are detected:\n" << errorMessages << termcolor::reset << "\n";
+        printHelp();
+        exit(1);
+    }
+}
+
+std::string CommandLineInterface::parseArguments(int argc, char** argv) {
     //VERSION 2:
     //We are no longer using "getopt" to parse arguments, because it only works on linux and not on windows; Powershell and CMD produce no output when running the executable.
     //Getopt still works when using MinGW or git bash but that isn't ideal for portability.
 
     std::string errorMessages;
 
+    //The settings found by --tune are stored as arguments in the profile, which are put in front of the arguments of the command line,
+    //so that the ones the user gives still win. A new tuning run starts from the defaults instead, and so do the benchmarks, which
+    //would otherwise measure whatever kernels and thread counts the profile forces.
+    profilePath = TuningProfile::defaultPath().string();
+    bool skipProfile = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if ((arg == "-pr" || arg == "--profile") && i + 1 < argc) profilePath = argv[++i];
+        else if (arg == "-tu" || arg == "--tune" || arg == "-bm" || arg == "--benchmark") skipProfile = true;
+    }
+
+    std::vector<std::string> arguments{argv[0]};
+    bool profileLoaded = false;
+    if (!skipProfile && !profilePath.empty() && profilePath != "none" && std::filesystem::exists(profilePath)) {
+        std::vector<std::string> profileArguments = TuningProfile::read(profilePath);
+        arguments.insert(arguments.end(), profileArguments.begin(), profileArguments.end());
+        profileLoaded = !profileArguments.empty();
+    }
+    arguments.insert(arguments.end(), argv + 1, argv + argc);
+    int nrOfArguments = static_cast<int>(arguments.size());
+
     //the first element of the argv array is the name of the file, e.g. "enhancer.exe" - we are not interested in that so the loop starts from 1.
-    for(int i = 1; i < argc; i++) {
-        std::string arg = argv[i];  //get the current argument.
+    for(int i = 1; i < nrOfArguments; i++) {
+        std::string arg = arguments[i];  //get the current argument.
 
         if (arg == "-h" || arg == "--help") {
             printHelp();
@@ -53,53 +110,284 @@ void CommandLineInterface::parseArguments() {
         }
         else if (arg == "--interactive") {
             startInteractiveMode();
-            return;
+            return "";
         }
         else if (arg == "-i" || arg == "--inputPath") {
-            if (i + 1 < argc) {
-                inputPath = argv[++i];
+            if (i + 1 < nrOfArguments) {
+                inputPath = arguments[++i];
             }
         }
         else if (arg == "-o" || arg == "--outputDirectory") {
-            if (i + 1 < argc) {
-                outputDirectory = argv[++i];
+            if (i + 1 < nrOfArguments) {
+                outputDirectory = arguments[++i];
             }
         }
         else if (arg == "-w" || arg == "--windowWidth") {
-            if (i + 1 < argc) {
-                std::istringstream numberstream(argv[++i]);
+            if (i + 1 < nrOfArguments) {
+                std::istringstream numberstream(arguments[++i]);
                 if (!(numberstream >> windowWidth)) {
                     errorMessages += "Invalid --windowWidth argument.\n";
                 }
             }
         }
         else if (arg == "-t" || arg == "--thresholdPercentage") {
-            if (i + 1 < argc) {
-                std::istringstream numberstream(argv[++i]);
+            if (i + 1 < nrOfArguments) {
+                std::istringstream numberstream(arguments[++i]);
                 if (!(numberstream >> thresholdPercentage)) {
                     errorMessages += "Invalid --thresholdPercentage argument.\n";
                 }
             }
         }
         else if (arg == "-nt_a" || arg == "--numberOfThreads_adaptiveThresholding") {
-            if (i + 1 < argc) {
-                std::istringstream numberstream(argv[++i]);
+            if (i + 1 < nrOfArguments) {
+                std::istringstream numberstream(arguments[++i]);
                 if (!(numberstream >> numberOfThreads_adaptiveThresholding)) {
                     errorMessages += "Invalid --numberOfThreads_adaptiveThresholding argument.\n";
                 }
             }
         }
         else if (arg == "-nt_g" || arg == "--numberOfThreads_grayscaleConversion") {
-            if (i + 1 < argc) {
-                std::istringstream numberstream(argv[++i]);
+            if (i + 1 < nrOfArguments) {
+                std::istringstream numberstream(arguments[++i]);
                 if (!(numberstream >> numberOfThreads_grayscaleConversion)) {
                     errorMessages += "Invalid --numberOfThreads_grayscaleConversion argument.\n";
                 }
+                //a number of threads given by hand is used for every image
+                adaptiveSplit = false;
+            }
+        }
+        else if (arg == "-nt_t" || arg == "--numberOfThreads_thresholding") {
+            if (i + 1 < nrOfArguments) {
+                std::istringstream numberstream(arguments[++i]);
+                if (!(numberstream >> numberOfThreads_thresholding)) {
+                    errorMessages += "Invalid --numberOfThreads_thresholding argument.\n";
+                }
+                adaptiveSplit = false;
+            }
+        }
+        else if (arg == "-fu" || arg == "--fuseGrayscaleAndIntegral") {
+            if (i + 1 < nrOfArguments) {
+                std::string answer = arguments[++i];
+                std::transform(answer.begin(), answer.end(), answer.begin(), [](unsigned char c){ return std::tolower(c); });
+
+                if (answer == "true" || answer == "y") fuseGrayscaleAndIntegral = true;
+                else if (answer == "false" || answer == "n") fuseGrayscaleAndIntegral = false;
+                else {
+                    errorMessages += "Invalid --fuseGrayscaleAndIntegral argument.\n";
+                }
+            }
+        }
+        else if (arg == "-st" || arg == "--streamingThresholding") {
+            if (i + 1 < nrOfArguments) {
+                std::string answer = arguments[++i];
+                std::transform(answer.begin(), answer.end(), answer.begin(), [](unsigned char c){ return std::tolower(c); });
+
+                if (answer == "true" || answer == "y") streamingThresholding = true;
+                else if (answer == "false" || answer == "n") streamingThresholding = false;
+                else {
+                    errorMessages += "Invalid --streamingThresholding argument.\n";
+                }
+            }
+        }
+        else if (arg == "-iw" || arg == "--integralWidth") {
+            if (i + 1 < nrOfArguments) {
+                std::string answer = arguments[++i];
+                std::transform(answer.begin(), answer.end(), answer.begin(), [](unsigned char c){ return std::tolower(c); });
+
+                if (answer == "auto") integralWidth = 0;
+                else if (answer == "32") integralWidth = 32;
+                else if (answer == "64") integralWidth = 64;
+                else {
+                    errorMessages += "Invalid --integralWidth argument.\n";
+                }
+            }
+        }
+        else if (arg == "-pk" || arg == "--packedOutput") {
+            if (i + 1 < nrOfArguments) {
+                std::string answer = arguments[++i];
+                std::transform(answer.begin(), answer.end(), answer.begin(), [](unsigned char c){ return std::tolower(c); });
+
+                if (answer == "true" || answer == "y") packedOutput = true;
+                else if (answer == "false" || answer == "n") packedOutput = false;
+                else {
+                    errorMessages += "Invalid --packedOutput argument.\n";
+                }
+            }
+        }
+        else if (arg == "-ip" || arg == "--inPlace") {
+            if (i + 1 < nrOfArguments) {
+                std::string answer = arguments[++i];
+                std::transform(answer.begin(), answer.end(), answer.begin(), [](unsigned char c){ return std::tolower(c); });
+
+                if (answer == "true" || answer == "y") inPlace = true;
+                else if (answer == "false" || answer == "n") inPlace = false;
+                else {
+                    errorMessages += "Invalid --inPlace argument.\n";
+                }
+            }
+        }
+        else if (arg == "-ld" || arg == "--lumaDecoding") {
+            if (i + 1 < nrOfArguments) {
+                std::string answer = arguments[++i];
+                std::transform(answer.begin(), answer.end(), answer.begin(), [](unsigned char c){ return std::tolower(c); });
+
+                if (answer == "true" || answer == "y") lumaDecoding = true;
+                else if (answer == "false" || answer == "n") lumaDecoding = false;
+                else {
+                    errorMessages += "Invalid --lumaDecoding argument.\n";
+                }
+            }
+        }
+        else if (arg == "-ds" || arg == "--decodeScale") {
+            if (i + 1 < nrOfArguments) {
+                std::string answer = arguments[++i];
+
+                if (answer == "1" || answer == "1/1") decodeScale = 1;
+                else if (answer == "1/2" || answer == "2") decodeScale = 2;
+                else if (answer == "1/4" || answer == "4") decodeScale = 4;
+                else if (answer == "1/8" || answer == "8") decodeScale = 8;
+                else {
+                    errorMessages += "Invalid --decodeScale argument.\n";
+                }
+            }
+        }
+        else if (arg == "-ml" || arg == "--memoryLimit") {
+            if (i + 1 < nrOfArguments) {
+                std::istringstream numberstream(arguments[++i]);
+                if (!(numberstream >> memoryLimit) || memoryLimit < 0) {
+                    errorMessages += "Invalid --memoryLimit argument.\n";
+                }
+            }
+        }
+        else if (arg == "-pf" || arg == "--prefetchDistance") {
+            if (i + 1 < nrOfArguments) {
+                std::istringstream numberstream(arguments[++i]);
+                if (!(numberstream >> prefetchDistance) || prefetchDistance < 0) {
+                    errorMessages += "Invalid --prefetchDistance argument.\n";
+                }
+            }
+        }
+        else if (arg == "-io" || arg == "--ioUring") {
+            if (i + 1 < nrOfArguments) {
+                std::string answer = arguments[++i];
+                std::transform(answer.begin(), answer.end(), answer.begin(), [](unsigned char c){ return std::tolower(c); });
+
+                if (answer == "true" || answer == "y") ioUring = true;
+                else if (answer == "false" || answer == "n") ioUring = false;
+                else {
+                    errorMessages += "Invalid --ioUring argument.\n";
+                }
+            }
+        }
+        else if (arg == "-dio" || arg == "--directOutput") {
+            if (i + 1 < nrOfArguments) {
+                std::string answer = arguments[++i];
+                std::transform(answer.begin(), answer.end(), answer.begin(), [](unsigned char c){ return std::tolower(c); });
+
+                if (answer == "true" || answer == "y") directOutput = true;
+                else if (answer == "false" || answer == "n") directOutput = false;
+                else {
+                    errorMessages += "Invalid --directOutput argument.\n";
+                }
+            }
+        }
+        else if (arg == "-pl" || arg == "--pipeline") {
+            if (i + 1 < nrOfArguments) {
+                int threads[ImagePipeline::nrOfStages];
+                if (ImagePipeline::parseThreadCounts(arguments[++i], threads)) pipelineThreads.assign(threads, threads + ImagePipeline::nrOfStages);
+                else {
+                    errorMessages += "Invalid --pipeline argument.\n";
+                }
+            }
+        }
+        else if (arg == "-qd" || arg == "--queueDepth") {
+            if (i + 1 < nrOfArguments) {
+                std::istringstream numberstream(arguments[++i]);
+                if (!(numberstream >> queueDepth) || queueDepth < 1) {
+                    errorMessages += "Invalid --queueDepth argument.\n";
+                }
+            }
+        }
+        else if (arg == "-lf" || arg == "--largestFirst") {
+            if (i + 1 < nrOfArguments) {
+                std::string answer = arguments[++i];
+                std::transform(answer.begin(), answer.end(), answer.begin(), [](unsigned char c){ return std::tolower(c); });
+
+                if (answer == "true" || answer == "y") largestFirst = true;
+                else if (answer == "false" || answer == "n") largestFirst = false;
+                else {
+                    errorMessages += "Invalid --largestFirst argument.\n";
+                }
+            }
+        }
+        else if (arg == "-as" || arg == "--adaptiveSplit") {
+            if (i + 1 < nrOfArguments) {
+                std::string answer = arguments[++i];
+                std::transform(answer.begin(), answer.end(), answer.begin(), [](unsigned char c){ return std::tolower(c); });
+
+                if (answer == "true" || answer == "y") adaptiveSplit = true;
+                else if (answer == "false" || answer == "n") adaptiveSplit = false;
+                else {
+                    errorMessages += "Invalid --adaptiveSplit argument.\n";
+                }
+            }
+        }
+        else if (arg == "-gk" || arg == "--grayscaleKernel") {
+            if (i + 1 < nrOfArguments) {
+                std::string answer = arguments[++i];
+                std::transform(answer.begin(), answer.end(), answer.begin(), [](unsigned char c){ return std::tolower(c); });
+
+                if (answer == "auto") grayscaleKernel = -1;
+                else if (answer == "scalar") grayscaleKernel = GrayscaleKernels::Scalar;
+                else if (answer == "ssse3") grayscaleKernel = GrayscaleKernels::SSSE3;
+                else if (answer == "avx2") grayscaleKernel = GrayscaleKernels::AVX2;
+                else if (answer == "avx512") grayscaleKernel = GrayscaleKernels::AVX512;
+                else {
+                    errorMessages += "Invalid --grayscaleKernel argument.\n";
+                }
+
+                if (grayscaleKernel >= 0 && !GrayscaleKernels::isSupported(static_cast<GrayscaleKernels::InstructionSet>(grayscaleKernel))) {
+                    errorMessages += "The CPU doesn't support the --grayscaleKernel " + answer + ".\n";
+                    grayscaleKernel = -1;
+                }
+            }
+        }
+        else if (arg == "-tk" || arg == "--thresholdingKernel") {
+            if (i + 1 < nrOfArguments) {
+                std::string answer = arguments[++i];
+                std::transform(answer.begin(), answer.end(), answer.begin(), [](unsigned char c){ return std::tolower(c); });
+
+                if (answer == "auto") thresholdingKernel = -1;
+                else if (answer == "scalar") thresholdingKernel = ThresholdKernels::Scalar;
+                else if (answer == "avx2") thresholdingKernel = ThresholdKernels::AVX2;
+                else {
+                    errorMessages += "Invalid --thresholdingKernel argument.\n";
+                }
+
+                if (thresholdingKernel >= 0 && !ThresholdKernels::isSupported(static_cast<ThresholdKernels::InstructionSet>(thresholdingKernel))) {
+                    errorMessages += "The CPU doesn't support the --thresholdingKernel " + answer + ".\n";
+                    thresholdingKernel = -1;
+                }
+            }
+        }
+        else if (arg == "-ts" || arg == "--tileSize") {
+            if (i + 1 < nrOfArguments) {
+                std::istringstream numberstream(arguments[++i]);
+                if (!(numberstream >> tileSize) || tileSize < 0) {
+                    errorMessages += "Invalid --tileSize argument.\n";
+                }
             }
         }
+        else if (arg == "-pr" || arg == "--profile") {
+            //already read before the other arguments
+            if (i + 1 < nrOfArguments) i++;
+        }
+        else if (arg == "-tu" || arg == "--tune") {
+            tune = true;
+        }
         else if (arg == "-v" || arg == "--verbose") {
-            if (i + 1 < argc) {
-                std::string answer = argv[++i];
+            if (i + 1 < nrOfArguments) {
+                std::string answer = arguments[++i];
                 std::transform(answer.begin(), answer.end(), answer.begin(), [](unsigned char c){ return std::tolower(c); });
 
                 if (answer == "true" || answer == "y") verbose = true;
@@ -120,17 +408,19 @@ void CommandLineInterface::parseArguments() {
 
     validateInput(errorMessages);
 
-    if(!errorMessages.empty()) {
-        std::cout << termcolor::red << "Invalid, missing or unknown arguments are detected:\n" << errorMessages << termcolor::reset << "\n";
-        printHelp();
-        exit(1);
+    if (tune && (profilePath.empty() || profilePath == "none")) {
+        errorMessages += "--tune needs a --profile to save the settings to.\n";
+    }
+
+    if (profileLoaded) {
+        if (!errorMessages.empty()) errorMessages += "(the arguments of the profile " + profilePath + " were read first, --profile none ignores it)\n";
+        else printDebugInformation("Using the tuned settings from " + profilePath + "\n", MessageType::Information);
     }
 
+    return errorMessages;
 }
 
 bool CommandLineInterface::validateInput(std::string& errorMessages) {
-    errorMessages = "";
-
     bool valid = true;
 
     if (inputPath.empty()) {
@@ -159,7 +449,7 @@ bool CommandLineInterface::validateInput(std::string& errorMessages) {
         valid = false;
     }
 
-    if (numberOfThreads_adaptiveThresholding <= 0 || numberOfThreads_grayscaleConversion <= 0) {
+    if (numberOfThreads_adaptiveThresholding <= 0 || numberOfThreads_grayscaleConversion <= 0 || numberOfThreads_thresholding <= 0) {
         errorMessages += "Number of threads must be positive.\n";
         valid = false;
     }
@@ -321,6 +611,27 @@ void CommandLineInterface::startInteractiveMode() {
         }
     }
 
+    int threads_thresholding = 1;
+    while(true) {
+        std::cout << "Enter the number of threads that should be created when applying the threshold to a single image file (press enter for the default value of 1): ";
+        std::getline(std::cin, input);
+        if (input.empty()) {
+            numberOfThreads_thresholding = threads_thresholding;
+            break;
+        }
+        else {
+            std::istringstream percentstream(input);
+            if (! (percentstream >> threads_thresholding) || threads_thresholding < 0) {
+                std::cout << "Please enter a positive integer. \n";
+                continue;
+            }
+            else {
+                numberOfThreads_thresholding = threads_thresholding;
+                break;
+            }
+        }
+    }
+
     std::string answer;
     while(true) {
         std::cout << "Do you want the debug information to be printed? Y/n: \n";
@@ -383,6 +694,162 @@ void CommandLineInterface::setNumberOfThreads_grayscaleConversion(int number) {
     numberOfThreads_grayscaleConversion = number;
 }
 
+const int CommandLineInterface::getNumberOfThreads_thresholding() {
+    return numberOfThreads_thresholding;
+}
+
+void CommandLineInterface::setNumberOfThreads_thresholding(int number) {
+    numberOfThreads_thresholding = number;
+}
+
+const bool CommandLineInterface::getFuseGrayscaleAndIntegral() {
+    return fuseGrayscaleAndIntegral;
+}
+
+void CommandLineInterface::setFuseGrayscaleAndIntegral(bool mode) {
+    fuseGrayscaleAndIntegral = mode;
+}
+
+const bool CommandLineInterface::getStreamingThresholding() {
+    return streamingThresholding;
+}
+
+void CommandLineInterface::setStreamingThresholding(bool mode) {
+    streamingThresholding = mode;
+}
+
+const int CommandLineInterface::getIntegralWidth() {
+    return integralWidth;
+}
+
+void CommandLineInterface::setIntegralWidth(int bits) {
+    integralWidth = bits;
+}
+
+const bool CommandLineInterface::getPackedOutput() {
+    return packedOutput;
+}
+
+void CommandLineInterface::setPackedOutput(bool mode) {
+    packedOutput = mode;
+}
+
+const bool CommandLineInterface::getInPlace() {
+    return inPlace;
+}
+
+void CommandLineInterface::setInPlace(bool mode) {
+    inPlace = mode;
+}
+
+const bool CommandLineInterface::getLumaDecoding() {
+    return lumaDecoding;
+}
+
+void CommandLineInterface::setLumaDecoding(bool mode) {
+    lumaDecoding = mode;
+}
+
+const int CommandLineInterface::getDecodeScale() {
+    return decodeScale;
+}
+
+void CommandLineInterface::setDecodeScale(int denominator) {
+    decodeScale = denominator;
+}
+
+const int CommandLineInterface::getMemoryLimit() {
+    return memoryLimit;
+}
+
+void CommandLineInterface::setMemoryLimit(int megabytes) {
+    memoryLimit = megabytes;
+}
+
+const int CommandLineInterface::getPrefetchDistance() {
+    return prefetchDistance;
+}
+
+void CommandLineInterface::setPrefetchDistance(int files) {
+    prefetchDistance = files;
+}
+
+const bool CommandLineInterface::getIoUring() {
+    return ioUring;
+}
+
+void CommandLineInterface::setIoUring(bool mode) {
+    ioUring = mode;
+}
+
+const bool CommandLineInterface::getDirectOutput() {
+    return directOutput;
+}
+
+void CommandLineInterface::setDirectOutput(bool mode) {
+    directOutput = mode;
+}
+
+const std::vector<int> CommandLineInterface::getPipelineThreads() {
+    return pipelineThreads;
+}
+
+void CommandLineInterface::setPipelineThreads(const std::vector<int>& threads) {
+    pipelineThreads = threads;
+}
+
+const int CommandLineInterface::getQueueDepth() {
+    return queueDepth;
+}
+
+void CommandLineInterface::setQueueDepth(int images) {
+    queueDepth = images;
+}
+
+const bool CommandLineInterface::getLargestFirst() {
+    return largestFirst;
+}
+
+void CommandLineInterface::setLargestFirst(bool mode) {
+    largestFirst = mode;
+}
+
+const bool CommandLineInterface::getAdaptiveSplit() {
+    return adaptiveSplit;
+}
+
+void CommandLineInterface::setAdaptiveSplit(bool mode) {
+    adaptiveSplit = mode;
+}
+
+const int CommandLineInterface::getGrayscaleKernel() {
+    return grayscaleKernel;
+}
+
+void CommandLineInterface::setGrayscaleKernel(int instructionSet) {
+    grayscaleKernel = instructionSet;
+}
+
+const int CommandLineInterface::getThresholdingKernel() {
+    return thresholdingKernel;
+}
+
+void CommandLineInterface::setThresholdingKernel(int instructionSet) {
+    thresholdingKernel = instructionSet;
+}
+
+const int CommandLineInterface::getTileSize() {
+    return tileSize;
+}
+
+void CommandLineInterface::setTileSize(int pixels) {
+    tileSize = pixels;
+}
+
+const std::string CommandLineInterface::getProfilePath() {
+    return profilePath;
+}
+
 void CommandLineInterface::setVerbose(bool mode) {
     verbose = mode;
 }
@@ -391,6 +858,39 @@ bool CommandLineInterface::benchmarkMode() {
     return benchmark;
 }
 
+bool CommandLineInterface::tuneMode() {
+    return tune;
+}
+
+bool CommandLineInterface::saveProfile(const std::vector<std::string>& comments) {
+    auto flag = [](bool mode) { return std::string(mode ? "true" : "false"); };
+    auto kernel = [](int instructionSet, const char* name) {
+        if (instructionSet < 0) return std::string("auto");
+
+        //the names of the kernels without the dash, e.g. "AVX-512" -> "avx512"
+        std::string answer;
+        for (const char* c = name; *c; c++) if (*c != '-') answer += static_cast<char>(std::tolower(static_cast<unsigned char>(*c)));
+        return answer;
+    };
+
+    //-nt_g and -nt_t turn the adaptive split off, so it comes after them
+    std::vector<std::pair<std::string, std::string>> options{
+        {"--numberOfThreads_adaptiveThresholding", std::to_string(numberOfThreads_adaptiveThresholding)},
+        {"--numberOfThreads_grayscaleConversion", std::to_string(numberOfThreads_grayscaleConversion)},
+        {"--numberOfThreads_thresholding", std::to_string(numberOfThreads_thresholding)},
+        {"--adaptiveSplit", flag(adaptiveSplit)},
+        {"--integralWidth", integralWidth == 0 ? "auto" : std::to_string(integralWidth)},
+        {"--fuseGrayscaleAndIntegral", flag(fuseGrayscaleAndIntegral)},
+        {"--inPlace", flag(inPlace)},
+        {"--streamingThresholding", flag(streamingThresholding)},
+        {"--grayscaleKernel", kernel(grayscaleKernel, grayscaleKernel < 0 ? "" : GrayscaleKernels::name(static_cast<GrayscaleKernels::InstructionSet>(grayscaleKernel)))},
+        {"--thresholdingKernel", kernel(thresholdingKernel, thresholdingKernel < 0 ? "" : ThresholdKernels::name(static_cast<ThresholdKernels::InstructionSet>(thresholdingKernel)))},
+        {"--tileSize", std::to_string(tileSize)}
+    };
+
+    return TuningProfile::write(profilePath, comments, options);
+}
+
 
 //System-specific methods for Windows and Unix systems to get the console width.
 #ifdef WIN32
@@ -18,6 +18,10 @@ public:
 
     void parseArguments();
 
+    //Reads the arguments of the profile and then the given ones into the settings. Returns the messages of all invalid, missing or
+    //unknown arguments, empty if there are none (parseArguments() prints them and exits).
+    std::string parseArguments(int argc, char** argv);
+
     const std::string getInputPath();
     const void setInputPath(std::string path);
     const std::string getOutputDirectory();
@@ -28,9 +32,52 @@ public:
     void setNumberOfThreads_adaptiveThresholding(int number);
     const int getNumberOfThreads_grayscaleConversion();
     void setNumberOfThreads_grayscaleConversion(int number);
+    const int getNumberOfThreads_thresholding();
+    void setNumberOfThreads_thresholding(int number);
     void setVerbose(bool mode);
+    const bool getFuseGrayscaleAndIntegral();
+    void setFuseGrayscaleAndIntegral(bool mode);
+    const bool getStreamingThresholding();
+    void setStreamingThresholding(bool mode);
+    const int getIntegralWidth();
+    void setIntegralWidth(int bits);
+    const bool getPackedOutput();
+    void setPackedOutput(bool mode);
+    const bool getInPlace();
+    void setInPlace(bool mode);
+    const bool getLumaDecoding();
+    void setLumaDecoding(bool mode);
+    const int getDecodeScale();
+    void setDecodeScale(int denominator);
+    const int getMemoryLimit();
+    void setMemoryLimit(int megabytes);
+    const int getPrefetchDistance();
+    void setPrefetchDistance(int files);
+    const bool getIoUring();
+    void setIoUring(bool mode);
+    const bool getDirectOutput();
+    void setDirectOutput(bool mode);
+    const std::vector<int> getPipelineThreads();
+    void setPipelineThreads(const std::vector<int>& threads);
+    const int getQueueDepth();
+    void setQueueDepth(int images);
+    const bool getLargestFirst();
+    void setLargestFirst(bool mode);
+    const bool getAdaptiveSplit();
+    void setAdaptiveSplit(bool mode);
+    const int getGrayscaleKernel();
+    void setGrayscaleKernel(int instructionSet);
+    const int getThresholdingKernel();
+    void setThresholdingKernel(int instructionSet);
+    const int getTileSize();
+    void setTileSize(int pixels);
+    const std::string getProfilePath();
 
     bool benchmarkMode();
+    bool tuneMode();
+
+    //Writes the settings that --tune sweeps over into the profile at getProfilePath(), below the comment lines.
+    bool saveProfile(const std::vector<std::string>& comments);
 
     //This function only prints if the user has set the "verbose" argument to true.
     enum MessageType{Error, Success, Information};
@@ -51,6 +98,62 @@ private:
     //OpenMP-related parameters
     int numberOfThreads_adaptiveThresholding;
     int numberOfThreads_grayscaleConversion;
+    int numberOfThreads_thresholding;
+
+    //Whether if the grayscale conversion and the integral image are computed in one pass (true) or with two separate calls (false)
+    bool fuseGrayscaleAndIntegral = true;
+
+    //Whether if the adaptive thresholding streams the rows through a sliding window instead of building a full integral image
+    bool streamingThresholding = false;
+
+    //Number of bits per element of the integral image (32 or 64), or 0 to pick 32 bits automatically whenever the window allows it
+    int integralWidth = 0;
+
+    //Whether if binarized images are stored with 1 bit per pixel (and saved as 1-bit PNGs)
+    bool packedOutput = false;
+
+    //Whether if images are converted and binarized inside their own buffer, which is shrunk after the grayscale conversion
+    bool inPlace = false;
+
+    //Whether if images are decoded straight into a single luma channel for the adaptive thresholding
+    bool lumaDecoding = true;
+
+    //JPEG files are decoded at 1/decodeScale of their size (1, 2, 4 or 8)
+    int decodeScale = 1;
+
+    //Memory limit in MB for binarizing an image in tiles, or 0 to binarize whole images
+    int memoryLimit = 0;
+
+    //Number of input files that are read into the page cache ahead of the workers, or 0 to turn the prefetching off
+    int prefetchDistance = 4;
+
+    //Whether if the files are read and written on a separate I/O thread with io_uring
+    bool ioUring = false;
+
+    //Whether if the output files are written with O_DIRECT (only with ioUring)
+    bool directOutput = false;
+
+    //Number of threads of the read, decode, process, encode and write stages of the pipeline, or empty to process the images without the pipeline
+    std::vector<int> pipelineThreads;
+
+    //Number of images the queues between the stages of the pipeline hold
+    int queueDepth = 4;
+
+    //Whether if the largest images (by their number of pixels) are processed first, instead of in the order of the directory
+    bool largestFirst = true;
+
+    //Whether if the number of threads of every image is chosen from the number of images left, instead of numberOfThreads_grayscaleConversion and numberOfThreads_thresholding
+    bool adaptiveSplit = true;
+
+    //The instruction sets of the grayscale and thresholding kernels (GrayscaleKernels::InstructionSet and ThresholdKernels::InstructionSet), or -1 for the best one of the CPU
+    int grayscaleKernel = -1;
+    int thresholdingKernel = -1;
+
+    //Largest size of the tiles of --memoryLimit in pixels, or 0 for tiles as large as the memory limit allows
+    int tileSize = 0;
+
+    //The profile with the settings found by --tune, which is read before the command line arguments, or "none"
+    std::string profilePath;
 
     //Verbose mode: whether if debugging information should be printed
     bool verbose = true;
@@ -58,11 +161,15 @@ private:
     //Benchmarking mode:
     bool benchmark = false;
 
+    //Tuning mode: whether if the settings are swept on a sample of the input folder and the fastest ones saved to the profile
+    bool tune = false;
+
     //Prints the expected syntax when the user provides invalid input:
     static void printHelp();
 
     void startInteractiveMode();
 
+    //Appends a message for every missing or invalid setting to errorMessages.
     bool validateInput(std::string& errorMessages);
 
     //This is for printing a command-line argument on the left, and its description on the right. It prevents the built-in word wrapping of the console from making things really hard to read.
@@ -2,6 +2,11 @@
 //This needs to be done exactly once, so we do it in a separate file here, and add this to our CMAKE target.
 
 //stb_image.h:
+//its temporary allocations come from a per-thread arena, the large buffers (and the decoded images) from the BufferPool.
+#include "DecodeArena.h"
+#define STBI_MALLOC(size)                       DecodeArena::allocate(size)
+#define STBI_REALLOC_SIZED(memory,oldSize,newSize) DecodeArena::reallocate(memory, oldSize, newSize)
+#define STBI_FREE(memory)                       DecodeArena::release(memory)
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
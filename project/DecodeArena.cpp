@@ -0,0 +1,167 @@
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+
+#include "DecodeArena.h"
+#include "BufferPool.h"
+#include "AlignedMemory.h"
+
+namespace {
+    //the same alignment as malloc gives
+    const size_t alignment = 16;
+    const size_t chunkSize = 1024 * 1024;
+
+    struct Chunk {
+        unsigned char* memory;
+        size_t size;
+    };
+
+    struct Arena {
+        std::vector<Chunk> chunks;
+        size_t currentChunk = 0;
+        unsigned char* top = nullptr;
+        unsigned char* end = nullptr;
+
+        //number of allocations that haven't been freed yet, the arena is reset when it drops to 0
+        size_t liveAllocations = 0;
+        unsigned char* lastAllocation = nullptr;
+
+        ~Arena() {
+            for (const Chunk& chunk : chunks) AlignedMemory::release(chunk.memory);
+        }
+
+        void useChunk(size_t index) {
+            currentChunk = index;
+            top = chunks[index].memory;
+            end = chunks[index].memory + chunks[index].size;
+        }
+
+        void* allocate(size_t bytes) {
+            //0 bytes still get their own address, stb treats nullptr as "out of memory"
+            size_t rounded = std::max(alignment, (bytes + alignment - 1) / alignment * alignment);
+
+            //move on to the next chunk (or a new one) when the current chunk is full
+            while (static_cast<size_t>(end - top) < rounded) {
+                if (currentChunk + 1 < chunks.size()) {
+                    useChunk(currentChunk + 1);
+                }
+                else {
+                    auto* memory = static_cast<unsigned char*>(AlignedMemory::allocate(alignment, std::max(chunkSize, rounded)));
+                    if (!memory) throw std::bad_alloc();
+                    chunks.push_back({memory, std::max(chunkSize, rounded)});
+                    useChunk(chunks.size() - 1);
+                }
+            }
+
+            lastAllocation = top;
+            top += rounded;
+            liveAllocations++;
+            return lastAllocation;
+        }
+
+        void reset() {
+            //a decode that needed more than one chunk gets them as one chunk the next time
+            if (chunks.size() > 1) {
+                size_t totalSize = 0;
+                for (const Chunk& chunk : chunks) {
+                    totalSize += chunk.size;
+                    AlignedMemory::release(chunk.memory);
+                }
+                chunks.clear();
+
+                auto* memory = static_cast<unsigned char*>(AlignedMemory::allocate(alignment, totalSize));
+                if (memory) chunks.push_back({memory, totalSize});
+            }
+
+            if (chunks.empty()) {
+                top = end = nullptr;
+                currentChunk = 0;
+            }
+            else {
+                useChunk(0);
+            }
+            lastAllocation = nullptr;
+        }
+
+        bool owns(const void* memory) const {
+            auto* address = static_cast<const unsigned char*>(memory);
+            for (const Chunk& chunk : chunks) {
+                if (address >= chunk.memory && address < chunk.memory + chunk.size) return true;
+            }
+            return false;
+        }
+    };
+
+    thread_local Arena arena;
+
+    std::atomic<uint64_t> arenaAllocations{0}, poolAllocations{0}, resets{0};
+}
+
+void* DecodeArena::allocate(size_t bytes) {
+    //stb is C code and reports a failed allocation with nullptr
+    try {
+        if (bytes >= largeAllocation) {
+            poolAllocations.fetch_add(1, std::memory_order_relaxed);
+            return BufferPool::acquire(bytes);
+        }
+
+        arenaAllocations.fetch_add(1, std::memory_order_relaxed);
+        return arena.allocate(bytes);
+    }
+    catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void* DecodeArena::reallocate(void* memory, size_t oldBytes, size_t newBytes) {
+    if (!memory) return allocate(newBytes);
+
+    if (arena.owns(memory)) {
+        //the last allocation can simply grow into the rest of its chunk
+        size_t rounded = (newBytes + alignment - 1) / alignment * alignment;
+        if (memory == arena.lastAllocation && newBytes < largeAllocation && rounded > 0 && static_cast<size_t>(arena.end - arena.lastAllocation) >= rounded) {
+            arena.top = arena.lastAllocation + rounded;
+            return memory;
+        }
+    }
+    else if (BufferPool::capacity(memory) >= newBytes) {
+        return memory;
+    }
+
+    void* moved = allocate(newBytes);
+    if (!moved) return nullptr;
+    std::memcpy(moved, memory, std::min(oldBytes, newBytes));
+    release(memory);
+    return moved;
+}
+
+void DecodeArena::release(void* memory) {
+    if (!memory) return;
+
+    if (arena.owns(memory)) {
+        if (--arena.liveAllocations == 0) {
+            arena.reset();
+            resets.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    else {
+        BufferPool::release(memory);
+    }
+}
+
+bool DecodeArena::owns(const void* memory) {
+    return arena.owns(memory);
+}
+
+DecodeArena::Statistics DecodeArena::getStatistics() {
+    return {arenaAllocations.load(), poolAllocations.load(), resets.load()};
+}
+
+void DecodeArena::resetStatistics() {
+    arenaAllocations = 0;
+    poolAllocations = 0;
+    resets = 0;
+}
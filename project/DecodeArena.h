@@ -0,0 +1,43 @@
+#ifndef ENHANCER_DECODEARENA_H
+#define ENHANCER_DECODEARENA_H
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+    This class is the allocator of stb_image (see CreateStbImplementations.cpp). Decoding one image makes many short-lived allocations
+    (the decoder state, Huffman tables, line buffers, the growing zlib output of PNGs...), which all end with the decode.
+
+    Small allocations are cut from a per-thread arena by moving a pointer forward; freeing them only counts them, and as soon as every
+    allocation of the arena has been freed (i.e. after a decode) the whole arena is reset for the next one. Large allocations, like the
+    component planes and the decoded image itself, come from the BufferPool, so the output of stb can be handed over to EnhancerImage as is.
+    Memory from the arena has to be freed on the thread that allocated it, which stb always does.
+*/
+
+class DecodeArena {
+public:
+    //Allocations of at least this size are taken from the BufferPool instead of the arena.
+    static constexpr size_t largeAllocation = 256 * 1024;
+
+    static void* allocate(size_t bytes);
+
+    //Grows or shrinks an allocation, the last allocation of the arena and pool buffers with enough room are resized in place.
+    static void* reallocate(void* memory, size_t oldBytes, size_t newBytes);
+
+    static void release(void* memory);
+
+    //Whether memory lies in the arena of the calling thread (and not in the BufferPool).
+    static bool owns(const void* memory);
+
+    //Counters over all threads since the last reset.
+    struct Statistics {
+        uint64_t arenaAllocations;
+        uint64_t poolAllocations;
+        uint64_t resets;
+    };
+
+    static Statistics getStatistics();
+    static void resetStatistics();
+};
+
+#endif //ENHANCER_DECODEARENA_H
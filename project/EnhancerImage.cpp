@@ -2,28 +2,335 @@
 #include <iostream>
 #include <algorithm>
 #include <cstdint> //for termcolor
-#include <omp.h>
 #include <filesystem>
+#include <vector>
+#include <cstring>
+#include <functional>
+#include <fstream>
+#include <climits>
 
 #include "EnhancerImage.h"
+#include "GrayscaleKernels.h"
+#include "StreamingThresholder.h"
+#include "TiledThresholder.h"
+#include "BilevelPNGWriter.h"
+#include "MappedFile.h"
+#include "ThresholdKernels.h"
+#include "BufferPool.h"
+#include "ThreadPool.h"
+#include "DecodeArena.h"
 #include "stb_image.h"
 #include "stb_image_write.h"
 #include "termcolor.hpp"
 
+namespace {
+    //The scale shift of stb for a decode scale of 1, 2, 4 or 8 (see stbi_set_jpeg_scale_shift).
+    int scaleShiftOf(int decodeScale) {
+        int scaleShift = 0;
+        while ((2 << scaleShift) <= decodeScale && scaleShift < 3) scaleShift++;
+        return scaleShift;
+    }
+
+    //stb hands the decoded rows to a C function, which passes them on to the std::function in user.
+    int forwardDecodedRow(void* user, int row, const stbi_uc* pixels) {
+        return (*static_cast<std::function<bool(int, const unsigned char*)>*>(user))(row, pixels) ? 1 : 0;
+    }
+
+    //stb_image_write hands the encoded file over in pieces.
+    void appendEncodedBytes(void* context, void* data, int size) {
+        auto* output = static_cast<std::vector<unsigned char>*>(context);
+        auto* bytes = static_cast<unsigned char*>(data);
+        output->insert(output->end(), bytes, bytes + size);
+    }
+
+    //Converts one row of source into grayscale; views whose rows are padded can be converted in whole SIMD blocks.
+    void convertRow(const ImageView& source, const ImageView& grayscale, int row) {
+        if (source.paddedRows && grayscale.paddedRows) GrayscaleKernels::convertPadded(source.row(row), grayscale.row(row), source.width, source.nrOfChannels);
+        else GrayscaleKernels::convert(source.row(row), grayscale.row(row), source.width, source.nrOfChannels);
+    }
+
+    //Shared by all integral image builders; the integral can be 64-bit or 32-bit. With 32 bits the sums wrap around,
+    //but the differences of four sums are still exact as long as the sum of the window fits into 32 bits (see integralFitsIn32Bits).
+    template<typename IntegralType>
+    void buildBandedIntegralImage(const ImageView& image, const ImageView& grayscale, IntegralType* integralImage, int nrOfThreads) {
+        int width = image.width, height = image.height;
+        if (nrOfThreads > height) nrOfThreads = height;
+        if (nrOfThreads < 1) nrOfThreads = 1;
+
+        //every band is a task of the thread pool, and the pool returns once all bands are done, which separates the phases.
+        ThreadPool& pool = ThreadPool::shared();
+        int nrOfBands = nrOfThreads;
+        auto firstRowOf = [height, nrOfBands](int band) { return static_cast<int>(static_cast<long long>(height) * band / nrOfBands); };
+
+        pool.run(nrOfBands, [&](int band) {
+            int firstRow = firstRowOf(band);
+            int lastRow = firstRowOf(band + 1);
+
+            //Phase 1: build the integral image of this band as if it was a separate image.
+            //Both the input and the output are walked row by row, so the memory is accessed sequentially.
+            for (int row = firstRow; row < lastRow; row++) {
+                const unsigned char* source;
+                if (image.nrOfChannels == 1) {
+                    source = image.row(row);
+                }
+                else {
+                    //convert the row first, it is still in the cache when it is summed up right after
+                    convertRow(image, grayscale, row);
+                    source = grayscale.row(row);
+                }
+
+                IntegralType* current = integralImage + static_cast<size_t>(row) * width;
+                IntegralType rowSum = 0;
+
+                if (row == firstRow) {
+                    for (int column = 0; column < width; column++) {
+                        rowSum += source[column];
+                        current[column] = rowSum;
+                    }
+                }
+                else {
+                    const IntegralType* above = current - width;
+                    for (int column = 0; column < width; column++) {
+                        rowSum += source[column];
+                        current[column] = rowSum + above[column];
+                    }
+                }
+            }
+        });
+
+        //Phase 2a: carry the sums down through the last rows of the bands, so that every band's last row holds its final value.
+        //Each column is independent, so the columns are shared among the threads.
+        pool.parallelFor(0, width, nrOfBands, [&](int column) {
+            for (int b = 1; b < nrOfBands; b++) {
+                size_t previousLastRow = static_cast<size_t>(firstRowOf(b)) - 1;
+                size_t currentLastRow = static_cast<size_t>(firstRowOf(b + 1)) - 1;
+                integralImage[currentLastRow * width + column] += integralImage[previousLastRow * width + column];
+            }
+        });
+
+        //Phase 2b: add the final sums of the row above the band to the remaining rows of the band.
+        pool.run(nrOfBands, [&](int band) {
+            int firstRow = firstRowOf(band);
+            int lastRow = firstRowOf(band + 1);
+
+            if (band > 0) {
+                const IntegralType* carry = integralImage + static_cast<size_t>(firstRow - 1) * width;
+                for (int row = firstRow; row < lastRow - 1; row++) {
+                    IntegralType* current = integralImage + static_cast<size_t>(row) * width;
+                    for (int column = 0; column < width; column++) {
+                        current[column] += carry[column];
+                    }
+                }
+            }
+        });
+    }
+
+    //Binarizes every pixel of the grayscale image by comparing it with the average of the window around it, using the integral image for the window sums.
+    //The result is written either into binarized (one byte per pixel) or, if it is not null, into packed (one bit per pixel).
+    //Every pixel is read before it is written, so binarized may be grayscale itself.
+    template<typename IntegralType>
+    void thresholdRows(const ImageView& grayscale, const IntegralType* integralImage, const ImageView& binarized, BilevelImage* packed,
+                       int halfWindow, double tresholdPercentage, int nrOfThreads) {
+        int width = grayscale.width, height = grayscale.height;
+        if (nrOfThreads > height) nrOfThreads = height;
+        if (nrOfThreads < 1) nrOfThreads = 1;
+
+        //The interior of the image are the rows and columns whose window never reaches over a border. There every window has
+        //(2 * halfWindow)^2 pixels and the comparison can be done with integers (see ThresholdKernels); only the border strips are clamped.
+        int firstInteriorRow = halfWindow, lastInteriorRow = height - halfWindow;
+        int firstInteriorColumn = halfWindow, lastInteriorColumn = width - halfWindow;
+        uint64_t nrOfPixelsInInteriorWindow = static_cast<uint64_t>(2 * halfWindow) * (2 * halfWindow);
+        ThresholdKernels::SumLimits sumLimits;
+        bool hasInterior = firstInteriorColumn < lastInteriorColumn && ThresholdKernels::buildSumLimits(nrOfPixelsInInteriorWindow, tresholdPercentage, sumLimits);
+
+        //Perform adaptive thresholding
+        //The rows are independent of each other, so every task of the thread pool gets a band of consecutive rows and walks them row by row.
+        ThreadPool::shared().run(nrOfThreads, [&](int band) {
+            //the packed output is first written into a row of bytes, and then packed into the bits of the row
+            std::vector<unsigned char> rowBuffer(packed ? width : 0);
+
+            int firstRow = static_cast<int>(static_cast<long long>(height) * band / nrOfThreads);
+            int lastRow = static_cast<int>(static_cast<long long>(height) * (band + 1) / nrOfThreads);
+            for(int row = firstRow; row < lastRow; row++) {
+                //these temporary variables will hold the coordinates of the four ends of our window.
+                //the vertical ends only depend on the row, so they are calculated once per row.
+                int y1 = row - halfWindow;
+                int y2 = row + halfWindow;
+
+                //check for image borders
+                if (y1 < 0) y1 = 0;
+                if (y2 >= height) y2 = height-1;
+
+                const IntegralType* integralRow1 = integralImage + static_cast<size_t>(y1) * width;
+                const IntegralType* integralRow2 = integralImage + static_cast<size_t>(y2) * width;
+                const unsigned char* grayscaleRow = grayscale.row(row);
+                unsigned char* binarizedRow = packed ? rowBuffer.data() : binarized.row(row);
+
+                //the clamped version for the border strips
+                auto thresholdBorder = [&](int firstColumn, int lastColumn) {
+                    for(int column = firstColumn; column < lastColumn; column++) {
+                        //Calculate the horizontal ends of the SxS window:
+                        int x1 = column - halfWindow;
+                        int x2 = column + halfWindow;
+
+                        //check for image borders
+                        if (x1 < 0) x1 = 0;
+                        if (x2 >= width) x2 = width-1;
+
+                        //this value will be used to calculate the avg. intensity of the pixels (64 bits, very large windows have more than 2^31 pixels)
+                        uint64_t nrOfPixelsInWindow = static_cast<uint64_t>(x2-x1) * static_cast<uint64_t>(y2-y1);
+
+                        //Calculate the sum of the window
+                        IntegralType intensitySum = integralRow2[x2] - integralRow1[x2] - integralRow2[x1] + integralRow1[x1];
+
+                        //Decide whether the pixel should be white or black
+                        //Criterium: Whether if the current pixel's brightness value is T percent higher than the average (-> white) or not (-> black)
+                        bool aboveThreshold = static_cast<uint64_t>(grayscaleRow[column] * nrOfPixelsInWindow) > static_cast<uint64_t>(intensitySum*(1.0-tresholdPercentage));
+                        binarizedRow[column] = aboveThreshold ? 255 : 0;
+                    }
+                };
+
+                if (hasInterior && row >= firstInteriorRow && row < lastInteriorRow) {
+                    thresholdBorder(0, firstInteriorColumn);
+                    ThresholdKernels::thresholdInterior(integralRow1, integralRow2, grayscaleRow, binarizedRow, firstInteriorColumn, lastInteriorColumn, halfWindow, sumLimits);
+                    thresholdBorder(lastInteriorColumn, width);
+                }
+                else {
+                    thresholdBorder(0, width);
+                }
+
+                if (packed) packed->packRow(row, binarizedRow);
+            }
+        });
+    }
+}
+
 //Constructor:
-EnhancerImage::EnhancerImage(const std::string& path) {
-    data = stbi_load(path.c_str(), &width, &height, &nrOfChannels, 0);
+EnhancerImage::EnhancerImage(const std::string& path) : EnhancerImage(path, Original) {}
+
+EnhancerImage::EnhancerImage(const std::string& path, LoadMode mode) : EnhancerImage(path, mode, 1) {}
+
+EnhancerImage::EnhancerImage(const std::string& path, LoadMode mode, int decodeScale) : EnhancerImage(path, mode, decodeScale, ImageAllocator::pool()) {}
 
-    if (!data) {
+EnhancerImage::EnhancerImage(const std::string& path, LoadMode mode, int decodeScale, ImageAllocator& allocator) : allocator(&allocator) {
+    //the scale is a per-thread setting of stb, images that are loaded on other threads at the same time keep their own.
+    stbi_set_jpeg_scale_shift_thread(scaleShiftOf(decodeScale));
+
+    //The file is decoded straight from a memory mapping, which saves stdio from copying it into the refill buffer of stb.
+    //stb converts to the requested number of channels while decoding, but reports the number of channels in the file.
+    unsigned char* decoded;
+    MappedFile file(path);
+    if (file.isOpen() && file.fitsIntoStb()) decoded = stbi_load_from_memory(file.data(), static_cast<int>(file.size()), &width, &height, &nrOfChannels, (mode == Luma) ? 1 : 0);
+    else decoded = stbi_load(path.c_str(), &width, &height, &nrOfChannels, (mode == Luma) ? 1 : 0);
+    if (mode == Luma) nrOfChannels = 1;
+
+    stbi_set_jpeg_scale_shift_thread(0);
+
+    if (decoded) {
+        adoptDecodedImage(decoded);
+    }
+    else {
         std::cerr << termcolor::red << "Image failed to load at path: " << path << termcolor::reset << std::endl;
     }
 }
 
+EnhancerImage::EnhancerImage(const unsigned char* file, size_t fileSize, LoadMode mode, int decodeScale)
+    : width(0), height(0), nrOfChannels(0), allocator(&ImageAllocator::pool()) {
+    stbi_set_jpeg_scale_shift_thread(scaleShiftOf(decodeScale));
+
+    unsigned char* decoded = nullptr;
+    if (file && fileSize <= static_cast<size_t>(INT_MAX)) decoded = stbi_load_from_memory(file, static_cast<int>(fileSize), &width, &height, &nrOfChannels, (mode == Luma) ? 1 : 0);
+    if (mode == Luma) nrOfChannels = 1;
+
+    stbi_set_jpeg_scale_shift_thread(0);
+
+    if (decoded) {
+        adoptDecodedImage(decoded);
+    }
+    else {
+        std::cerr << termcolor::red << "Image failed to load from memory" << termcolor::reset << std::endl;
+    }
+}
+
+EnhancerImage::EnhancerImage(int width, int height, int nrOfChannels) : EnhancerImage(width, height, nrOfChannels, ImageAllocator::pool()) {}
+
+EnhancerImage::EnhancerImage(int width, int height, int nrOfChannels, ImageAllocator& allocator)
+    : width(width), height(height), nrOfChannels(nrOfChannels), allocator(&allocator) {
+    data = allocateRows(nrOfChannels);
+    stride = rowStride(width, nrOfChannels);
+}
+
+EnhancerImage::EnhancerImage(EnhancerImage&& other) noexcept
+    : width(other.width), height(other.height), nrOfChannels(other.nrOfChannels),
+      data(other.data), stride(other.stride), allocator(other.allocator), bilevel(std::move(other.bilevel)) {
+    other.data = nullptr;
+    other.stride = 0;
+    other.width = other.height = 0;
+}
+
+EnhancerImage& EnhancerImage::operator=(EnhancerImage&& other) noexcept {
+    if (this != &other) {
+        //the current pixels go back to the allocator they came from, before the allocator is replaced
+        replaceData(nullptr, nrOfChannels);
+
+        width = other.width;
+        height = other.height;
+        nrOfChannels = other.nrOfChannels;
+        data = other.data;
+        stride = other.stride;
+        allocator = other.allocator;
+        bilevel = std::move(other.bilevel);
+
+        other.data = nullptr;
+        other.stride = 0;
+        other.width = other.height = 0;
+    }
+    return *this;
+}
+
 std::list<std::string> EnhancerImage::supportedFiletypes = {".jpg", ".png", ".bmp"};
 
 //Destructor:
 EnhancerImage::~EnhancerImage() {
-    stbi_image_free(data);
+    replaceData(nullptr, nrOfChannels);
+}
+
+size_t EnhancerImage::rowStride(int width, int nrOfChannels) {
+    size_t paddedRow = GrayscaleKernels::paddedSize(static_cast<size_t>(width), nrOfChannels);
+    return (paddedRow + 63) / 64 * 64;
+}
+
+unsigned char* EnhancerImage::allocateRows(int newNrOfChannels) {
+    return static_cast<unsigned char*>(allocator->allocate(rowStride(width, newNrOfChannels) * height));
+}
+
+void EnhancerImage::replaceData(unsigned char* newData, int newNrOfChannels) {
+    allocator->release(data);
+    data = newData;
+    nrOfChannels = newNrOfChannels;
+    stride = newData ? rowStride(width, newNrOfChannels) : 0;
+}
+
+void EnhancerImage::adoptDecodedImage(unsigned char* decoded) {
+    size_t rowBytes = static_cast<size_t>(width) * nrOfChannels;
+    stride = rowStride(width, nrOfChannels);
+
+    //Large images are decoded into BufferPool buffers (see DecodeArena), whose size class usually leaves room for the padding.
+    //Then the rows are moved to their place in the same buffer, starting with the last row, so no row is overwritten before it has moved.
+    if (allocator == &ImageAllocator::pool() && !DecodeArena::owns(decoded) && BufferPool::capacity(decoded) >= stride * height) {
+        for (int row = height - 1; row > 0; row--) {
+            std::memmove(decoded + row * stride, decoded + row * rowBytes, rowBytes);
+        }
+        data = decoded;
+        return;
+    }
+
+    //otherwise (small images from the arena of stb, other allocators) the rows are copied into a new buffer
+    data = allocateRows(nrOfChannels);
+    for (int row = 0; row < height; row++) {
+        std::memcpy(data + row * stride, decoded + row * rowBytes, rowBytes);
+    }
+    stbi_image_free(decoded);
 }
 
 bool EnhancerImage::extensionIsSupported(std::string extension) {
@@ -38,6 +345,30 @@ bool EnhancerImage::extensionIsSupported(std::string extension) {
     return false;
 }
 
+const unsigned char* EnhancerImage::getData() const {
+    return data;
+}
+
+size_t EnhancerImage::getStride() const {
+    return stride;
+}
+
+unsigned char* EnhancerImage::getRow(int row) {
+    return data + row * stride;
+}
+
+const unsigned char* EnhancerImage::getRow(int row) const {
+    return data + row * stride;
+}
+
+ImageView EnhancerImage::view() {
+    return {data, width, height, stride, nrOfChannels, true};
+}
+
+ImageView EnhancerImage::viewOf(unsigned char* rows, int rowsNrOfChannels) const {
+    return {rows, width, height, rowStride(width, rowsNrOfChannels), rowsNrOfChannels, true};
+}
+
 //Check if the image was loaded correctly:
 bool EnhancerImage::imageIsLoaded() {
     return (data == nullptr);
@@ -55,22 +386,51 @@ bool EnhancerImage::saveImage(const std::string& path, Filetype type) {
         std::cerr << e.what() << std::endl;
     }
 
+    //1-bit PNGs are compressed straight into the file, segment by segment
+    if (bilevel && type == png) return bilevel->savePNG(path);
+
+    std::vector<unsigned char> encoded;
+    if (!encodeImage(type, encoded)) return false;
+
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(encoded.data()), static_cast<std::streamsize>(encoded.size()));
+    return static_cast<bool>(file);
+}
+
+bool EnhancerImage::encodeImage(Filetype type, std::vector<unsigned char>& output) {
+    //1-bit images are saved as 1-bit PNGs directly, the other formats need one byte per pixel.
+    if (bilevel) {
+        if (type == png) return bilevel->encodePNG(output);
+        unpackBilevel();
+    }
+
+    //the PNG writer takes the stride, the JPG and BMP writers need the rows without padding
+    size_t rowBytes = static_cast<size_t>(width) * nrOfChannels;
+    unsigned char* packedRows = nullptr;
+    if (type != png && stride != rowBytes) {
+        packedRows = static_cast<unsigned char*>(allocator->allocate(rowBytes * height));
+        for (int row = 0; row < height; row++) std::memcpy(packedRows + row * rowBytes, getRow(row), rowBytes);
+    }
+    const unsigned char* pixels = packedRows ? packedRows : data;
+
     int result = 0;
 
     switch (type) {
         case jpg:
-            result = stbi_write_jpg(path.c_str(), width, height, nrOfChannels, data, 100);
+            result = stbi_write_jpg_to_func(appendEncodedBytes, &output, width, height, nrOfChannels, pixels, 100);
             break;
 
         case png:
-            result = stbi_write_png(path.c_str(), width, height, nrOfChannels, data, (width * nrOfChannels));
+            result = stbi_write_png_to_func(appendEncodedBytes, &output, width, height, nrOfChannels, data, static_cast<int>(stride));
             break;
 
         case bmp:
-            result = stbi_write_bmp(path.c_str(), width, height, nrOfChannels, data);
+            result = stbi_write_bmp_to_func(appendEncodedBytes, &output, width, height, nrOfChannels, pixels);
             break;
     }
 
+    allocator->release(packedRows);
+
     //From the stb header file:
     //...each function returns 0 on failure and non-0 on success.
     return result;  //0 is implicitly converted to "false"
@@ -79,126 +439,305 @@ bool EnhancerImage::saveImage(const std::string& path, Filetype type) {
 
 //Converts image to grayscale, single channel in parallel
 bool EnhancerImage::convertToGrayscale(int nrOfThreads) {
-    if (nrOfChannels < 3) {
+    if (nrOfChannels < 2) {
         std::cerr << termcolor::red << "Image can't be converted to grayscale (it may already be converted)"
                   << termcolor::reset << std::endl;
         return false;
     }
 
-    int grayscale_imageSize = width * height * 1;   //alpha channel of the original image will be discarded, if it exists.
-    auto *grayscale_data = new unsigned char[grayscale_imageSize];
+    //alpha channel of the original image will be discarded, if it exists.
+    auto *grayscale_data = allocateRows(1);
+    convertToGrayscale(view(), viewOf(grayscale_data, 1), nrOfThreads);
+
+// Release the memory used by the original image
+// Update image information
+    replaceData(grayscale_data, 1);
+
+    return true;
+}
 
-    int PixelsPerThread = (width * height) / nrOfThreads;
-    int LeftoverPixels = (width * height) % nrOfThreads;
+bool EnhancerImage::convertToGrayscale_inPlace(int nrOfThreads, bool shrinkBuffer) {
+    if (nrOfChannels < 2) {
+        std::cerr << termcolor::red << "Image can't be converted to grayscale (it may already be converted)"
+                  << termcolor::reset << std::endl;
+        return false;
+    }
 
-    omp_set_nested(1);
+    ImageView colour = view();
+    ImageView grayscale = viewOf(data, 1);
 
-#pragma omp parallel num_threads(nrOfThreads) firstprivate(PixelsPerThread)
-    {
-        int threadNum = omp_get_thread_num();
-        unsigned char *p = data + (threadNum * PixelsPerThread * nrOfChannels);
-        unsigned char *pg = grayscale_data + (threadNum * PixelsPerThread * 1);
+    //A grayscale row is never longer than its colour row and starts at or before it, and the kernels read every block before they
+    //write it, so a row can be converted onto itself. Rows that are converted at the same time must not overwrite colour rows that
+    //are still waiting, though: the grayscale rows up to lastRow end at lastRow * grayscale.stride, which has to stay below the colour
+    //row firstRow. So the rows are converted in waves, and as the grayscale rows are 2 to 4 times shorter, every wave is 2 to 4 times larger than the one before.
+    int firstRow = 0;
+    while (firstRow < height) {
+        int lastRow = (firstRow == 0) ? 1 : static_cast<int>(std::min<size_t>(height, firstRow * colour.stride / grayscale.stride));
 
-        // Assign leftover pixels to master thread
-        if (threadNum == 0) {
-            PixelsPerThread += LeftoverPixels;
-        }
+        ThreadPool::shared().parallelFor(firstRow, lastRow, nrOfThreads, [&](int row) {
+            convertRow(colour, grayscale, row);
+        });
 
-        //Two pointers, one iterates over the original picture, the other one over the new grayscale image.
-        for (int i = 0; i < PixelsPerThread; i ++) {
-            //Take the average of RGB values of the original picture's current pixel
-            //and assign it to the grayscale picture's current pixel.
-            *pg = static_cast<char>((*p + *(p+1) + *(p+2)) / nrOfChannels);
-            pg++;
-            p += nrOfChannels;
-        }
+        firstRow = lastRow;
     }
 
-// Release the memory used by the original image
-    stbi_image_free(data);
-
-// Update image information
-    data = grayscale_data;
     nrOfChannels = 1;
+    stride = grayscale.stride;
+
+    if (shrinkBuffer) {
+        //if shrinking fails with an exception, the buffer is gone and the image has to be empty
+        unsigned char* rows = data;
+        data = nullptr;
+        data = static_cast<unsigned char*>(allocator->shrink(rows, stride * height));
+    }
 
     return true;
 }
 
+void EnhancerImage::convertToGrayscale(const ImageView& source, const ImageView& grayscale, int nrOfThreads) {
+    //every task of the thread pool converts a band of consecutive rows
+    ThreadPool::shared().parallelFor(0, source.height, nrOfThreads, [&](int row) {
+        //the kernel for the best instruction set of this CPU was picked once, the first time it was used
+        convertRow(source, grayscale, row);
+    });
+}
 
-bool EnhancerImage::applyAdaptiveThresholding(int nrOfThreads_grayscaleConversion, double windowSize, double tresholdPercentage) {
-    //Adaptive thresholding works on grayscale images: check if the image is suitable first (convert if not)
-    if (nrOfChannels > 1) convertToGrayscale(nrOfThreads_grayscaleConversion);
 
-    //Create the integral image (sum of brightness values within a certain area)
-    auto *integralImage = new unsigned long [width*height];
+bool EnhancerImage::applyAdaptiveThresholding(int nrOfThreads_grayscaleConversion, int nrOfThreads_thresholding, double windowSize, double tresholdPercentage, const ThresholdingOptions& options) {
+    if (bilevel) unpackBilevel();
 
-    for(int column = 0; column < width; column++) {
-        unsigned long columnSum = 0;
+    //window variables
+    int windowSize_pixels = static_cast<int>(width * windowSize);   //determine the window size in pixels
+    int halfWindow = windowSize_pixels/2;
 
-        for(int row = 0; row < height; row++) {
-            int index = row*width + column;
+    //the 32-bit integral image is used whenever the window is small enough for it, a forced 32-bit mode also falls back to 64 bits otherwise.
+    bool use32Bits = (options.integralWidth != Bits64) && integralFitsIn32Bits(halfWindow);
 
-            columnSum += data[index];
-            if (column == 0) {
-                integralImage[index] = columnSum;
-            }
-            else {
-                integralImage[index] = columnSum + integralImage[index-1];
-            }
+    //the number of threads of every pass, which may change from pass to pass
+    auto threadsFor = [&options](int nrOfThreads) { return options.threadSplit ? options.threadSplit() : nrOfThreads; };
+
+    //the in-place conversion comes before the integral image is allocated, so that the buffer is already shrunk (if wanted) by then
+    if (options.inPlace && nrOfChannels > 1) convertToGrayscale_inPlace(threadsFor(nrOfThreads_grayscaleConversion), options.shrinkBuffer);
+
+    //the rest only differs in the type of the integral image
+    auto threshold = [&](auto* integralImage) {
+        //Create the integral image (sum of brightness values within a certain area)
+        if (options.fuseGrayscaleAndIntegral && nrOfChannels > 1) {
+            //convert and sum up the image in a single pass over the original pixels
+            auto *grayscale_data = allocateRows(1);
+            buildGrayscaleAndIntegralImage(view(), viewOf(grayscale_data, 1), integralImage, threadsFor(nrOfThreads_grayscaleConversion));
+
+            replaceData(grayscale_data, 1);
+        }
+        else {
+            //Adaptive thresholding works on grayscale images: check if the image is suitable first (convert if not)
+            if (nrOfChannels > 1) convertToGrayscale(threadsFor(nrOfThreads_grayscaleConversion));
+            buildIntegralImage(view(), integralImage, threadsFor(nrOfThreads_grayscaleConversion));
         }
-    }
 
-    //buffer for the new, binarized image:
-    auto binarized = new unsigned char[width * height];
+        //buffer for the new, binarized image; in place, the grayscale pixels are overwritten, as the integral image already holds the window sums
+        unsigned char* binarized = nullptr;
+        if (options.packedOutput) bilevel = std::make_unique<BilevelImage>(width, height);
+        else if (options.inPlace) binarized = data;
+        else binarized = allocateRows(1);
 
-    //window variables
-    int windowSize_pixels = static_cast<int>(width * windowSize);   //determine the window size in pixels
-    int halfWindow = windowSize_pixels/2;
-    int x1, x2, y1, y2;                                             //these temporary variables will hold the coordinates of the four ends of our window.
+        //Perform adaptive thresholding
+        thresholdRows(view(), integralImage, viewOf(binarized, 1), bilevel.get(), halfWindow, tresholdPercentage, threadsFor(nrOfThreads_thresholding));
 
-    //Perform adaptive thresholding
-    for(int column = 0; column < width; column++) {
-        for(int row = 0; row < height; row++) {
+        //give the integral image back, the next image of this thread will reuse it
+        allocator->release(integralImage);
 
-            int index = row*width + column;
+        //delete original image and replace it with the binarized version
+        if (binarized != data) replaceData(binarized, 1);
+    };
 
-            //Calculate the SxS window:
-            x1 = column - halfWindow;
-            x2 = column + halfWindow;
-            y1 = row - halfWindow;
-            y2 = row + halfWindow;
+    size_t nrOfPixels = static_cast<size_t>(width) * height;
+    if (use32Bits) threshold(static_cast<uint32_t*>(allocator->allocate(nrOfPixels * sizeof(uint32_t))));
+    else threshold(static_cast<uint64_t*>(allocator->allocate(nrOfPixels * sizeof(uint64_t))));
 
-            //check for image borders
-            if (x1 < 0) x1 = 0;
-            if (x2 >= width) x2 = width-1;
-            if (y1 < 0) y1 = 0;
-            if (y2 >= height) y2 = height-1;
+    return true;
+}
 
-            //this value will be used to calculate the avg. intensity of the pixels
-            int nrOfPixelsInWindow = (x2-x1) * (y2-y1);
+void EnhancerImage::binarizeView(const ImageView& source, const ImageView& binarized, double windowSize, double tresholdPercentage, int nrOfThreads, ImageAllocator& allocator) {
+    //same window as for a whole image of this width
+    int halfWindow = static_cast<int>(source.width * windowSize) / 2;
 
-            //Calculate the sum of the window
-            unsigned long intensitySum = integralImage[y2*width+x2] - integralImage[y1*width+x2] - integralImage[y2*width+x1] + integralImage[y1*width+x1];
+    auto threshold = [&](auto* integralImage) {
+        //colour views are converted into binarized first, which then holds the grayscale values until they are thresholded in place
+        buildGrayscaleAndIntegralImage(source, binarized, integralImage, nrOfThreads);
+        const ImageView& grayscale = (source.nrOfChannels > 1) ? binarized : source;
+        thresholdRows(grayscale, integralImage, binarized, nullptr, halfWindow, tresholdPercentage, nrOfThreads);
 
-            //Decide whether the pixel should be white or black
-            //Criterium: Whether if the current pixel's brightness value is T percent higher than the average (-> white) or not (-> black)
-            bool aboveThreshold = static_cast<unsigned long>(data[index] * static_cast<unsigned long>(nrOfPixelsInWindow)) > static_cast<unsigned long>(intensitySum*(1.0-tresholdPercentage));
+        allocator.release(integralImage);
+    };
 
-            if(aboveThreshold) {
-                binarized[index] = 255;
-            }
-            else {
-                binarized[index] = 0;
+    size_t nrOfPixels = static_cast<size_t>(source.width) * source.height;
+    if (integralFitsIn32Bits(halfWindow)) threshold(static_cast<uint32_t*>(allocator.allocate(nrOfPixels * sizeof(uint32_t))));
+    else threshold(static_cast<uint64_t*>(allocator.allocate(nrOfPixels * sizeof(uint64_t))));
+}
+
+bool EnhancerImage::binarizeTiled(const std::string& inputPath, const std::string& outputPath, LoadMode mode, int decodeScale,
+                                  double windowSize, double tresholdPercentage, size_t memoryLimit, int nrOfThreads, int maxTileSize) {
+    std::unique_ptr<BilevelPNGWriter> writer;
+    std::unique_ptr<TiledThresholder> thresholder;
+
+    //the writer and the thresholder are set up as soon as the size of the image is known
+    auto start = [&](int width, int height) {
+        //same window as in applyAdaptiveThresholding
+        int halfWindow = static_cast<int>(width * windowSize) / 2;
+
+        //the decoder holds one MCU row (at most 16 rows of 3 components) and the writer one segment, the tiles get the rest
+        size_t reserved = static_cast<size_t>(width) * 16 * 3 + BilevelPNGWriter::memoryUsage();
+        int tileSize = (memoryLimit > reserved) ? TiledThresholder::tileSizeFor(width, height, halfWindow, memoryLimit - reserved, nrOfThreads) : 0;
+        if (tileSize == 0) {
+            std::cerr << termcolor::red << "The memory limit is too small for the windows of " << width << "x" << height << " pixels of: " << inputPath << termcolor::reset << std::endl;
+            return false;
+        }
+        if (maxTileSize > 0) tileSize = std::min(tileSize, maxTileSize);
+
+        writer = std::make_unique<BilevelPNGWriter>(outputPath, width, height);
+        if (!writer->isOpen()) return false;
+
+        thresholder = std::make_unique<TiledThresholder>(width, height, halfWindow, tresholdPercentage, tileSize, nrOfThreads, [&](int /*row*/, const unsigned char* binarizedRow) {
+            writer->writeRow(binarizedRow);
+        });
+        return true;
+    };
+
+    //baseline JPEGs are decoded row by row, stb sets the size before it hands over the first row
+    int width = 0, height = 0;
+    bool startFailed = false;
+    std::function<bool(int, const unsigned char*)> pushDecodedRow = [&](int row, const unsigned char* pixels) {
+        if (row == 0 && !start(width, height)) {
+            startFailed = true;
+            return false;
+        }
+        thresholder->pushRow(pixels);
+        return true;
+    };
+
+    bool decodedInRows = false;
+    if (mode == Luma) {
+        //the pages of a mapped file belong to the page cache, which the system can always take back, so they don't count against the limit
+        MappedFile file(inputPath);
+
+        stbi_set_jpeg_scale_shift_thread(scaleShiftOf(decodeScale));
+        if (file.isOpen() && file.fitsIntoStb()) decodedInRows = stbi_load_jpeg_rows_from_memory(file.data(), static_cast<int>(file.size()), &width, &height, forwardDecodedRow, &pushDecodedRow);
+        else decodedInRows = stbi_load_jpeg_rows(inputPath.c_str(), &width, &height, forwardDecodedRow, &pushDecodedRow);
+        stbi_set_jpeg_scale_shift_thread(0);
+    }
+
+    if (startFailed) return false;
+
+    if (!decodedInRows) {
+        //a file that stb started to decode in rows is broken, the others (other formats, progressive JPEGs...) can't be decoded in rows at all
+        if (thresholder) {
+            std::cerr << termcolor::red << "Image failed to load at path: " << inputPath << termcolor::reset << std::endl;
+            return false;
+        }
+
+        //the whole image is loaded then, and only its rows are thresholded and encoded within the limit
+        EnhancerImage image(inputPath, mode, decodeScale);
+        if (!image.data || !start(image.width, image.height)) return false;
+
+        std::vector<unsigned char> grayscaleRow(image.nrOfChannels > 1 ? rowStride(image.width, 1) : 0);
+        for (int row = 0; row < image.height; row++) {
+            const unsigned char* source = image.getRow(row);
+
+            if (image.nrOfChannels > 1) {
+                GrayscaleKernels::convertPadded(source, grayscaleRow.data(), image.width, image.nrOfChannels);
+                source = grayscaleRow.data();
             }
+
+            thresholder->pushRow(source);
         }
     }
 
-    //free up dynamically allocated memory
-    delete[] integralImage;
+    return thresholder->isFinished() && writer->finish();
+}
+
+bool EnhancerImage::integralFitsIn32Bits(int halfWindow) {
+    //the window spans at most 2*halfWindow rows and columns of the integral image
+    uint64_t maximumWindowSum = static_cast<uint64_t>(2 * static_cast<uint64_t>(halfWindow)) * (2 * static_cast<uint64_t>(halfWindow)) * 255;
+    return maximumWindowSum <= UINT32_MAX;
+}
+
+bool EnhancerImage::applyAdaptiveThresholding_streaming(double windowSize, double tresholdPercentage, bool packedOutput) {
+    if (bilevel) unpackBilevel();
+
+    //window variables, same as in applyAdaptiveThresholding
+    int windowSize_pixels = static_cast<int>(width * windowSize);
+    int halfWindow = windowSize_pixels/2;
+
+    unsigned char* binarized = nullptr;
+    std::unique_ptr<BilevelImage> packed;
+    if (packedOutput) packed = std::make_unique<BilevelImage>(width, height);
+    else binarized = allocateRows(1);
+    ImageView binarizedView = viewOf(binarized, 1);
+
+    StreamingThresholder thresholder(width, height, halfWindow, tresholdPercentage, [&](int row, const unsigned char* binarizedRow) {
+        if (packed) packed->packRow(row, binarizedRow);
+        else std::copy(binarizedRow, binarizedRow + width, binarizedView.row(row));
+    });
+
+    //colour rows are converted into this buffer one at a time, it has the padding of an image row
+    std::vector<unsigned char> grayscaleRow(nrOfChannels > 1 ? rowStride(width, 1) : 0);
+
+    for (int row = 0; row < height; row++) {
+        const unsigned char* source = getRow(row);
+
+        if (nrOfChannels > 1) {
+            GrayscaleKernels::convertPadded(source, grayscaleRow.data(), width, nrOfChannels);
+            source = grayscaleRow.data();
+        }
+
+        thresholder.pushRow(source);
+    }
 
     //delete original image and replace it with the binarized version
-    stbi_image_free(data);
-    data = binarized;
+    replaceData(binarized, 1);
+    bilevel = std::move(packed);
 
     return true;
-}
\ No newline at end of file
+}
+
+bool EnhancerImage::isBilevel() const {
+    return bilevel != nullptr;
+}
+
+const BilevelImage* EnhancerImage::getBilevelImage() const {
+    return bilevel.get();
+}
+
+void EnhancerImage::unpackBilevel() {
+    auto *unpacked = allocateRows(1);
+    ImageView unpackedView = viewOf(unpacked, 1);
+    for (int row = 0; row < height; row++) bilevel->unpackRow(row, unpackedView.row(row));
+
+    replaceData(unpacked, 1);
+    bilevel.reset();
+}
+
+void EnhancerImage::buildIntegralImage(const ImageView& grayscale, uint64_t* integralImage, int nrOfThreads) {
+    buildBandedIntegralImage(grayscale, ImageView(), integralImage, nrOfThreads);
+}
+
+void EnhancerImage::buildIntegralImage(const ImageView& grayscale, uint32_t* integralImage, int nrOfThreads) {
+    buildBandedIntegralImage(grayscale, ImageView(), integralImage, nrOfThreads);
+}
+
+void EnhancerImage::buildGrayscaleAndIntegralImage(const ImageView& image, const ImageView& grayscale, uint64_t* integralImage, int nrOfThreads) {
+    buildBandedIntegralImage(image, grayscale, integralImage, nrOfThreads);
+}
+
+void EnhancerImage::buildGrayscaleAndIntegralImage(const ImageView& image, const ImageView& grayscale, uint32_t* integralImage, int nrOfThreads) {
+    buildBandedIntegralImage(image, grayscale, integralImage, nrOfThreads);
+}
+
+void EnhancerImage::thresholdWithIntegralImage(const ImageView& grayscale, const uint64_t* integralImage, const ImageView& binarized, int halfWindow, double tresholdPercentage, int nrOfThreads) {
+    thresholdRows(grayscale, integralImage, binarized, nullptr, halfWindow, tresholdPercentage, nrOfThreads);
+}
+
+void EnhancerImage::thresholdWithIntegralImage(const ImageView& grayscale, const uint32_t* integralImage, const ImageView& binarized, int halfWindow, double tresholdPercentage, int nrOfThreads) {
+    thresholdRows(grayscale, integralImage, binarized, nullptr, halfWindow, tresholdPercentage, nrOfThreads);
+}
@@ -3,37 +3,180 @@
 
 #include <string>
 #include <list>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <functional>
+
+#include "BilevelImage.h"
+#include "ImageAllocator.h"
+#include "ImageView.h"
 
 /*
 
 This class defines a custom type called "EnhancerImage" that stores the image data we read from the disk
 and it also has some additional core functionality related to those images - like converting images into grayscale etc.
+
+An image owns its pixels, so it can be moved (into containers, out of functions, from one stage to the next) but not copied.
+The pixels are stored row by row: every row starts at a 64-byte boundary, rows are getStride() bytes apart, and the bytes between
+the end of a row and the start of the next one are padding that the SIMD kernels may read and overwrite (see rowStride).
 */
 
 class EnhancerImage {
 public:
     int width, height, nrOfChannels;
 
+    //Original keeps the channels of the file, Luma decodes the file straight into a single grayscale (luma) channel.
+    //For JPEGs in Luma mode only the Y component is reconstructed; Cb/Cr are neither transformed, upsampled nor colour converted.
+    enum LoadMode {Original, Luma};
+
     //Constructor:
     EnhancerImage(const std::string& path);
+    EnhancerImage(const std::string& path, LoadMode mode);
+
+    //decodeScale 2, 4 or 8 decodes JPEG files at 1/decodeScale of their width and height with a reduced IDCT, which is much cheaper
+    //than decoding at full size and shrinking afterwards. Other file types are always loaded at full size.
+    EnhancerImage(const std::string& path, LoadMode mode, int decodeScale);
+
+    //All pixel buffers of the image, including the temporary ones, come from the allocator, which has to outlive the image.
+    EnhancerImage(const std::string& path, LoadMode mode, int decodeScale, ImageAllocator& allocator);
+
+    //Decodes a file that has already been read into memory (fileSize bytes at file), e.g. by AsyncFileIO.
+    EnhancerImage(const unsigned char* file, size_t fileSize, LoadMode mode, int decodeScale);
+
+    //An image with undefined pixels, to be filled through getRow().
+    EnhancerImage(int width, int height, int nrOfChannels);
+    EnhancerImage(int width, int height, int nrOfChannels, ImageAllocator& allocator);
+
+    //The pixels move along with the image, the moved-from image is empty (no data, 0x0 pixels).
+    EnhancerImage(EnhancerImage&& other) noexcept;
+    EnhancerImage& operator=(EnhancerImage&& other) noexcept;
+
+    EnhancerImage(const EnhancerImage&) = delete;
+    EnhancerImage& operator=(const EnhancerImage&) = delete;
 
     //Destructor:
     ~EnhancerImage();
 
     enum Filetype {jpg, png, bmp};
 
+    //Element type of the integral image. Automatic and Bits32 use 32 bits whenever the window is small enough for it (see integralFitsIn32Bits), and 64 bits otherwise.
+    enum IntegralWidth {Automatic, Bits32, Bits64};
+
+    //Implementation choices of applyAdaptiveThresholding, they don't change the binarized image.
+    struct ThresholdingOptions {
+        //Convert colour images into grayscale and sum them up in the same pass (see buildGrayscaleAndIntegralImage).
+        bool fuseGrayscaleAndIntegral = true;
+        IntegralWidth integralWidth = Automatic;
+        //Write the result into a 1 bit per pixel BilevelImage instead of one byte per pixel.
+        bool packedOutput = false;
+        //Convert into grayscale and binarize inside the buffer of the image instead of allocating buffers for the results
+        //(see convertToGrayscale_inPlace). Colour images are then converted in a pass of its own, before the integral image is built.
+        bool inPlace = false;
+        //After an in-place grayscale conversion, give the part of the buffer that only held colour pixels back to the system.
+        bool shrinkBuffer = false;
+        //If set, it is asked for the number of threads before every pass instead of using the given numbers, so that an image of a batch
+        //can get more threads once the other images are done (see BatchSchedule::threadsPerImage).
+        std::function<int()> threadSplit;
+    };
+
     static bool extensionIsSupported(std::string extension);
 
     bool imageIsLoaded();
 
     bool saveImage(const std::string& path, Filetype type);
 
+    //Appends the encoded file to output instead of writing it, e.g. to hand it to AsyncFileIO.
+    bool encodeImage(Filetype type, std::vector<unsigned char>& output);
+
+    //The rows are split into nrOfThreads bands, which run as tasks of the shared ThreadPool, so they never start threads of their own.
     bool convertToGrayscale(int nrOfThreads);
 
-    bool applyAdaptiveThresholding(int nrOfThreads_grayscaleConversion, double windowSize, double tresholdPercentage);
+    //Same as convertToGrayscale, but the grayscale rows are written into the front of the buffer that holds the colour image,
+    //so no second buffer is needed. With shrinkBuffer the rest of the buffer is given back to the allocator afterwards (see ImageAllocator::shrink).
+    bool convertToGrayscale_inPlace(int nrOfThreads, bool shrinkBuffer);
+
+    //nrOfThreads_grayscaleConversion is also used for building the integral image, nrOfThreads_thresholding for the per-pixel thresholding pass.
+    bool applyAdaptiveThresholding(int nrOfThreads_grayscaleConversion, int nrOfThreads_thresholding, double windowSize, double tresholdPercentage, const ThresholdingOptions& options);
+
+    //Gives the same result as applyAdaptiveThresholding, but streams the rows through a StreamingThresholder instead of building a full integral image.
+    //Every row is converted into grayscale just before it is pushed, so only the output and a few rows per window are allocated next to the original image.
+    bool applyAdaptiveThresholding_streaming(double windowSize, double tresholdPercentage, bool packedOutput);
+
+    //A binarized image can be held with one bit per pixel (after thresholding with packedOutput). getData() returns nullptr in that case.
+    bool isBilevel() const;
+    const BilevelImage* getBilevelImage() const;
+
+    //The functions below work on views, so they can process a whole image as well as any rectangle of one. A rectangle is treated
+    //as an image on its own: its windows end at its borders, and pixels outside of it are neither read nor written.
+
+    //Converts source (1 to 4 channels) into grayscale, a single channel view of the same size.
+    static void convertToGrayscale(const ImageView& source, const ImageView& grayscale, int nrOfThreads);
+
+    //Fills integralImage (width*height elements) with the summed-area table of a single channel view, in row-major order without padding.
+    //The rows are split into one band per thread: each band is summed up on its own, then the bands are corrected with the sums of the bands above them.
+    static void buildIntegralImage(const ImageView& grayscale, uint64_t* integralImage, int nrOfThreads);
+    static void buildIntegralImage(const ImageView& grayscale, uint32_t* integralImage, int nrOfThreads);
+
+    //Same as buildIntegralImage, but for an interleaved view with 2 to 4 channels: every row is converted into grayscale (a single channel view of
+    //the same size) and summed up right away, so the original image is only read once. With 1 channel the image is summed up directly and grayscale is not used.
+    static void buildGrayscaleAndIntegralImage(const ImageView& image, const ImageView& grayscale, uint64_t* integralImage, int nrOfThreads);
+    static void buildGrayscaleAndIntegralImage(const ImageView& image, const ImageView& grayscale, uint32_t* integralImage, int nrOfThreads);
+
+    //Binarizes a single channel view with its integral image into binarized, a single channel view of the same size (which may be grayscale itself).
+    static void thresholdWithIntegralImage(const ImageView& grayscale, const uint64_t* integralImage, const ImageView& binarized, int halfWindow, double tresholdPercentage, int nrOfThreads);
+    static void thresholdWithIntegralImage(const ImageView& grayscale, const uint32_t* integralImage, const ImageView& binarized, int halfWindow, double tresholdPercentage, int nrOfThreads);
+
+    //All of the adaptive thresholding for one view: source (1 to 4 channels) is binarized into binarized, a single channel view of the same size,
+    //which may be source itself if that has a single channel. The window is windowSize times the width of the view, and the integral image
+    //is taken from allocator. Gives the same pixels as applyAdaptiveThresholding on an image with the contents of the view.
+    static void binarizeView(const ImageView& source, const ImageView& binarized, double windowSize, double tresholdPercentage, int nrOfThreads, ImageAllocator& allocator);
+
+    //Binarizes the image file at inputPath into a 1-bit PNG file at outputPath, with the same pixels as applyAdaptiveThresholding, without ever
+    //holding the whole image: the rows are decoded one by one, binarized in overlapping tiles (see TiledThresholder) and compressed into the
+    //PNG file as they come out (see BilevelPNGWriter). The tiles are as large as memoryLimit bytes allow. Only baseline JPEG files in Luma mode
+    //can be decoded row by row (see stbi_load_jpeg_rows), the other files are loaded as a whole first and have to fit into memory next to the tiles.
+    //With maxTileSize > 0 the tiles are at most that many pixels wide and high, even if the memory would allow larger ones (see --tileSize).
+    static bool binarizeTiled(const std::string& inputPath, const std::string& outputPath, LoadMode mode, int decodeScale,
+                              double windowSize, double tresholdPercentage, size_t memoryLimit, int nrOfThreads, int maxTileSize = 0);
+
+    //A 32-bit integral image wraps around, but still gives exact window sums as long as the largest possible window sum (255 per pixel) fits into 32 bits.
+    static bool integralFitsIn32Bits(int halfWindow);
+
+    //The distance between two rows of an image with this width and number of channels: a row is rounded up to whole blocks of
+    //GrayscaleKernels::paddingBlock pixels (plus the bytes a kernel reads past a block), and then to a multiple of 64 bytes.
+    static size_t rowStride(int width, int nrOfChannels);
+
+    //The first row of the image; nullptr if the image failed to load or holds a bilevel image.
+    const unsigned char* getData() const;
+    size_t getStride() const;
+
+    unsigned char* getRow(int row);
+    const unsigned char* getRow(int row) const;
+
+    //A view of all pixels of the image; use ImageView::region for a rectangle. Changing the image (converting, thresholding) invalidates its views.
+    ImageView view();
 
 private:
-    unsigned char* data;
+    unsigned char* data = nullptr;
+    size_t stride = 0;
+    ImageAllocator* allocator;
+    std::unique_ptr<BilevelImage> bilevel;
+
+    //A buffer from the allocator for all rows of an image of this size with the given number of channels.
+    unsigned char* allocateRows(int newNrOfChannels);
+
+    //A view of a buffer from allocateRows.
+    ImageView viewOf(unsigned char* rows, int rowsNrOfChannels) const;
+
+    //Gives the current image data back to the allocator and takes over newData, whose rows have the stride of newNrOfChannels channels.
+    void replaceData(unsigned char* newData, int newNrOfChannels);
+
+    //Takes over the tightly packed output of stb and spreads its rows out to the padded layout.
+    void adoptDecodedImage(unsigned char* decoded);
+
+    //Turns a bilevel image back into a regular single channel image with one byte per pixel.
+    void unpackBilevel();
     static std::list<std::string> supportedFiletypes;
 
 };
@@ -0,0 +1,109 @@
+#include <algorithm>
+
+#include "FilePrefetcher.h"
+
+#ifndef WIN32
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+FilePrefetcher::FilePrefetcher(const std::vector<std::filesystem::path>& files, int distance) : files(files), distance(std::max(distance, 0)) {
+    if (this->distance == 0) return;
+
+    //the first files are needed right away, they are prefetched while the workers start up
+    prefetchTarget = std::min(this->distance, static_cast<int>(files.size()));
+    thread = std::thread(&FilePrefetcher::prefetchLoop, this);
+}
+
+FilePrefetcher::~FilePrefetcher() {
+    stop();
+}
+
+void FilePrefetcher::startFile(int index) {
+    if (isResident(files[index])) hits++;
+    else stalls++;
+
+    if (distance == 0) return;
+
+    //the workers may start on the files slightly out of order, the target only ever moves forward
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        prefetchTarget = std::max(prefetchTarget, std::min(index + 1 + distance, static_cast<int>(files.size())));
+    }
+    wakeUp.notify_one();
+}
+
+void FilePrefetcher::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeUp.notify_one();
+    if (thread.joinable()) thread.join();
+}
+
+FilePrefetcher::Statistics FilePrefetcher::getStatistics() const {
+    return {hits.load(), stalls.load(), prefetched.load()};
+}
+
+void FilePrefetcher::prefetchLoop() {
+    while (true) {
+        int index;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeUp.wait(lock, [this] { return stopping || prefetchedUntil < prefetchTarget; });
+            if (prefetchedUntil >= prefetchTarget) return;
+            index = prefetchedUntil++;
+        }
+
+        //the advice itself may have to wait for the disk queue, which is why it is given on this thread and not by the workers
+        prefetch(files[index]);
+        prefetched++;
+    }
+}
+
+void FilePrefetcher::prefetch(const std::filesystem::path& path) {
+#ifndef WIN32
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0) return;
+
+    //length 0 means the whole file; the kernel starts reading it into the page cache and returns
+    posix_fadvise(file, 0, 0, POSIX_FADV_WILLNEED);
+    close(file);
+#endif
+}
+
+bool FilePrefetcher::isResident(const std::filesystem::path& path) {
+#ifndef WIN32
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0) return false;
+
+    struct stat status;
+    bool resident = false;
+    if (fstat(file, &status) == 0 && S_ISREG(status.st_mode)) {
+        size_t length = static_cast<size_t>(status.st_size);
+        if (length == 0) {
+            resident = true;
+        }
+        else {
+            //mincore only looks at the page tables of a mapping, it doesn't read the file
+            void* mapping = mmap(nullptr, length, PROT_READ, MAP_SHARED, file, 0);
+            if (mapping != MAP_FAILED) {
+                size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+                std::vector<unsigned char> pages((length + pageSize - 1) / pageSize);
+                if (mincore(mapping, length, pages.data()) == 0) {
+                    resident = std::all_of(pages.begin(), pages.end(), [](unsigned char page) { return (page & 1) != 0; });
+                }
+                munmap(mapping, length);
+            }
+        }
+    }
+
+    close(file);
+    return resident;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,66 @@
+#ifndef ENHANCER_FILEPREFETCHER_H
+#define ENHANCER_FILEPREFETCHER_H
+
+#include <vector>
+#include <filesystem>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+
+/*
+    This class reads the input files of a batch into the page cache ahead of the workers, so that decoding doesn't have to wait for the disk.
+
+    The workers tell it which file they start on (startFile), and a background thread asks the kernel to read the next distance files
+    with posix_fadvise(POSIX_FADV_WILLNEED), which starts the reads asynchronously. Every file is only advised once.
+    When a worker starts on a file, the prefetcher checks with mincore whether all of its pages are already in memory (a hit), or whether
+    the decoder will have to wait for the disk (a stall).
+    On systems without posix_fadvise (Windows) the prefetcher does nothing and counts every file as a stall.
+*/
+
+class FilePrefetcher {
+public:
+    //A distance of 0 turns the prefetching off, the hits and stalls are counted anyway.
+    FilePrefetcher(const std::vector<std::filesystem::path>& files, int distance);
+    ~FilePrefetcher();
+
+    FilePrefetcher(const FilePrefetcher&) = delete;
+    FilePrefetcher& operator=(const FilePrefetcher&) = delete;
+
+    //Called by a worker before it loads files[index]; counts the file as a hit or a stall, and prefetches the files behind it.
+    void startFile(int index);
+
+    //Finishes the prefetches that have been requested so far and stops the background thread.
+    void stop();
+
+    struct Statistics {
+        uint64_t hits;         //files whose pages were all in memory when a worker started on them
+        uint64_t stalls;       //files that still had to be read (at least partly) from the disk
+        uint64_t prefetched;   //files that were advised to the kernel
+    };
+
+    Statistics getStatistics() const;
+
+    //Whether all pages of the file at path are in the page cache.
+    static bool isResident(const std::filesystem::path& path);
+
+private:
+    const std::vector<std::filesystem::path>& files;
+    int distance;
+
+    //files[0, prefetchedUntil) have been advised, the background thread advises up to (but not including) prefetchTarget
+    int prefetchedUntil = 0, prefetchTarget = 0;
+    bool stopping = false;
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    std::thread thread;
+
+    std::atomic<uint64_t> hits{0}, stalls{0}, prefetched{0};
+
+    void prefetchLoop();
+
+    static void prefetch(const std::filesystem::path& path);
+};
+
+#endif //ENHANCER_FILEPREFETCHER_H
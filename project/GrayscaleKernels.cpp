@@ -0,0 +1,293 @@
+#include <initializer_list>
+#include <atomic>
+
+#include "GrayscaleKernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+    #define ENHANCER_X86_KERNELS
+    #include <immintrin.h>
+#endif
+
+namespace {
+    //the kernel chosen with selectInstructionSet, or -1 for the best one
+    std::atomic<int> chosenInstructionSet{-1};
+
+    //Multiplier for the fixed-point division: (sum * reciprocal) >> 16 equals sum / 3 for every sum up to 3*255.
+    const int fixedPointReciprocal = (65536 + 3 - 1) / 3;
+
+    //Reference implementation, also used for the pixels that are left over after the SIMD loops.
+    //The channel count is a template parameter, so every layout gets its own fully unrolled loop that the compiler can vectorize.
+    template<int nrOfChannels>
+    void scalarKernel(const unsigned char* source, unsigned char* destination, size_t nrOfPixels) {
+        for (size_t i = 0; i < nrOfPixels; i++) {
+            if (nrOfChannels >= 3) {
+                //Take the average of RGB values of the original picture's current pixel
+                //and assign it to the grayscale picture's current pixel. The alpha channel is ignored.
+                destination[i] = static_cast<unsigned char>((source[0] + source[1] + source[2]) / 3);
+            }
+            else {
+                //grayscale and grayscale + alpha pixels already have their value in the first channel
+                destination[i] = source[0];
+            }
+            source += nrOfChannels;
+        }
+    }
+
+    //The same average for any number of channels above 4: the channels after r, g and b are ignored like the alpha channel.
+    void scalarKernel(const unsigned char* source, unsigned char* destination, size_t nrOfPixels, int nrOfChannels) {
+        for (size_t i = 0; i < nrOfPixels; i++) {
+            destination[i] = static_cast<unsigned char>((source[0] + source[1] + source[2]) / 3);
+            source += nrOfChannels;
+        }
+    }
+
+#ifdef ENHANCER_X86_KERNELS
+    //All SIMD kernels work on groups of 4 pixels inside a 128-bit lane:
+    //  1. 3-channel pixels are shuffled into 4-byte slots (r, g, b, 0), 4-channel pixels already have that layout,
+    //  2. maddubs + madd add up r, g and b (the weight of the 4th byte is 0) into one 32-bit sum per pixel,
+    //  3. the sums are packed to 16 bits, divided with a fixed-point multiply and packed to bytes.
+    //The 3-channel loads read 4 bytes past the last pixel of a block, so the loops stop 2 pixels early and leave those to the scalar kernel.
+    //With padded rows (see GrayscaleKernels::convertPadded) the loops simply run over the end of the row and there is no scalar tail.
+
+    template<int nrOfChannels, bool padded>
+    __attribute__((target("ssse3")))
+    void ssse3Kernel(const unsigned char* source, unsigned char* destination, size_t nrOfPixels) {
+        const __m128i expand = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        const __m128i weights = _mm_set1_epi32(0x00010101);
+        const __m128i ones = _mm_set1_epi16(1);
+        const __m128i reciprocal = _mm_set1_epi16(static_cast<short>(fixedPointReciprocal));
+        const size_t overread = (nrOfChannels == 3) ? 2 : 0;
+
+        size_t i = 0;
+        for (; padded ? i < nrOfPixels : i + 16 + overread <= nrOfPixels; i += 16) {
+            __m128i sums[4];
+            for (int k = 0; k < 4; k++) {
+                const unsigned char* p = source + (i + 4 * k) * nrOfChannels;
+                __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                if (nrOfChannels == 3) pixels = _mm_shuffle_epi8(pixels, expand);
+                sums[k] = _mm_madd_epi16(_mm_maddubs_epi16(pixels, weights), ones);
+            }
+
+            __m128i low = _mm_mulhi_epu16(_mm_packs_epi32(sums[0], sums[1]), reciprocal);
+            __m128i high = _mm_mulhi_epu16(_mm_packs_epi32(sums[2], sums[3]), reciprocal);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), _mm_packus_epi16(low, high));
+        }
+
+        if (!padded) scalarKernel<nrOfChannels>(source + i * nrOfChannels, destination + i, nrOfPixels - i);
+    }
+
+    template<int nrOfChannels, bool padded>
+    __attribute__((target("avx2")))
+    void avx2Kernel(const unsigned char* source, unsigned char* destination, size_t nrOfPixels) {
+        const __m256i expand = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                                                0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        const __m256i weights = _mm256_set1_epi32(0x00010101);
+        const __m256i ones = _mm256_set1_epi16(1);
+        const __m256i reciprocal = _mm256_set1_epi16(static_cast<short>(fixedPointReciprocal));
+        //the packs work inside the 128-bit lanes, this puts the 4-pixel groups back in order
+        const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+        const size_t overread = (nrOfChannels == 3) ? 2 : 0;
+
+        size_t i = 0;
+        for (; padded ? i < nrOfPixels : i + 32 + overread <= nrOfPixels; i += 32) {
+            __m256i sums[4];
+            for (int k = 0; k < 4; k++) {
+                const unsigned char* p = source + (i + 8 * k) * nrOfChannels;
+                __m256i pixels;
+                if (nrOfChannels == 3) {
+                    pixels = _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+                    pixels = _mm256_inserti128_si256(pixels, _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 12)), 1);
+                    pixels = _mm256_shuffle_epi8(pixels, expand);
+                }
+                else {
+                    pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+                }
+                sums[k] = _mm256_madd_epi16(_mm256_maddubs_epi16(pixels, weights), ones);
+            }
+
+            __m256i low = _mm256_mulhi_epu16(_mm256_packs_epi32(sums[0], sums[1]), reciprocal);
+            __m256i high = _mm256_mulhi_epu16(_mm256_packs_epi32(sums[2], sums[3]), reciprocal);
+            __m256i result = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(low, high), order);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), result);
+        }
+
+        if (!padded) scalarKernel<nrOfChannels>(source + i * nrOfChannels, destination + i, nrOfPixels - i);
+    }
+
+    template<int nrOfChannels, bool padded>
+    __attribute__((target("avx512f,avx512bw")))
+    void avx512Kernel(const unsigned char* source, unsigned char* destination, size_t nrOfPixels) {
+        const __m512i expand = _mm512_broadcast_i32x4(_mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1));
+        const __m512i weights = _mm512_set1_epi32(0x00010101);
+        const __m512i ones = _mm512_set1_epi16(1);
+        const __m512i reciprocal = _mm512_set1_epi16(static_cast<short>(fixedPointReciprocal));
+        const __m512i order = _mm512_setr_epi32(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+        const size_t overread = (nrOfChannels == 3) ? 2 : 0;
+
+        size_t i = 0;
+        for (; padded ? i < nrOfPixels : i + 64 + overread <= nrOfPixels; i += 64) {
+            __m512i sums[4];
+            for (int k = 0; k < 4; k++) {
+                const unsigned char* p = source + (i + 16 * k) * nrOfChannels;
+                __m512i pixels;
+                if (nrOfChannels == 3) {
+                    pixels = _mm512_castsi128_si512(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+                    pixels = _mm512_inserti32x4(pixels, _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 12)), 1);
+                    pixels = _mm512_inserti32x4(pixels, _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 24)), 2);
+                    pixels = _mm512_inserti32x4(pixels, _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 36)), 3);
+                    pixels = _mm512_shuffle_epi8(pixels, expand);
+                }
+                else {
+                    pixels = _mm512_loadu_si512(p);
+                }
+                sums[k] = _mm512_madd_epi16(_mm512_maddubs_epi16(pixels, weights), ones);
+            }
+
+            __m512i low = _mm512_mulhi_epu16(_mm512_packs_epi32(sums[0], sums[1]), reciprocal);
+            __m512i high = _mm512_mulhi_epu16(_mm512_packs_epi32(sums[2], sums[3]), reciprocal);
+            __m512i result = _mm512_permutexvar_epi32(order, _mm512_packus_epi16(low, high));
+            _mm512_storeu_si512(destination + i, result);
+        }
+
+        if (!padded) scalarKernel<nrOfChannels>(source + i * nrOfChannels, destination + i, nrOfPixels - i);
+    }
+#endif
+
+    //Picks the kernel of the instruction set for one pixel layout. The SIMD kernels only exist for the 3 and 4 channel layouts,
+    //the scalar loops of the 1 and 2 channel layouts are simple enough for the compiler to vectorize on its own.
+    template<int nrOfChannels, bool padded>
+    void convertLayout(GrayscaleKernels::InstructionSet instructionSet, const unsigned char* source, unsigned char* destination, size_t nrOfPixels) {
+#ifdef ENHANCER_X86_KERNELS
+        if constexpr (nrOfChannels >= 3) {
+            switch (instructionSet) {
+                case GrayscaleKernels::SSSE3:
+                    ssse3Kernel<nrOfChannels, padded>(source, destination, nrOfPixels);
+                    return;
+
+                case GrayscaleKernels::AVX2:
+                    avx2Kernel<nrOfChannels, padded>(source, destination, nrOfPixels);
+                    return;
+
+                case GrayscaleKernels::AVX512:
+                    avx512Kernel<nrOfChannels, padded>(source, destination, nrOfPixels);
+                    return;
+
+                default:
+                    break;
+            }
+        }
+#endif
+        (void) instructionSet;
+        scalarKernel<nrOfChannels>(source, destination, nrOfPixels);
+    }
+
+    template<bool padded>
+    void convertChannels(GrayscaleKernels::InstructionSet instructionSet, const unsigned char* source, unsigned char* destination, size_t nrOfPixels, int nrOfChannels) {
+        //the only run-time decision about the pixel layout, everything below is compiled separately for every channel count
+        switch (nrOfChannels) {
+            case 1:
+                convertLayout<1, padded>(instructionSet, source, destination, nrOfPixels);
+                return;
+
+            case 2:
+                convertLayout<2, padded>(instructionSet, source, destination, nrOfPixels);
+                return;
+
+            case 3:
+                convertLayout<3, padded>(instructionSet, source, destination, nrOfPixels);
+                return;
+
+            case 4:
+                convertLayout<4, padded>(instructionSet, source, destination, nrOfPixels);
+                return;
+
+            default:
+                //no SIMD kernel and no padding for these layouts, but every pixel is still converted
+                if (nrOfChannels > 4) scalarKernel(source, destination, nrOfPixels, nrOfChannels);
+                return;
+        }
+    }
+}
+
+void GrayscaleKernels::convert(const unsigned char* source, unsigned char* destination, size_t nrOfPixels, int nrOfChannels) {
+    convert(selectedInstructionSet(), source, destination, nrOfPixels, nrOfChannels);
+}
+
+void GrayscaleKernels::convert(InstructionSet instructionSet, const unsigned char* source, unsigned char* destination, size_t nrOfPixels, int nrOfChannels) {
+    convertChannels<false>(instructionSet, source, destination, nrOfPixels, nrOfChannels);
+}
+
+void GrayscaleKernels::convertPadded(const unsigned char* source, unsigned char* destination, size_t nrOfPixels, int nrOfChannels) {
+    convertPadded(selectedInstructionSet(), source, destination, nrOfPixels, nrOfChannels);
+}
+
+void GrayscaleKernels::convertPadded(InstructionSet instructionSet, const unsigned char* source, unsigned char* destination, size_t nrOfPixels, int nrOfChannels) {
+    convertChannels<true>(instructionSet, source, destination, nrOfPixels, nrOfChannels);
+}
+
+size_t GrayscaleKernels::paddedSize(size_t nrOfPixels, int nrOfChannels) {
+    size_t nrOfBlocks = (nrOfPixels + paddingBlock - 1) / paddingBlock;
+    return nrOfBlocks * paddingBlock * nrOfChannels + ((nrOfChannels == 3) ? 4 : 0);
+}
+
+bool GrayscaleKernels::isSupported(InstructionSet instructionSet) {
+#ifdef ENHANCER_X86_KERNELS
+    __builtin_cpu_init();
+
+    switch (instructionSet) {
+        case SSSE3:
+            return __builtin_cpu_supports("ssse3");
+
+        case AVX2:
+            return __builtin_cpu_supports("avx2");
+
+        case AVX512:
+            return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+
+        default:
+            return true;
+    }
+#else
+    return instructionSet == Scalar;
+#endif
+}
+
+GrayscaleKernels::InstructionSet GrayscaleKernels::selectedInstructionSet() {
+    int chosen = chosenInstructionSet.load(std::memory_order_relaxed);
+    return (chosen < 0) ? bestInstructionSet() : static_cast<InstructionSet>(chosen);
+}
+
+GrayscaleKernels::InstructionSet GrayscaleKernels::bestInstructionSet() {
+    //the static local is initialized exactly once, even if many threads get here at the same time
+    static const InstructionSet best = [] {
+        for (InstructionSet candidate : {AVX512, AVX2, SSSE3}) {
+            if (isSupported(candidate)) return candidate;
+        }
+        return Scalar;
+    }();
+
+    return best;
+}
+
+bool GrayscaleKernels::selectInstructionSet(InstructionSet instructionSet) {
+    if (!isSupported(instructionSet)) return false;
+
+    chosenInstructionSet.store(instructionSet, std::memory_order_relaxed);
+    return true;
+}
+
+const char* GrayscaleKernels::name(InstructionSet instructionSet) {
+    switch (instructionSet) {
+        case SSSE3:
+            return "SSSE3";
+
+        case AVX2:
+            return "AVX2";
+
+        case AVX512:
+            return "AVX-512";
+
+        default:
+            return "Scalar";
+    }
+}
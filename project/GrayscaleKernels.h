@@ -0,0 +1,52 @@
+#ifndef ENHANCER_GRAYSCALEKERNELS_H
+#define ENHANCER_GRAYSCALEKERNELS_H
+
+#include <cstddef>
+
+/*
+    This class contains the pixel loops that turn interleaved 1 to 4 channel data into a single grayscale channel.
+    For RGB and RGBA pixels the grayscale value is the average of red, green and blue; grayscale and grayscale + alpha pixels keep
+    their first channel. Alpha channels are dropped. Every pixel layout has its own kernels, compiled for its channel count.
+
+    There is one kernel for every instruction set we support. The SIMD kernels replace the integer division with a fixed-point multiply
+    (exact for every possible sum), and the best kernel for the running CPU is picked once, the first time it is needed.
+*/
+
+class GrayscaleKernels {
+public:
+    //The 128-bit kernel needs SSSE3 and not just SSE2, because SSE2 has no byte shuffle to take apart the 3-channel pixels.
+    //The AVX-512 kernel needs the AVX512BW extension for its byte and word instructions.
+    enum InstructionSet {Scalar, SSSE3, AVX2, AVX512};
+
+    //Converts nrOfPixels pixels from source (nrOfChannels bytes per pixel, at least 1; layouts with more than 4 channels always use the scalar loop) to destination (1 byte per pixel), using the best supported kernel.
+    static void convert(const unsigned char* source, unsigned char* destination, size_t nrOfPixels, int nrOfChannels);
+
+    //Same as above, but with an explicitly chosen kernel. The instruction set must be supported by the CPU.
+    static void convert(InstructionSet instructionSet, const unsigned char* source, unsigned char* destination, size_t nrOfPixels, int nrOfChannels);
+
+    //Same as convert, for rows that are followed by padding: source has to be readable for paddedSize(nrOfPixels, nrOfChannels) bytes
+    //and destination writable for paddedSize(nrOfPixels, 1) bytes. The SIMD kernels then process whole blocks up to the end of the
+    //padding instead of finishing the row with the scalar kernel; the padding bytes of destination are overwritten with undefined values.
+    static void convertPadded(const unsigned char* source, unsigned char* destination, size_t nrOfPixels, int nrOfChannels);
+    static void convertPadded(InstructionSet instructionSet, const unsigned char* source, unsigned char* destination, size_t nrOfPixels, int nrOfChannels);
+
+    //The largest block of pixels a kernel processes at once (the AVX-512 kernel).
+    static constexpr size_t paddingBlock = 64;
+
+    //The bytes convertPadded may touch for a row of nrOfPixels pixels: whole blocks, plus the 4 bytes the 3-channel loads read past a block.
+    static size_t paddedSize(size_t nrOfPixels, int nrOfChannels);
+
+    static bool isSupported(InstructionSet instructionSet);
+
+    //The instruction set that convert() uses: the best one for this CPU (determined from CPUID on the first call), unless another one was selected.
+    static InstructionSet selectedInstructionSet();
+    static InstructionSet bestInstructionSet();
+
+    //Makes convert() use the given kernel, e.g. the one a tuned profile found to be the fastest (see --grayscaleKernel).
+    //Returns false, and keeps the current kernel, if the CPU doesn't support the instruction set.
+    static bool selectInstructionSet(InstructionSet instructionSet);
+
+    static const char* name(InstructionSet instructionSet);
+};
+
+#endif //ENHANCER_GRAYSCALEKERNELS_H
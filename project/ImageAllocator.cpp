@@ -0,0 +1,25 @@
+#include "ImageAllocator.h"
+#include "BufferPool.h"
+
+namespace {
+    class PoolAllocator : public ImageAllocator {
+    public:
+        void* allocate(size_t bytes) override {
+            return BufferPool::acquire(bytes);
+        }
+
+        void release(void* memory) override {
+            BufferPool::release(memory);
+        }
+
+        void* shrink(void* memory, size_t bytes) override {
+            return BufferPool::shrink(memory, bytes);
+        }
+    };
+}
+
+ImageAllocator& ImageAllocator::pool() {
+    //stateless, so a single instance serves every thread
+    static PoolAllocator allocator;
+    return allocator;
+}
@@ -0,0 +1,33 @@
+#ifndef ENHANCER_IMAGEALLOCATOR_H
+#define ENHANCER_IMAGEALLOCATOR_H
+
+#include <cstddef>
+
+/*
+    This class is the interface EnhancerImage gets its pixel buffers (and the integral images) from, so that a caller can decide where the
+    memory of its images comes from. The default allocator takes the buffers from the BufferPool; it is also the only allocator whose
+    buffers stb decodes into, so only images that use it take over the decoded pixels without a copy.
+*/
+
+class ImageAllocator {
+public:
+    virtual ~ImageAllocator() = default;
+
+    //Returns 64-byte aligned memory of at least the given size, with undefined contents. Throws std::bad_alloc if there is no memory left.
+    virtual void* allocate(size_t bytes) = 0;
+
+    //Gives memory from allocate() back. nullptr is ignored.
+    virtual void release(void* memory) = 0;
+
+    //Makes memory from allocate() as small as bytes, keeping its contents, and returns where it is now (which is still 64-byte aligned).
+    //Allocators that can't do that keep the memory as it is.
+    virtual void* shrink(void* memory, size_t bytes) {
+        (void) bytes;
+        return memory;
+    }
+
+    //The allocator backed by the BufferPool, which every image uses unless it is given another one.
+    static ImageAllocator& pool();
+};
+
+#endif //ENHANCER_IMAGEALLOCATOR_H
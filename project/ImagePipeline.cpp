@@ -0,0 +1,161 @@
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+#include "ImagePipeline.h"
+
+ImagePipeline::ImagePipeline(const Options& options, ProcessFunction process, ResultCallback resultCallback)
+        : options(options), process(std::move(process)), resultCallback(std::move(resultCallback)) {
+    for (int stage = 0; stage < nrOfStages; stage++) {
+        this->options.threads[stage] = std::max(this->options.threads[stage], 1);
+        busyNanoseconds[stage] = 0;
+        images[stage] = 0;
+    }
+    this->options.queueDepth = std::max<size_t>(this->options.queueDepth, 1);
+}
+
+void ImagePipeline::run(const std::vector<std::filesystem::path>& files) {
+    queues.clear();
+    for (int stage = 0; stage < nrOfStages - 1; stage++) queues.push_back(std::make_unique<Queue>(options.queueDepth));
+    for (int stage = 0; stage < nrOfStages; stage++) {
+        busyNanoseconds[stage] = 0;
+        images[stage] = 0;
+    }
+
+    auto startingTime = std::chrono::steady_clock::now();
+
+    //the read stage takes the files from the list, the last thread of a stage to finish closes the queue behind it
+    std::atomic<size_t> nextFile{0};
+    std::atomic<int> runningThreads[nrOfStages];
+    std::vector<std::thread> threads;
+    for (int stage = 0; stage < nrOfStages; stage++) {
+        runningThreads[stage] = options.threads[stage];
+        for (int thread = 0; thread < options.threads[stage]; thread++) {
+            threads.emplace_back(&ImagePipeline::runThread, this, static_cast<Stage>(stage), std::cref(files), std::ref(nextFile), std::ref(runningThreads[stage]));
+        }
+    }
+
+    for (std::thread& thread : threads) thread.join();
+    runSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startingTime).count();
+}
+
+void ImagePipeline::runThread(Stage stage, const std::vector<std::filesystem::path>& files, std::atomic<size_t>& nextFile, std::atomic<int>& runningThreads) {
+    Queue* input = (stage == Read) ? nullptr : queues[stage - 1].get();
+    Queue* output = (stage == Write) ? nullptr : queues[stage].get();
+
+    while (true) {
+        std::unique_ptr<Item> item;
+        if (stage == Read) {
+            size_t index = nextFile++;
+            if (index >= files.size()) break;
+            item = std::make_unique<Item>();
+            item->input = files[index];
+        }
+        else if (!input->pop(item)) {
+            break;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        work(stage, *item);
+        busyNanoseconds[stage] += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        images[stage]++;
+
+        //waits while the next stage is behind
+        if (output) output->push(std::move(item));
+    }
+
+    if (--runningThreads == 0 && output) output->close();
+}
+
+void ImagePipeline::work(Stage stage, Item& item) {
+    //an image that failed in one stage is passed through the others, so that the write stage can report it
+    switch (stage) {
+        case Read: {
+            std::ifstream file(item.input, std::ios::binary | std::ios::ate);
+            std::streamsize fileSize = file ? static_cast<std::streamsize>(file.tellg()) : -1;
+            if (fileSize <= 0) {
+                item.failed = true;
+                break;
+            }
+
+            item.file.resize(static_cast<size_t>(fileSize));
+            file.seekg(0);
+            item.failed = !file.read(reinterpret_cast<char*>(item.file.data()), fileSize);
+            break;
+        }
+
+        case Decode:
+            if (item.failed) break;
+            item.image = std::make_unique<EnhancerImage>(item.file.data(), item.file.size(), options.loadMode, options.decodeScale);
+            std::vector<unsigned char>().swap(item.file);
+            item.failed = (item.image->getData() == nullptr);
+            break;
+
+        case Process:
+            if (item.failed) break;
+            item.failed = !process(*item.image, item.input, item.output, item.outputType);
+            break;
+
+        case Encode:
+            if (item.failed) break;
+            item.failed = !item.image->encodeImage(item.outputType, item.encoded);
+            item.image.reset();
+            break;
+
+        case Write: {
+            if (!item.failed) {
+                std::ofstream file(item.output, std::ios::binary);
+                file.write(reinterpret_cast<const char*>(item.encoded.data()), static_cast<std::streamsize>(item.encoded.size()));
+                file.close();
+                item.failed = file.fail();
+            }
+            std::vector<unsigned char>().swap(item.encoded);
+
+            if (resultCallback) resultCallback(item.input, item.output, !item.failed);
+            break;
+        }
+    }
+}
+
+ImagePipeline::StageStatistics ImagePipeline::getStageStatistics(Stage stage) const {
+    double busySeconds = busyNanoseconds[stage].load() / 1e9;
+    double utilization = runSeconds > 0 ? busySeconds / (options.threads[stage] * runSeconds) : 0.0;
+    return {options.threads[stage], images[stage].load(), busySeconds, utilization};
+}
+
+BoundedQueueStatistics ImagePipeline::getQueueStatistics(Stage stage) const {
+    if (stage >= static_cast<int>(queues.size())) return {};
+    return queues[stage]->getStatistics();
+}
+
+const char* ImagePipeline::name(Stage stage) {
+    switch (stage) {
+        case Read: return "read";
+        case Decode: return "decode";
+        case Process: return "process";
+        case Encode: return "encode";
+        case Write: return "write";
+    }
+    return "";
+}
+
+bool ImagePipeline::parseThreadCounts(const std::string& text, int threads[nrOfStages]) {
+    std::istringstream list(text);
+    std::string count;
+    int parsed[nrOfStages];
+    int stage = 0;
+
+    while (std::getline(list, count, ',')) {
+        if (stage == nrOfStages) return false;
+
+        std::istringstream numberstream(count);
+        if (!(numberstream >> parsed[stage]) || !numberstream.eof() || parsed[stage] < 1) return false;
+        stage++;
+    }
+    if (stage != nrOfStages) return false;
+
+    std::copy(parsed, parsed + nrOfStages, threads);
+    return true;
+}
@@ -0,0 +1,103 @@
+#ifndef ENHANCER_IMAGEPIPELINE_H
+#define ENHANCER_IMAGEPIPELINE_H
+
+#include <vector>
+#include <string>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+
+#include "EnhancerImage.h"
+#include "BoundedQueue.h"
+
+/*
+    This class processes a batch of image files in a pipeline of five stages, each of which runs on threads of its own:
+    reading the files into memory, decoding them, processing the images (the thresholding or grayscale conversion), encoding the results
+    and writing them to the disk.
+
+    The stages are connected by bounded queues (see BoundedQueue), so the I/O stages keep reading and writing while the CPU-bound stages
+    work, and a stage that falls behind makes the stages in front of it wait instead of filling the memory with images. Every stage
+    counts the time its threads were busy, and every queue how full it was, so the slowest stage of a run can be found and given more threads.
+*/
+
+class ImagePipeline {
+public:
+    enum Stage {Read, Decode, Process, Encode, Write};
+    static const int nrOfStages = 5;
+
+    struct Options {
+        //number of threads of every stage
+        int threads[nrOfStages] = {1, 1, 1, 1, 1};
+
+        //number of images a queue between two stages holds (rounded up to a power of two, at least 2)
+        size_t queueDepth = 4;
+
+        EnhancerImage::LoadMode loadMode = EnhancerImage::Original;
+        int decodeScale = 1;
+    };
+
+    //Processes a decoded image and chooses the path and the file type of its result. Returns false if the image couldn't be processed.
+    using ProcessFunction = std::function<bool(EnhancerImage& image, const std::filesystem::path& input, std::filesystem::path& output, EnhancerImage::Filetype& outputType)>;
+
+    //Called by the write stage for every file once it is done; output is empty if the image failed before it was processed.
+    using ResultCallback = std::function<void(const std::filesystem::path& input, const std::filesystem::path& output, bool success)>;
+
+    ImagePipeline(const Options& options, ProcessFunction process, ResultCallback resultCallback);
+
+    ImagePipeline(const ImagePipeline&) = delete;
+    ImagePipeline& operator=(const ImagePipeline&) = delete;
+
+    //Runs all files through the pipeline and returns once the last one is written.
+    void run(const std::vector<std::filesystem::path>& files);
+
+    struct StageStatistics {
+        int threads;
+        uint64_t images;
+        double busySeconds;   //summed over the threads of the stage
+        double utilization;   //busy time / (threads * duration of the run)
+    };
+
+    StageStatistics getStageStatistics(Stage stage) const;
+
+    //Statistics of the queue behind a stage (not the write stage).
+    BoundedQueueStatistics getQueueStatistics(Stage stage) const;
+
+    static const char* name(Stage stage);
+
+    //Parses the thread counts of the five stages from a list like "1,2,4,2,1".
+    static bool parseThreadCounts(const std::string& text, int threads[nrOfStages]);
+
+private:
+    //An image on its way through the stages.
+    struct Item {
+        std::filesystem::path input, output;
+        std::vector<unsigned char> file;
+        std::unique_ptr<EnhancerImage> image;
+        EnhancerImage::Filetype outputType = EnhancerImage::jpg;
+        std::vector<unsigned char> encoded;
+        bool failed = false;
+    };
+
+    using Queue = BoundedQueue<std::unique_ptr<Item>>;
+
+    Options options;
+    ProcessFunction process;
+    ResultCallback resultCallback;
+
+    //queues[stage] connects stage with the stage behind it
+    std::vector<std::unique_ptr<Queue>> queues;
+
+    std::atomic<uint64_t> busyNanoseconds[nrOfStages];
+    std::atomic<uint64_t> images[nrOfStages];
+    double runSeconds = 0;
+
+    //The work of a stage on one image.
+    void work(Stage stage, Item& item);
+
+    //The loop of one thread of a stage, which takes the images from the queue in front of the stage (or the file list) and passes them on.
+    void runThread(Stage stage, const std::vector<std::filesystem::path>& files, std::atomic<size_t>& nextFile, std::atomic<int>& runningThreads);
+};
+
+#endif //ENHANCER_IMAGEPIPELINE_H
@@ -0,0 +1,35 @@
+#ifndef ENHANCER_IMAGEVIEW_H
+#define ENHANCER_IMAGEVIEW_H
+
+#include <cstddef>
+
+/*
+    A non-owning view of pixels that are stored row by row: width x height pixels with nrOfChannels interleaved bytes each,
+    and stride bytes from the start of one row to the start of the next. A view can describe a whole EnhancerImage or any
+    rectangle inside one (the text area of a form, a band of rows for a thread...) without copying pixels.
+
+    Like a pointer, a const view can still be used to change the pixels it points to. The pixels have to outlive the view.
+*/
+
+struct ImageView {
+    unsigned char* data = nullptr;
+    int width = 0, height = 0;
+    size_t stride = 0;
+    int nrOfChannels = 0;
+
+    //Whether every row is followed by padding that the SIMD kernels may read and overwrite (see EnhancerImage::rowStride).
+    //Views of whole images have it; of their rectangles only the ones that span full rows, the others have pixels next to their rows.
+    bool paddedRows = false;
+
+    unsigned char* row(int y) const {
+        return data + static_cast<size_t>(y) * stride;
+    }
+
+    //The rectangle of regionWidth x regionHeight pixels with the top left pixel (x, y), which has to lie completely inside this view.
+    ImageView region(int x, int y, int regionWidth, int regionHeight) const {
+        bool fullRows = (x == 0 && regionWidth == width);
+        return {row(y) + static_cast<size_t>(x) * nrOfChannels, regionWidth, regionHeight, stride, nrOfChannels, paddedRows && fullRows};
+    }
+};
+
+#endif //ENHANCER_IMAGEVIEW_H
@@ -0,0 +1,76 @@
+#include <climits>
+#include <fstream>
+
+#include "MappedFile.h"
+
+#ifndef WIN32
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string& path) {
+#ifndef WIN32
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0) return;
+
+    struct stat status;
+    if (fstat(file, &status) == 0 && S_ISREG(status.st_mode) && status.st_size > 0) {
+        void* mapping = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+        if (mapping != MAP_FAILED) {
+            memory = static_cast<unsigned char*>(mapping);
+            length = static_cast<size_t>(status.st_size);
+            mapped = true;
+
+            //the decoders read the file once from front to back
+            madvise(mapping, length, MADV_SEQUENTIAL);
+        }
+    }
+
+    //the mapping stays valid after the file is closed
+    close(file);
+#else
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) return;
+
+    std::streamsize fileSize = file.tellg();
+    if (fileSize <= 0) return;
+
+    memory = new unsigned char[static_cast<size_t>(fileSize)];
+    file.seekg(0);
+    if (file.read(reinterpret_cast<char*>(memory), fileSize)) {
+        length = static_cast<size_t>(fileSize);
+    }
+    else {
+        delete[] memory;
+        memory = nullptr;
+    }
+#endif
+}
+
+MappedFile::~MappedFile() {
+    if (!memory) return;
+
+#ifndef WIN32
+    if (mapped) munmap(memory, length);
+#else
+    delete[] memory;
+#endif
+}
+
+bool MappedFile::isOpen() const {
+    return memory != nullptr;
+}
+
+const unsigned char* MappedFile::data() const {
+    return memory;
+}
+
+size_t MappedFile::size() const {
+    return length;
+}
+
+bool MappedFile::fitsIntoStb() const {
+    return length <= static_cast<size_t>(INT_MAX);
+}
@@ -0,0 +1,38 @@
+#ifndef ENHANCER_MAPPEDFILE_H
+#define ENHANCER_MAPPEDFILE_H
+
+#include <string>
+#include <cstddef>
+
+/*
+    This class maps a whole file into memory read-only, so that stb can decode it straight from the page cache with
+    stbi_load_from_memory instead of copying it through stdio into its small refill buffer.
+
+    The mapping is marked as read sequentially (madvise(MADV_SEQUENTIAL)), which makes the kernel read ahead more aggressively and drop the
+    pages behind the decoder early. On systems without mmap (Windows) the file is read into a buffer instead, which still saves the stdio copies.
+*/
+
+class MappedFile {
+public:
+    //Maps the file at path. Whether that worked (it fails for missing and empty files) can be checked with isOpen().
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool isOpen() const;
+
+    const unsigned char* data() const;
+    size_t size() const;
+
+    //stb takes the length of a file in memory as an int, larger files have to be decoded from their path.
+    bool fitsIntoStb() const;
+
+private:
+    unsigned char* memory = nullptr;
+    size_t length = 0;
+    bool mapped = false;
+};
+
+#endif //ENHANCER_MAPPEDFILE_H
@@ -0,0 +1,94 @@
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+#include "StreamingThresholder.h"
+
+StreamingThresholder::StreamingThresholder(int width, int height, int halfWindow, double tresholdPercentage, RowCallback rowCallback)
+        : width(width), height(height), halfWindow(halfWindow), tresholdPercentage(tresholdPercentage), rowCallback(std::move(rowCallback)) {
+    //while row r is emitted, the rows r-halfWindow ... r+halfWindow have to be available
+    ringSize = std::min(2 * halfWindow + 1, height);
+    if (ringSize < 1) ringSize = 1;
+
+    rowBuffer.resize(static_cast<size_t>(ringSize) * width);
+    columnSums.assign(width, 0);
+    rowPrefixSums.resize(width);
+    outputRow.resize(width);
+}
+
+void StreamingThresholder::pushRow(const unsigned char* grayscaleRow) {
+    if (rowsPushed >= height) return;
+
+    std::memcpy(rowBuffer.data() + static_cast<size_t>(rowsPushed % ringSize) * width, grayscaleRow, width);
+    rowsPushed++;
+
+    //a row is complete once the lowest row of its window (clamped to the image border) has arrived
+    while (rowsEmitted < height && std::min(rowsEmitted + halfWindow, height - 1) < rowsPushed) {
+        emitRow(rowsEmitted);
+        rowsEmitted++;
+    }
+}
+
+int StreamingThresholder::getRowsPushed() const {
+    return rowsPushed;
+}
+
+int StreamingThresholder::getRowsEmitted() const {
+    return rowsEmitted;
+}
+
+bool StreamingThresholder::isFinished() const {
+    return rowsEmitted == height;
+}
+
+size_t StreamingThresholder::getMemoryUsage() const {
+    return rowBuffer.size() + outputRow.size() + (columnSums.size() + rowPrefixSums.size()) * sizeof(uint64_t);
+}
+
+const unsigned char* StreamingThresholder::bufferedRow(int row) const {
+    return rowBuffer.data() + static_cast<size_t>(row % ringSize) * width;
+}
+
+void StreamingThresholder::emitRow(int row) {
+    //the vertical ends of the window, with the same border handling as the integral image version
+    int y1 = row - halfWindow;
+    int y2 = row + halfWindow;
+    if (y1 < 0) y1 = 0;
+    if (y2 >= height) y2 = height-1;
+
+    //slide the column sums down to the rows (y1, y2]; the window moves by at most one row at both ends
+    while (windowBottom < y2) {
+        windowBottom++;
+        const unsigned char* added = bufferedRow(windowBottom);
+        for (int column = 0; column < width; column++) columnSums[column] += added[column];
+    }
+    while (windowTop < y1) {
+        windowTop++;
+        const unsigned char* removed = bufferedRow(windowTop);
+        for (int column = 0; column < width; column++) columnSums[column] -= removed[column];
+    }
+
+    //rowPrefixSums[x] now plays the role of the integral image: the sum of the window rows over the columns 0 ... x
+    uint64_t runningSum = 0;
+    for (int column = 0; column < width; column++) {
+        runningSum += columnSums[column];
+        rowPrefixSums[column] = runningSum;
+    }
+
+    const unsigned char* pixels = bufferedRow(row);
+
+    for (int column = 0; column < width; column++) {
+        int x1 = column - halfWindow;
+        int x2 = column + halfWindow;
+        if (x1 < 0) x1 = 0;
+        if (x2 >= width) x2 = width-1;
+
+        uint64_t nrOfPixelsInWindow = static_cast<uint64_t>(x2-x1) * static_cast<uint64_t>(y2-y1);
+        uint64_t intensitySum = rowPrefixSums[x2] - rowPrefixSums[x1];
+
+        bool aboveThreshold = static_cast<uint64_t>(pixels[column] * nrOfPixelsInWindow) > static_cast<uint64_t>(intensitySum*(1.0-tresholdPercentage));
+        outputRow[column] = aboveThreshold ? 255 : 0;
+    }
+
+    rowCallback(row, outputRow.data());
+}
@@ -0,0 +1,59 @@
+#ifndef ENHANCER_STREAMINGTHRESHOLDER_H
+#define ENHANCER_STREAMINGTHRESHOLDER_H
+
+#include <vector>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+
+/*
+    This class applies the same adaptive thresholding as EnhancerImage::applyAdaptiveThresholding, but without a full integral image.
+    The grayscale rows are pushed in one by one (e.g. as they come out of a decoder), and every binarized row is handed to a callback
+    as soon as all rows of its window have arrived, which is half a window after the row itself.
+
+    Only the rows of the current window are kept, together with one running sum per column over the window height,
+    so the memory usage depends on width * window size and not on width * height.
+*/
+
+class StreamingThresholder {
+public:
+    //Receives the index and the pixels (width bytes, 0 or 255) of a finished row. The pointer is only valid during the call.
+    using RowCallback = std::function<void(int row, const unsigned char* binarizedRow)>;
+
+    StreamingThresholder(int width, int height, int halfWindow, double tresholdPercentage, RowCallback rowCallback);
+
+    //Adds the next grayscale row (width bytes) and emits every row that has become complete.
+    void pushRow(const unsigned char* grayscaleRow);
+
+    int getRowsPushed() const;
+    int getRowsEmitted() const;
+
+    //True when all rows of the image have been emitted.
+    bool isFinished() const;
+
+    //Number of bytes held by the buffers of the engine.
+    size_t getMemoryUsage() const;
+
+private:
+    int width, height, halfWindow;
+    double tresholdPercentage;
+    RowCallback rowCallback;
+
+    //The last ringSize grayscale rows, row r is stored at slot r % ringSize.
+    int ringSize;
+    std::vector<unsigned char> rowBuffer;
+
+    //Sum of every column over the rows (windowTop, windowBottom], and its running total along the row.
+    std::vector<uint64_t> columnSums;
+    std::vector<uint64_t> rowPrefixSums;
+    int windowTop = 0, windowBottom = 0;
+
+    std::vector<unsigned char> outputRow;
+
+    int rowsPushed = 0, rowsEmitted = 0;
+
+    const unsigned char* bufferedRow(int row) const;
+    void emitRow(int row);
+};
+
+#endif //ENHANCER_STREAMINGTHRESHOLDER_H
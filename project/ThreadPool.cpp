@@ -0,0 +1,158 @@
+#include <exception>
+
+#include "ThreadPool.h"
+
+namespace {
+    //the pool and the deque of the worker that runs on this thread, if it is one
+    thread_local ThreadPool* currentPool = nullptr;
+    thread_local int currentWorker = -1;
+}
+
+//The tasks of one call to run().
+struct ThreadPool::Group {
+    const std::function<void(int)>* task;
+    std::atomic<int> remaining;   //queued tasks that aren't done yet
+
+    std::mutex mutex;
+    std::condition_variable done;
+    std::exception_ptr exception;
+
+    void runTask(int index) {
+        try {
+            (*task)(index);
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!exception) exception = std::current_exception();
+        }
+    }
+};
+
+ThreadPool::ThreadPool(int nrOfWorkers) {
+    for (int i = 0; i < nrOfWorkers; i++) workers.push_back(std::make_unique<Worker>());
+    for (int i = 0; i < nrOfWorkers; i++) threads.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (std::thread& thread : threads) thread.join();
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool(std::max(static_cast<int>(std::thread::hardware_concurrency()), 1) - 1);
+    return pool;
+}
+
+void ThreadPool::run(int nrOfTasks, const std::function<void(int task)>& task) {
+    if (nrOfTasks <= 0) return;
+
+    //nothing to share
+    if (nrOfTasks == 1 || workers.empty()) {
+        for (int index = 0; index < nrOfTasks; index++) task(index);
+        return;
+    }
+
+    Group group;
+    group.task = &task;
+    group.remaining = nrOfTasks - 1;
+
+    //A worker puts the tasks onto its own deque, so it takes them back in order while the others steal from the far end;
+    //the tasks of other threads are spread over the workers.
+    int self = (currentPool == this) ? currentWorker : -1;
+    for (int index = nrOfTasks - 1; index >= 1; index--) {
+        Worker& worker = *workers[self >= 0 ? self : nextWorker++ % workers.size()];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.tasks.push_back({&group, index});
+    }
+    tasksQueued += nrOfTasks - 1;
+    queuedTasks += nrOfTasks - 1;
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wakeUp.notify_all();
+
+    //the caller does the first task and then helps with the others, until all of them are taken
+    group.runTask(0);
+    Task next;
+    while (group.remaining > 0 && takeTask(self, &group, next)) execute(next);
+
+    //the rest is being done by other threads
+    {
+        std::unique_lock<std::mutex> lock(group.mutex);
+        group.done.wait(lock, [&group]() { return group.remaining == 0; });
+    }
+
+    if (group.exception) std::rethrow_exception(group.exception);
+}
+
+void ThreadPool::workerLoop(int index) {
+    currentPool = this;
+    currentWorker = index;
+
+    while (true) {
+        Task task;
+        if (takeTask(index, nullptr, task)) {
+            execute(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeUp.wait(lock, [this]() { return stopping || queuedTasks > 0; });
+        if (stopping && queuedTasks <= 0) return;
+    }
+}
+
+bool ThreadPool::takeTask(int workerIndex, const Group* group, Task& task) {
+    auto belongs = [group](const Task& queued) { return !group || queued.group == group; };
+
+    //the newest task of the own deque is the one whose data is most likely still in the cache
+    if (workerIndex >= 0) {
+        Worker& own = *workers[workerIndex];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        auto found = std::find_if(own.tasks.rbegin(), own.tasks.rend(), belongs);
+        if (found != own.tasks.rend()) {
+            task = *found;
+            own.tasks.erase(std::next(found).base());
+            queuedTasks--;
+            return true;
+        }
+    }
+
+    //the oldest tasks of the others are the largest pieces of work left
+    size_t nrOfWorkers = workers.size();
+    size_t start = workerIndex >= 0 ? workerIndex + 1 : 0;
+    for (size_t i = 0; i < nrOfWorkers; i++) {
+        size_t victim = (start + i) % nrOfWorkers;
+        if (static_cast<int>(victim) == workerIndex) continue;
+
+        Worker& other = *workers[victim];
+        std::lock_guard<std::mutex> lock(other.mutex);
+        auto found = std::find_if(other.tasks.begin(), other.tasks.end(), belongs);
+        if (found != other.tasks.end()) {
+            task = *found;
+            other.tasks.erase(found);
+            queuedTasks--;
+            tasksStolen++;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::execute(const Task& task) {
+    Group& group = *task.group;
+    group.runTask(task.index);
+
+    //the caller of run() may return as soon as the last task is done, so the group isn't touched after the lock is released
+    std::lock_guard<std::mutex> lock(group.mutex);
+    if (--group.remaining == 0) group.done.notify_all();
+}
+
+ThreadPool::Statistics ThreadPool::getStatistics() const {
+    return {tasksQueued.load(), tasksStolen.load()};
+}
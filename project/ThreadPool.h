@@ -0,0 +1,112 @@
+#ifndef ENHANCER_THREADPOOL_H
+#define ENHANCER_THREADPOOL_H
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+
+/*
+    A pool of persistent worker threads that runs both the per-image tasks of a batch and the bands of rows inside an image.
+
+    Every worker has its own deque of tasks: it takes its newest task from the back, and idle workers steal the oldest tasks of the
+    others from the front. A thread that starts tasks works on them itself and only waits for the ones other threads already took,
+    so tasks that start tasks of their own (an image that is split into bands) need neither new threads nor a second pool, and
+    the pool never runs more threads than it was created with plus the threads that call it.
+
+    The shared pool has one worker less than there are cores, because the thread that starts the work is the last one.
+*/
+
+class ThreadPool {
+public:
+    explicit ThreadPool(int nrOfWorkers);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    //The pool used by the image processing, created on first use.
+    static ThreadPool& shared();
+
+    int nrOfWorkers() const {
+        return static_cast<int>(workers.size());
+    }
+
+    //Runs task(0) ... task(nrOfTasks - 1) and returns once all of them are done. If a task throws, the first exception is rethrown here.
+    void run(int nrOfTasks, const std::function<void(int task)>& task);
+
+    //Calls body(index) for every index in [begin, end), split into nrOfBands bands of consecutive indices (like schedule(static)).
+    template<typename Body>
+    void parallelFor(int begin, int end, int nrOfBands, Body&& body) {
+        int count = end - begin;
+        nrOfBands = std::max(std::min(nrOfBands, count), 1);
+
+        run(nrOfBands, [&](int band) {
+            int first = begin + static_cast<int>(static_cast<int64_t>(count) * band / nrOfBands);
+            int last = begin + static_cast<int>(static_cast<int64_t>(count) * (band + 1) / nrOfBands);
+            for (int index = first; index < last; index++) body(index);
+        });
+    }
+
+    //Calls body(index, task) for every index in [begin, end) on nrOfTasks tasks that take the next index as soon as they are done
+    //with the previous one (like schedule(dynamic, 1)). task tells the body which of the tasks runs it, e.g. for scratch memory per task.
+    template<typename Body>
+    void parallelForDynamic(int begin, int end, int nrOfTasks, Body&& body) {
+        nrOfTasks = std::max(std::min(nrOfTasks, end - begin), 1);
+        std::atomic<int> next{begin};
+
+        run(nrOfTasks, [&](int task) {
+            for (int index = next++; index < end; index = next++) body(index, task);
+        });
+    }
+
+    //Counters since the construction.
+    struct Statistics {
+        uint64_t tasks;    //tasks that were handed to the pool (the first task of every run is always done by the caller)
+        uint64_t steals;   //tasks that were taken from the deque of another thread
+    };
+
+    Statistics getStatistics() const;
+
+private:
+    struct Group;
+
+    struct Task {
+        Group* group;
+        int index;
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+
+    //the idle workers sleep until tasks are queued
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+    std::atomic<int> queuedTasks{0};
+    bool stopping = false;
+
+    //where the tasks of callers that are no workers go
+    std::atomic<unsigned> nextWorker{0};
+
+    std::atomic<uint64_t> tasksQueued{0}, tasksStolen{0};
+
+    void workerLoop(int index);
+
+    //Takes a task from the back of the own deque, or steals one from the front of another one. With a group, only its tasks are taken.
+    bool takeTask(int workerIndex, const Group* group, Task& task);
+
+    void execute(const Task& task);
+};
+
+#endif //ENHANCER_THREADPOOL_H
@@ -0,0 +1,166 @@
+#include <cstdint>
+#include <atomic>
+
+#include "ThresholdKernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+    #define ENHANCER_X86_KERNELS
+    #include <immintrin.h>
+#endif
+
+namespace {
+    //the kernel chosen with selectInstructionSet, or -1 for the best one
+    std::atomic<int> chosenInstructionSet{-1};
+
+    //Reference implementation, also used for the columns that are left over after the SIMD loop.
+    //IntegralType can be narrower than LimitType, the window sum is exact in both (see EnhancerImage::integralFitsIn32Bits).
+    template<typename IntegralType, typename LimitType>
+    void scalarKernel(const IntegralType* integralRow1, const IntegralType* integralRow2, const unsigned char* grayscaleRow, unsigned char* binarizedRow,
+                      int firstColumn, int lastColumn, int halfWindow, const LimitType* limits) {
+        for (int column = firstColumn; column < lastColumn; column++) {
+            IntegralType intensitySum = integralRow2[column + halfWindow] - integralRow1[column + halfWindow] - integralRow2[column - halfWindow] + integralRow1[column - halfWindow];
+            binarizedRow[column] = (intensitySum < limits[grayscaleRow[column]]) ? 255 : 0;
+        }
+    }
+
+#ifdef ENHANCER_X86_KERNELS
+    //16 pixels per iteration: two times 8 window sums in 32-bit lanes, the limits of the 8 pixels are gathered from the table,
+    //and the two comparison masks are packed down to 16 bytes of 0xFF / 0x00.
+    __attribute__((target("avx2")))
+    void avx2Kernel(const uint32_t* integralRow1, const uint32_t* integralRow2, const unsigned char* grayscaleRow, unsigned char* binarizedRow,
+                    int firstColumn, int lastColumn, int halfWindow, const uint32_t* limits) {
+        //AVX2 only compares signed integers, flipping the sign bits turns that into an unsigned comparison
+        const __m256i signBit = _mm256_set1_epi32(INT32_MIN);
+
+        int column = firstColumn;
+        for (; column + 16 <= lastColumn; column += 16) {
+            __m256i white[2];
+            for (int k = 0; k < 2; k++) {
+                int right = column + 8 * k + halfWindow;
+                int left = column + 8 * k - halfWindow;
+                __m256i sumRight = _mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(integralRow2 + right)), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(integralRow1 + right)));
+                __m256i sumLeft = _mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(integralRow2 + left)), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(integralRow1 + left)));
+                __m256i intensitySum = _mm256_sub_epi32(sumRight, sumLeft);
+
+                __m256i pixels = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(grayscaleRow + column + 8 * k)));
+                __m256i limit = _mm256_i32gather_epi32(reinterpret_cast<const int*>(limits), pixels, 4);
+
+                white[k] = _mm256_cmpgt_epi32(_mm256_xor_si256(limit, signBit), _mm256_xor_si256(intensitySum, signBit));
+            }
+
+            //the packs work inside the 128-bit lanes, the permutes put the pixels back in order
+            __m256i words = _mm256_permute4x64_epi64(_mm256_packs_epi32(white[0], white[1]), 0xD8);
+            __m256i bytes = _mm256_permute4x64_epi64(_mm256_packs_epi16(words, words), 0x08);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(binarizedRow + column), _mm256_castsi256_si128(bytes));
+        }
+
+        scalarKernel(integralRow1, integralRow2, grayscaleRow, binarizedRow, column, lastColumn, halfWindow, limits);
+    }
+#endif
+}
+
+bool ThresholdKernels::buildSumLimits(uint64_t nrOfPixelsInWindow, double tresholdPercentage, SumLimits& sumLimits) {
+    //the sum * (1 - T) side of the comparison only grows with the sum while (1 - T) is not negative
+    double factor = 1.0 - tresholdPercentage;
+    if (!(factor >= 0.0)) return false;
+
+    //A pixel is white when brightness * pixels > (uint64_t) (sum * factor). For a whole number on the left that is the same as
+    //brightness * pixels > sum * factor, so the limit is the smallest sum with sum * factor >= brightness * pixels (in doubles, like the original).
+    uint64_t maxSum = 255 * nrOfPixelsInWindow;
+    for (int brightness = 0; brightness < 256; brightness++) {
+        double brightnessTimesPixels = static_cast<double>(brightness * nrOfPixelsInWindow);
+
+        //binary search over 0 ... maxSum + 1, the last value means that every possible sum is white
+        uint64_t low = 0, high = maxSum + 1;
+        while (low < high) {
+            uint64_t middle = low + (high - low) / 2;
+            if (static_cast<double>(middle) * factor >= brightnessTimesPixels) high = middle;
+            else low = middle + 1;
+        }
+        sumLimits.limits[brightness] = low;
+    }
+
+    sumLimits.fitsIn32Bits = (maxSum + 1 <= UINT32_MAX);
+    for (int brightness = 0; brightness < 256; brightness++) {
+        sumLimits.limits32[brightness] = static_cast<uint32_t>(sumLimits.limits[brightness]);
+    }
+
+    return true;
+}
+
+void ThresholdKernels::thresholdInterior(const uint64_t* integralRow1, const uint64_t* integralRow2, const unsigned char* grayscaleRow, unsigned char* binarizedRow,
+                                         int firstColumn, int lastColumn, int halfWindow, const SumLimits& sumLimits) {
+    //the 64-bit sums would only fit 4 pixels into a vector and need a 64-bit gather, the scalar loop is used for them
+    scalarKernel(integralRow1, integralRow2, grayscaleRow, binarizedRow, firstColumn, lastColumn, halfWindow, sumLimits.limits);
+}
+
+void ThresholdKernels::thresholdInterior(const uint32_t* integralRow1, const uint32_t* integralRow2, const unsigned char* grayscaleRow, unsigned char* binarizedRow,
+                                         int firstColumn, int lastColumn, int halfWindow, const SumLimits& sumLimits) {
+    thresholdInterior(selectedInstructionSet(), integralRow1, integralRow2, grayscaleRow, binarizedRow, firstColumn, lastColumn, halfWindow, sumLimits);
+}
+
+void ThresholdKernels::thresholdInterior(InstructionSet instructionSet, const uint32_t* integralRow1, const uint32_t* integralRow2, const unsigned char* grayscaleRow, unsigned char* binarizedRow,
+                                         int firstColumn, int lastColumn, int halfWindow, const SumLimits& sumLimits) {
+    //a 32-bit integral image is only used when every window sum fits into 32 bits, so the 32-bit limits are always available here
+    if (!sumLimits.fitsIn32Bits) {
+        scalarKernel(integralRow1, integralRow2, grayscaleRow, binarizedRow, firstColumn, lastColumn, halfWindow, sumLimits.limits);
+        return;
+    }
+
+    switch (instructionSet) {
+#ifdef ENHANCER_X86_KERNELS
+        case AVX2:
+            avx2Kernel(integralRow1, integralRow2, grayscaleRow, binarizedRow, firstColumn, lastColumn, halfWindow, sumLimits.limits32);
+            return;
+#endif
+
+        default:
+            scalarKernel(integralRow1, integralRow2, grayscaleRow, binarizedRow, firstColumn, lastColumn, halfWindow, sumLimits.limits32);
+            return;
+    }
+}
+
+bool ThresholdKernels::isSupported(InstructionSet instructionSet) {
+#ifdef ENHANCER_X86_KERNELS
+    __builtin_cpu_init();
+
+    switch (instructionSet) {
+        case AVX2:
+            return __builtin_cpu_supports("avx2");
+
+        default:
+            return true;
+    }
+#else
+    return instructionSet == Scalar;
+#endif
+}
+
+ThresholdKernels::InstructionSet ThresholdKernels::selectedInstructionSet() {
+    int chosen = chosenInstructionSet.load(std::memory_order_relaxed);
+    return (chosen < 0) ? bestInstructionSet() : static_cast<InstructionSet>(chosen);
+}
+
+ThresholdKernels::InstructionSet ThresholdKernels::bestInstructionSet() {
+    //the static local is initialized exactly once, even if many threads get here at the same time
+    static const InstructionSet best = isSupported(AVX2) ? AVX2 : Scalar;
+
+    return best;
+}
+
+bool ThresholdKernels::selectInstructionSet(InstructionSet instructionSet) {
+    if (!isSupported(instructionSet)) return false;
+
+    chosenInstructionSet.store(instructionSet, std::memory_order_relaxed);
+    return true;
+}
+
+const char* ThresholdKernels::name(InstructionSet instructionSet) {
+    switch (instructionSet) {
+        case AVX2:
+            return "AVX2";
+
+        default:
+            return "Scalar";
+    }
+}
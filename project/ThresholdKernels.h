@@ -0,0 +1,57 @@
+#ifndef ENHANCER_THRESHOLDKERNELS_H
+#define ENHANCER_THRESHOLDKERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+    This class contains the pixel loop of the adaptive thresholding for the interior of an image, where the window never touches the
+    image borders. There every window has the same number of pixels, so nothing has to be clamped and the comparison
+    "brightness * pixels in window > window sum * (1 - T)" of a pixel only depends on its brightness and its window sum.
+
+    That comparison is turned into an integer one: for every brightness value g, the smallest window sum that makes the pixel black
+    is calculated once with the same double-precision arithmetic as the original comparison (see SumLimits), so the interior loop only
+    compares every window sum with the limit of its pixel. The results are exactly the ones of the original comparison.
+*/
+
+class ThresholdKernels {
+public:
+    //The AVX2 kernel looks up the limits with a gather, which needs AVX2.
+    enum InstructionSet {Scalar, AVX2};
+
+    //The limits for one window size and threshold percentage: a pixel with brightness g is white exactly when its window sum is
+    //smaller than limits[g]. The 32-bit copy is only filled when every limit fits into 32 bits.
+    struct SumLimits {
+        uint64_t limits[256];
+        uint32_t limits32[256];
+        bool fitsIn32Bits;
+    };
+
+    //Returns false when the limits can't express the comparison, which only happens for a threshold percentage above 1.
+    static bool buildSumLimits(uint64_t nrOfPixelsInWindow, double tresholdPercentage, SumLimits& sumLimits);
+
+    //Thresholds the columns firstColumn ... lastColumn - 1 of a row, which all have to be at least halfWindow columns away from both
+    //borders. integralRow1 and integralRow2 are the rows of the integral image at the top and the bottom end of the window.
+    //The output pixels are 255 (white) or 0 (black).
+    static void thresholdInterior(const uint64_t* integralRow1, const uint64_t* integralRow2, const unsigned char* grayscaleRow, unsigned char* binarizedRow,
+                                  int firstColumn, int lastColumn, int halfWindow, const SumLimits& sumLimits);
+    static void thresholdInterior(const uint32_t* integralRow1, const uint32_t* integralRow2, const unsigned char* grayscaleRow, unsigned char* binarizedRow,
+                                  int firstColumn, int lastColumn, int halfWindow, const SumLimits& sumLimits);
+
+    //Same as above, but with an explicitly chosen kernel. The instruction set must be supported by the CPU.
+    static void thresholdInterior(InstructionSet instructionSet, const uint32_t* integralRow1, const uint32_t* integralRow2, const unsigned char* grayscaleRow, unsigned char* binarizedRow,
+                                  int firstColumn, int lastColumn, int halfWindow, const SumLimits& sumLimits);
+
+    static bool isSupported(InstructionSet instructionSet);
+
+    //The instruction set that thresholdInterior() uses: the best one for this CPU (determined from CPUID on the first call), unless another one was selected.
+    static InstructionSet selectedInstructionSet();
+    static InstructionSet bestInstructionSet();
+
+    //Makes thresholdInterior() use the given kernel (see --thresholdingKernel). Returns false, and keeps the current kernel, if the CPU doesn't support it.
+    static bool selectInstructionSet(InstructionSet instructionSet);
+
+    static const char* name(InstructionSet instructionSet);
+};
+
+#endif //ENHANCER_THRESHOLDKERNELS_H
@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <cstring>
+
+#include "TiledThresholder.h"
+#include "EnhancerImage.h"
+#include "ImageAllocator.h"
+#include "ThreadPool.h"
+
+namespace {
+    //The tiles are cut to the image, and so are the halos around them.
+    int tileRowsOf(int height, int tileSize) {
+        return std::min(tileSize, height);
+    }
+
+    int tileColumnsOf(int width, int tileSize) {
+        return std::min(tileSize, width);
+    }
+
+    int haloRowsOf(int height, int halfWindow, int tileSize) {
+        return static_cast<int>(std::min<int64_t>(static_cast<int64_t>(tileRowsOf(height, tileSize)) + 2 * static_cast<int64_t>(halfWindow), height));
+    }
+
+    int haloColumnsOf(int width, int halfWindow, int tileSize) {
+        return static_cast<int>(std::min<int64_t>(static_cast<int64_t>(tileColumnsOf(width, tileSize)) + 2 * static_cast<int64_t>(halfWindow), width));
+    }
+
+    //a band never has more tiles than threads that could work on them
+    int threadsFor(int width, int tileSize, int nrOfThreads) {
+        int nrOfTiles = (width + tileColumnsOf(width, tileSize) - 1) / tileColumnsOf(width, tileSize);
+        return std::max(1, std::min(nrOfThreads, nrOfTiles));
+    }
+
+    size_t integralElementSize(int halfWindow) {
+        return EnhancerImage::integralFitsIn32Bits(halfWindow) ? sizeof(uint32_t) : sizeof(uint64_t);
+    }
+
+    //the rows of a band with its halo, the binarized rows of the band and one tile integral image per thread
+    size_t bufferBytes(int width, int height, int halfWindow, int tileSize, int nrOfThreads) {
+        size_t haloRows = haloRowsOf(height, halfWindow, tileSize);
+        size_t haloColumns = haloColumnsOf(width, halfWindow, tileSize);
+        return static_cast<size_t>(width) * haloRows + static_cast<size_t>(width) * tileRowsOf(height, tileSize)
+               + static_cast<size_t>(nrOfThreads) * haloRows * haloColumns * integralElementSize(halfWindow);
+    }
+}
+
+TiledThresholder::TiledThresholder(int width, int height, int halfWindow, double tresholdPercentage, int tileSize, int nrOfThreads, RowCallback rowCallback)
+        : width(width), height(height), halfWindow(halfWindow), tresholdPercentage(tresholdPercentage), rowCallback(std::move(rowCallback)) {
+    this->tileSize = std::max(tileSize, 1);
+    this->nrOfThreads = threadsFor(width, this->tileSize, nrOfThreads);
+
+    //while the rows of a band are binarized, the rows halfWindow above and below the band have to be available
+    ringSize = std::max(haloRowsOf(height, halfWindow, this->tileSize), 1);
+    rowBuffer.resize(static_cast<size_t>(ringSize) * width);
+    outputRows.resize(static_cast<size_t>(tileRowsOf(height, this->tileSize)) * width);
+
+    use32Bits = EnhancerImage::integralFitsIn32Bits(halfWindow);
+    size_t integralImageBytes = static_cast<size_t>(ringSize) * haloColumnsOf(width, halfWindow, this->tileSize) * integralElementSize(halfWindow);
+    for (int thread = 0; thread < this->nrOfThreads; thread++) {
+        integralImages.push_back(ImageAllocator::pool().allocate(integralImageBytes));
+    }
+
+    //same interior as in EnhancerImage::applyAdaptiveThresholding
+    uint64_t nrOfPixelsInInteriorWindow = static_cast<uint64_t>(2 * static_cast<uint64_t>(halfWindow)) * (2 * static_cast<uint64_t>(halfWindow));
+    hasInterior = 2 * static_cast<int64_t>(halfWindow) < width && ThresholdKernels::buildSumLimits(nrOfPixelsInInteriorWindow, tresholdPercentage, sumLimits);
+}
+
+TiledThresholder::~TiledThresholder() {
+    for (void* integralImage : integralImages) ImageAllocator::pool().release(integralImage);
+}
+
+void TiledThresholder::pushRow(const unsigned char* grayscaleRow) {
+    if (rowsPushed >= height) return;
+
+    std::memcpy(rowBuffer.data() + static_cast<size_t>(rowsPushed % ringSize) * width, grayscaleRow, width);
+    rowsPushed++;
+
+    //a band is complete once the lowest row of the halo below it (clamped to the image border) has arrived
+    while (rowsEmitted < height && std::min<int64_t>(static_cast<int64_t>(rowsEmitted) + tileRowsOf(height, tileSize) + halfWindow, height) <= rowsPushed) {
+        processBand();
+    }
+}
+
+int TiledThresholder::getRowsPushed() const {
+    return rowsPushed;
+}
+
+int TiledThresholder::getRowsEmitted() const {
+    return rowsEmitted;
+}
+
+bool TiledThresholder::isFinished() const {
+    return rowsEmitted == height;
+}
+
+int TiledThresholder::getTileSize() const {
+    return tileSize;
+}
+
+size_t TiledThresholder::getMemoryUsage() const {
+    return memoryUsage(width, height, halfWindow, tileSize, nrOfThreads);
+}
+
+size_t TiledThresholder::memoryUsage(int width, int height, int halfWindow, int tileSize, int nrOfThreads) {
+    tileSize = std::max(tileSize, 1);
+    return bufferBytes(width, height, halfWindow, tileSize, threadsFor(width, tileSize, nrOfThreads));
+}
+
+int TiledThresholder::tileSizeFor(int width, int height, int halfWindow, size_t memoryLimit, int nrOfThreads) {
+    nrOfThreads = std::max(nrOfThreads, 1);
+
+    //with all threads the memory only grows with the tile size, so the largest tile that fits can be found with a binary search
+    //(the thresholder may use fewer threads than that for large tiles, and then less memory)
+    if (bufferBytes(width, height, halfWindow, 1, nrOfThreads) > memoryLimit) return 0;
+
+    int low = 1, high = std::max(width, height);
+    while (low < high) {
+        int middle = low + (high - low + 1) / 2;
+        if (bufferBytes(width, height, halfWindow, middle, nrOfThreads) <= memoryLimit) low = middle;
+        else high = middle - 1;
+    }
+
+    //whole blocks of 64 pixels keep the rows of the tiles aligned for the SIMD kernels
+    if (low >= 64 && low < std::max(width, height)) low = low / 64 * 64;
+    return low;
+}
+
+const unsigned char* TiledThresholder::bufferedRow(int row) const {
+    return rowBuffer.data() + static_cast<size_t>(row % ringSize) * width;
+}
+
+void TiledThresholder::processBand() {
+    int firstRow = rowsEmitted;
+    int lastRow = static_cast<int>(std::min<int64_t>(static_cast<int64_t>(firstRow) + tileRowsOf(height, tileSize), height));
+    int tileColumns = tileColumnsOf(width, tileSize);
+    int nrOfTiles = (width + tileColumns - 1) / tileColumns;
+
+    //the tiles of a band are independent, and they only differ in size at the right border
+    ThreadPool::shared().parallelForDynamic(0, nrOfTiles, nrOfThreads, [&](int tile, int task) {
+        int firstColumn = tile * tileColumns;
+        int lastColumn = std::min(firstColumn + tileColumns, width);
+        void* integralImage = integralImages[task];
+
+        if (use32Bits) thresholdTile(firstRow, lastRow, firstColumn, lastColumn, static_cast<uint32_t*>(integralImage));
+        else thresholdTile(firstRow, lastRow, firstColumn, lastColumn, static_cast<uint64_t*>(integralImage));
+    });
+
+    for (int row = firstRow; row < lastRow; row++) {
+        rowCallback(row, outputRows.data() + static_cast<size_t>(row - firstRow) * width);
+    }
+    rowsEmitted = lastRow;
+}
+
+template<typename IntegralType>
+void TiledThresholder::thresholdTile(int firstRow, int lastRow, int firstColumn, int lastColumn, IntegralType* integralImage) {
+    //the tile together with its halo, clamped to the image
+    int top = std::max(firstRow - halfWindow, 0);
+    int bottom = static_cast<int>(std::min<int64_t>(static_cast<int64_t>(lastRow) - 1 + halfWindow, height - 1));
+    int left = std::max(firstColumn - halfWindow, 0);
+    int right = static_cast<int>(std::min<int64_t>(static_cast<int64_t>(lastColumn) - 1 + halfWindow, width - 1));
+    size_t integralWidth = static_cast<size_t>(right - left) + 1;
+
+    //The integral image of the halo starts at (left, top) instead of (0, 0). A window sum is the difference of four sums, and the sums of
+    //the rows above top and the columns left of left cancel out in it, so the local integral image gives the same window sums as a full one.
+    for (int row = top; row <= bottom; row++) {
+        const unsigned char* source = bufferedRow(row) + left;
+        IntegralType* current = integralImage + static_cast<size_t>(row - top) * integralWidth;
+        IntegralType rowSum = 0;
+
+        if (row == top) {
+            for (size_t column = 0; column < integralWidth; column++) {
+                rowSum += source[column];
+                current[column] = rowSum;
+            }
+        }
+        else {
+            const IntegralType* above = current - integralWidth;
+            for (size_t column = 0; column < integralWidth; column++) {
+                rowSum += source[column];
+                current[column] = rowSum + above[column];
+            }
+        }
+    }
+
+    int firstInteriorRow = halfWindow, lastInteriorRow = height - halfWindow;
+    int firstInteriorColumn = std::max(firstColumn, halfWindow), lastInteriorColumn = std::min(lastColumn, width - halfWindow);
+
+    for (int row = firstRow; row < lastRow; row++) {
+        //the vertical ends of the window, with the same border handling as the whole image
+        int y1 = std::max(row - halfWindow, 0);
+        int y2 = static_cast<int>(std::min<int64_t>(static_cast<int64_t>(row) + halfWindow, height - 1));
+
+        const IntegralType* integralRow1 = integralImage + static_cast<size_t>(y1 - top) * integralWidth;
+        const IntegralType* integralRow2 = integralImage + static_cast<size_t>(y2 - top) * integralWidth;
+        const unsigned char* grayscaleRow = bufferedRow(row);
+        unsigned char* binarizedRow = outputRows.data() + static_cast<size_t>(row - firstRow) * width;
+
+        auto thresholdBorder = [&](int fromColumn, int toColumn) {
+            for (int column = fromColumn; column < toColumn; column++) {
+                int x1 = std::max(column - halfWindow, 0);
+                int x2 = static_cast<int>(std::min<int64_t>(static_cast<int64_t>(column) + halfWindow, width - 1));
+
+                uint64_t nrOfPixelsInWindow = static_cast<uint64_t>(x2 - x1) * static_cast<uint64_t>(y2 - y1);
+                IntegralType intensitySum = integralRow2[x2 - left] - integralRow1[x2 - left] - integralRow2[x1 - left] + integralRow1[x1 - left];
+
+                bool aboveThreshold = static_cast<uint64_t>(grayscaleRow[column] * nrOfPixelsInWindow) > static_cast<uint64_t>(intensitySum*(1.0-tresholdPercentage));
+                binarizedRow[column] = aboveThreshold ? 255 : 0;
+            }
+        };
+
+        if (hasInterior && row >= firstInteriorRow && row < lastInteriorRow && firstInteriorColumn < lastInteriorColumn) {
+            //the kernel indexes the integral rows with the same columns as the pixel rows, so those start at the left end of the halo as well
+            thresholdBorder(firstColumn, firstInteriorColumn);
+            ThresholdKernels::thresholdInterior(integralRow1, integralRow2, grayscaleRow + left, binarizedRow + left,
+                                                firstInteriorColumn - left, lastInteriorColumn - left, halfWindow, sumLimits);
+            thresholdBorder(lastInteriorColumn, lastColumn);
+        }
+        else {
+            thresholdBorder(firstColumn, lastColumn);
+        }
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef ENHANCER_TILEDTHRESHOLDER_H
+#define ENHANCER_TILEDTHRESHOLDER_H
+
+#include <vector>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+
+#include "ThresholdKernels.h"
+
+/*
+    This class applies the same adaptive thresholding as EnhancerImage::applyAdaptiveThresholding to images that are too large to be
+    held in memory. Like the StreamingThresholder it takes the grayscale rows one by one and hands every binarized row to a callback,
+    but it binarizes a band of tileSize rows at a time, cut into tiles of tileSize x tileSize pixels.
+
+    Every tile is extended by a halo of halfWindow pixels on all sides (up to the image borders), which holds the windows of all of its
+    pixels, and gets an integral image of its own over the tile and its halo. The window sums are differences of the integral image, so
+    the local one gives exactly the sums of a full one, and the result is the same as on the whole image. Only the rows of the current band
+    and its halo, the binarized rows of the band and one tile integral image per thread are held in memory, all indexed with 64 bits.
+*/
+
+class TiledThresholder {
+public:
+    //Receives the index and the pixels (width bytes, 0 or 255) of a finished row. The pointer is only valid during the call.
+    using RowCallback = std::function<void(int row, const unsigned char* binarizedRow)>;
+
+    //The tiles of a band are binarized by nrOfThreads threads, every one of them needs an integral image of its own.
+    TiledThresholder(int width, int height, int halfWindow, double tresholdPercentage, int tileSize, int nrOfThreads, RowCallback rowCallback);
+    ~TiledThresholder();
+
+    TiledThresholder(const TiledThresholder&) = delete;
+    TiledThresholder& operator=(const TiledThresholder&) = delete;
+
+    //Adds the next grayscale row (width bytes) and emits the rows of every band that has become complete.
+    void pushRow(const unsigned char* grayscaleRow);
+
+    int getRowsPushed() const;
+    int getRowsEmitted() const;
+
+    //True when all rows of the image have been emitted.
+    bool isFinished() const;
+
+    int getTileSize() const;
+
+    //Number of bytes held by the buffers of the engine.
+    size_t getMemoryUsage() const;
+
+    //The bytes a thresholder with these parameters holds.
+    static size_t memoryUsage(int width, int height, int halfWindow, int tileSize, int nrOfThreads);
+
+    //The largest tile size whose thresholder fits into memoryLimit bytes, rounded down to a multiple of 64 pixels if it is larger than that,
+    //or 0 if not even tiles of a single pixel fit (the rows of one window always have to be held).
+    static int tileSizeFor(int width, int height, int halfWindow, size_t memoryLimit, int nrOfThreads);
+
+private:
+    int width, height, halfWindow;
+    double tresholdPercentage;
+    RowCallback rowCallback;
+
+    int tileSize, nrOfThreads;
+
+    //The tile integral images are 32-bit whenever the window allows it (see EnhancerImage::integralFitsIn32Bits).
+    bool use32Bits;
+    std::vector<void*> integralImages;
+
+    //The interior of the image (windows that don't reach over a border) is thresholded with ThresholdKernels.
+    ThresholdKernels::SumLimits sumLimits;
+    bool hasInterior;
+
+    //The last ringSize grayscale rows, row r is stored at slot r % ringSize.
+    int ringSize;
+    std::vector<unsigned char> rowBuffer;
+
+    //The binarized rows of the current band.
+    std::vector<unsigned char> outputRows;
+
+    int rowsPushed = 0, rowsEmitted = 0;
+
+    const unsigned char* bufferedRow(int row) const;
+
+    //Binarizes the band that starts at rowsEmitted and emits its rows.
+    void processBand();
+
+    template<typename IntegralType>
+    void thresholdTile(int firstRow, int lastRow, int firstColumn, int lastColumn, IntegralType* integralImage);
+};
+
+#endif //ENHANCER_TILEDTHRESHOLDER_H
@@ -0,0 +1,64 @@
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+
+#include "TuningProfile.h"
+#include "BatchSchedule.h"
+
+std::filesystem::path TuningProfile::defaultPath() {
+#ifdef WIN32
+    const char* appData = std::getenv("APPDATA");
+    if (appData && *appData) return std::filesystem::path(appData) / "enhancer" / "profile";
+#else
+    const char* configHome = std::getenv("XDG_CONFIG_HOME");
+    if (configHome && *configHome) return std::filesystem::path(configHome) / "enhancer" / "profile";
+
+    const char* home = std::getenv("HOME");
+    if (home && *home) return std::filesystem::path(home) / ".config" / "enhancer" / "profile";
+#endif
+    return {};
+}
+
+std::vector<std::string> TuningProfile::read(const std::filesystem::path& path) {
+    std::vector<std::string> arguments;
+    std::ifstream file(path);
+
+    std::string line;
+    while (std::getline(file, line)) {
+        line = line.substr(0, line.find('#'));
+
+        std::istringstream words(line);
+        std::string word;
+        while (words >> word) arguments.push_back(word);
+    }
+
+    return arguments;
+}
+
+bool TuningProfile::write(const std::filesystem::path& path, const std::vector<std::string>& comments, const std::vector<std::pair<std::string, std::string>>& options) {
+    std::error_code error;
+    if (path.has_parent_path()) std::filesystem::create_directories(path.parent_path(), error);
+
+    std::ofstream file(path);
+    if (!file) return false;
+
+    for (const std::string& comment : comments) file << "# " << comment << "\n";
+    for (const auto& option : options) file << option.first << " " << option.second << "\n";
+
+    return static_cast<bool>(file.flush());
+}
+
+std::vector<int> TuningProfile::sample(const std::vector<uint64_t>& costs, int nrOfFiles) {
+    std::vector<int> order = BatchSchedule::largestFirst(costs);
+    if (nrOfFiles <= 0) return {};
+    if (static_cast<int>(order.size()) <= nrOfFiles) return order;
+
+    //the first and the last file of the order are always in the sample, the others are evenly spaced between them
+    std::vector<int> picked;
+    for (int i = 0; i < nrOfFiles; i++) {
+        size_t position = (nrOfFiles == 1) ? 0 : static_cast<size_t>(i) * (order.size() - 1) / (nrOfFiles - 1);
+        picked.push_back(order[position]);
+    }
+
+    return picked;
+}
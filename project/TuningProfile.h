@@ -0,0 +1,35 @@
+#ifndef ENHANCER_TUNINGPROFILE_H
+#define ENHANCER_TUNINGPROFILE_H
+
+#include <vector>
+#include <string>
+#include <utility>
+#include <filesystem>
+#include <cstdint>
+
+/*
+    The settings that --tune found to be the fastest on this machine, stored as command line arguments in a small text file.
+
+    Every line holds one option and its value, e.g. "--integralWidth 64", and everything after a '#' is a comment. The arguments of the
+    profile are read before the ones of the command line, so anything given on the command line still wins. The profile lives in the
+    configuration directory of the user, because the fastest settings depend on the machine and not on the folder that is processed.
+*/
+
+class TuningProfile {
+public:
+    //$XDG_CONFIG_HOME/enhancer/profile (~/.config/enhancer/profile if it isn't set), or %APPDATA%\enhancer\profile on Windows.
+    //Empty if none of these variables is set.
+    static std::filesystem::path defaultPath();
+
+    //The arguments stored in the profile, in order; empty if the file doesn't exist.
+    static std::vector<std::string> read(const std::filesystem::path& path);
+
+    //Writes the comment lines and then every option with its value on a line of its own, creating the directory if needed.
+    static bool write(const std::filesystem::path& path, const std::vector<std::string>& comments, const std::vector<std::pair<std::string, std::string>>& options);
+
+    //The indices of at most nrOfFiles files for the calibration, spread evenly from the largest to the smallest cost, so that the
+    //sample has the mix of image sizes of the whole folder. Returned from the largest to the smallest.
+    static std::vector<int> sample(const std::vector<uint64_t>& costs, int nrOfFiles);
+};
+
+#endif //ENHANCER_TUNINGPROFILE_H
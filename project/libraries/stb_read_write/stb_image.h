@@ -523,6 +523,23 @@ STBIDEF void stbi_set_unpremultiply_on_load_thread(int flag_true_if_should_unpre
 STBIDEF void stbi_convert_iphone_png_to_rgb_thread(int flag_true_if_should_convert);
 STBIDEF void stbi_set_flip_vertically_on_load_thread(int flag_true_if_should_flip);
 
+// [scan-enhancer] decode JPEG files at 1/2, 1/4 or 1/8 of their size (scale_shift = 1, 2 or 3) with a
+// reduced IDCT on every block, 0 decodes at full size. The other formats are always loaded at full size.
+STBIDEF void stbi_set_jpeg_scale_shift(int scale_shift);
+STBIDEF void stbi_set_jpeg_scale_shift_thread(int scale_shift);
+
+// [scan-enhancer] decodes the luma of a baseline JPEG file row by row, with the same pixels as stbi_load(filename, x, y, comp, 1)
+// at the scale of stbi_set_jpeg_scale_shift. Only one MCU row of every component is held in memory, so the image doesn't have to
+// fit into memory (or into the 2^31 bytes of stbi_load). *x and *y are set before row_callback gets the first row; it gets every
+// row (x pixels) in order and returns 0 to stop the decoding. Returns 0 on failure. Files that can't be decoded in rows (progressive,
+// RGB or CMYK JPEGs, subsampled luma) fail before the first row with the reason "no row decoding", stbi_load still loads them.
+typedef int (*stbi_jpeg_row_callback)(void *user, int row, const stbi_uc *pixels);
+#ifndef STBI_NO_STDIO
+STBIDEF int stbi_load_jpeg_rows(char const *filename, int *x, int *y, stbi_jpeg_row_callback row_callback, void *user);
+#endif
+// [scan-enhancer] the same for a JPEG file in memory, e.g. a memory-mapped file
+STBIDEF int stbi_load_jpeg_rows_from_memory(stbi_uc const *buffer, int len, int *x, int *y, stbi_jpeg_row_callback row_callback, void *user);
+
 // ZLIB client - used by PNG, available for other purposes
 
 STBIDEF char *stbi_zlib_decode_malloc_guesssize(const char *buffer, int len, int initial_size, int *outlen);
@@ -1133,6 +1150,30 @@ STBIDEF void stbi_set_flip_vertically_on_load_thread(int flag_true_if_should_fli
                                          : stbi__vertically_flip_on_load_global)
 #endif // STBI_THREAD_LOCAL
 
+// [scan-enhancer] reduced-size JPEG decoding
+static int stbi__jpeg_scale_shift_global = 0;
+
+STBIDEF void stbi_set_jpeg_scale_shift(int scale_shift)
+{
+   stbi__jpeg_scale_shift_global = scale_shift;
+}
+
+#ifndef STBI_THREAD_LOCAL
+#define stbi__jpeg_scale_shift  stbi__jpeg_scale_shift_global
+#else
+static STBI_THREAD_LOCAL int stbi__jpeg_scale_shift_local, stbi__jpeg_scale_shift_set;
+
+STBIDEF void stbi_set_jpeg_scale_shift_thread(int scale_shift)
+{
+   stbi__jpeg_scale_shift_local = scale_shift;
+   stbi__jpeg_scale_shift_set = 1;
+}
+
+#define stbi__jpeg_scale_shift  (stbi__jpeg_scale_shift_set         \
+                                  ? stbi__jpeg_scale_shift_local    \
+                                  : stbi__jpeg_scale_shift_global)
+#endif // STBI_THREAD_LOCAL
+
 static void *stbi__load_main(stbi__context *s, int *x, int *y, int *comp, int req_comp, stbi__result_info *ri, int bpc)
 {
    memset(ri, 0, sizeof(*ri)); // make sure it's initialized if we add new fields
@@ -1989,6 +2030,15 @@ typedef struct
    int            jfif;
    int            app14_color_transform; // Adobe APP14 tag
    int            rgb;
+   int            luma_only;   // [scan-enhancer] only the Y component is needed, skip the IDCT of the chroma blocks
+   int            scale_shift; // [scan-enhancer] every 8x8 block is decoded into (8 >> scale_shift)^2 pixels
+
+   // [scan-enhancer] row decoding (see stbi_load_jpeg_rows): the component planes only hold one MCU row,
+   // which is handed to row_callback as soon as it is decoded
+   stbi_jpeg_row_callback row_callback;
+   void          *row_user;
+   int           *row_x, *row_y;
+   int            rows_emitted;
 
    int scan_n, order[4];
    int restart_interval, todo;
@@ -2945,6 +2995,87 @@ static void stbi__jpeg_reset(stbi__jpeg *j)
    // since we don't even allow 1<<30 pixels
 }
 
+// [scan-enhancer] when a YCbCr image is decoded to 1 or 2 channels, only the Y component ends up in the output,
+// so the chroma blocks still have to be entropy-decoded (to advance the bitstream) but don't need an IDCT.
+static int stbi__jpeg_skip_idct(stbi__jpeg *z, int n)
+{
+   int is_rgb = z->s->img_n == 3 && (z->rgb == 3 || (z->app14_color_transform == 0 && !z->jfif));
+   return z->luma_only && n != 0 && z->s->img_n == 3 && !is_rgb;
+}
+
+// [scan-enhancer] C(u) * cos((2x+1) * u * pi / 2N) for the N-point inverse DCTs, C(0) = 1/sqrt(2), C(u) = 1 otherwise
+static const float stbi__idct_scaled_basis2[2][2] = {
+   { 0.70710678f,  0.70710678f },
+   { 0.70710678f, -0.70710678f },
+};
+static const float stbi__idct_scaled_basis4[4][4] = {
+   { 0.70710678f,  0.92387953f,  0.70710678f,  0.38268343f },
+   { 0.70710678f,  0.38268343f, -0.70710678f, -0.92387953f },
+   { 0.70710678f, -0.38268343f, -0.70710678f,  0.92387953f },
+   { 0.70710678f, -0.92387953f,  0.70710678f, -0.38268343f },
+};
+
+// [scan-enhancer] inverse DCT of only the lowest size x size frequencies of a dequantized block, which gives the
+// block downscaled to size x size pixels (each one is the average of its (8/size)^2 full-size pixels, up to the
+// dropped high frequencies). size 1 is just the DC term: the mean of the block is DC / 8.
+static void stbi__idct_block_scaled(stbi_uc *out, int out_stride, short data[64], int size)
+{
+   const float *basis;
+   float tmp[4][4];
+   int x,y,u,v;
+
+   if (size == 1) {
+      // +4 rounds, +128*8 is the level shift
+      out[0] = stbi__clamp((data[0] + 4 + 1024) >> 3);
+      return;
+   }
+
+   basis = (size == 2) ? &stbi__idct_scaled_basis2[0][0] : &stbi__idct_scaled_basis4[0][0];
+
+   // columns: tmp[y][u] = sum over v of basis(y,v) * F(v,u)
+   for (y=0; y < size; ++y)
+      for (u=0; u < size; ++u) {
+         float sum = 0;
+         for (v=0; v < size; ++v)
+            sum += basis[y*size+v] * data[v*8+u];
+         tmp[y][u] = sum;
+      }
+
+   // rows, with the 1/4 normalization of the 2D DCT and the level shift
+   for (y=0; y < size; ++y, out += out_stride)
+      for (x=0; x < size; ++x) {
+         float sum = 0;
+         for (u=0; u < size; ++u)
+            sum += basis[x*size+u] * tmp[y][u];
+         out[x] = stbi__clamp((int) (sum * 0.25f + 128.5f)); // negative sums truncate towards 0, but clamp to 0 anyway
+      }
+}
+
+// [scan-enhancer] stores a block at block position (bx, by) of component n, at full or reduced size
+static void stbi__jpeg_idct(stbi__jpeg *z, int n, int bx, int by, short data[64])
+{
+   int size = 8 >> z->scale_shift;
+   stbi_uc *out;
+   if (z->row_callback) by %= z->img_comp[n].v; // the plane only holds the current MCU row
+   out = z->img_comp[n].data + z->img_comp[n].w2*by*size + bx*size;
+   if (size == 8)
+      z->idct_block_kernel(out, z->img_comp[n].w2, data);
+   else
+      stbi__idct_block_scaled(out, z->img_comp[n].w2, data, size);
+}
+
+// [scan-enhancer] hands the rows of MCU row mcu_row of the Y component to the row callback
+static int stbi__jpeg_emit_rows(stbi__jpeg *z, int mcu_row)
+{
+   int rows = z->img_comp[0].v * (8 >> z->scale_shift);
+   int first = mcu_row * rows, r;
+   for (r=0; r < rows && first + r < *z->row_y; ++r)
+      if (!z->row_callback(z->row_user, first + r, z->img_comp[0].data + z->img_comp[0].w2*r))
+         return stbi__err("stopped", "Row decoding stopped by the callback");
+   z->rows_emitted = first + r;
+   return 1;
+}
+
 static int stbi__parse_entropy_coded_data(stbi__jpeg *z)
 {
    stbi__jpeg_reset(z);
@@ -2963,7 +3094,8 @@ static int stbi__parse_entropy_coded_data(stbi__jpeg *z)
             for (i=0; i < w; ++i) {
                int ha = z->img_comp[n].ha;
                if (!stbi__jpeg_decode_block(z, data, z->huff_dc+z->img_comp[n].hd, z->huff_ac+ha, z->fast_ac[ha], n, z->dequant[z->img_comp[n].tq])) return 0;
-               z->idct_block_kernel(z->img_comp[n].data+z->img_comp[n].w2*j*8+i*8, z->img_comp[n].w2, data);
+               if (!stbi__jpeg_skip_idct(z, n))
+                  stbi__jpeg_idct(z, n, i, j, data);
                // every data block is an MCU, so countdown the restart interval
                if (--z->todo <= 0) {
                   if (z->code_bits < 24) stbi__grow_buffer_unsafe(z);
@@ -2973,11 +3105,16 @@ static int stbi__parse_entropy_coded_data(stbi__jpeg *z)
                   stbi__jpeg_reset(z);
                }
             }
+            // [scan-enhancer] an MCU row of Y is complete after v block rows
+            if (z->row_callback && n == 0 && ((j+1) % z->img_comp[0].v == 0 || j == h-1))
+               if (!stbi__jpeg_emit_rows(z, j / z->img_comp[0].v)) return 0;
          }
          return 1;
       } else { // interleaved
-         int i,j,k,x,y;
+         int i,j,k,x,y,has_luma=0;
          STBI_SIMD_ALIGN(short, data[64]);
+         for (k=0; k < z->scan_n; ++k)
+            if (z->order[k] == 0) has_luma = 1;
          for (j=0; j < z->img_mcu_y; ++j) {
             for (i=0; i < z->img_mcu_x; ++i) {
                // scan an interleaved mcu... process scan_n components in order
@@ -2987,11 +3124,12 @@ static int stbi__parse_entropy_coded_data(stbi__jpeg *z)
                   // by the basic H and V specified for the component
                   for (y=0; y < z->img_comp[n].v; ++y) {
                      for (x=0; x < z->img_comp[n].h; ++x) {
-                        int x2 = (i*z->img_comp[n].h + x)*8;
-                        int y2 = (j*z->img_comp[n].v + y)*8;
+                        int x2 = (i*z->img_comp[n].h + x);
+                        int y2 = (j*z->img_comp[n].v + y);
                         int ha = z->img_comp[n].ha;
                         if (!stbi__jpeg_decode_block(z, data, z->huff_dc+z->img_comp[n].hd, z->huff_ac+ha, z->fast_ac[ha], n, z->dequant[z->img_comp[n].tq])) return 0;
-                        z->idct_block_kernel(z->img_comp[n].data+z->img_comp[n].w2*y2+x2, z->img_comp[n].w2, data);
+                        if (!stbi__jpeg_skip_idct(z, n))
+                           stbi__jpeg_idct(z, n, x2, y2, data);
                      }
                   }
                }
@@ -3003,6 +3141,9 @@ static int stbi__parse_entropy_coded_data(stbi__jpeg *z)
                   stbi__jpeg_reset(z);
                }
             }
+            // [scan-enhancer] the whole MCU row has been decoded
+            if (z->row_callback && has_luma)
+               if (!stbi__jpeg_emit_rows(z, j)) return 0;
          }
          return 1;
       }
@@ -3084,11 +3225,12 @@ static void stbi__jpeg_finish(stbi__jpeg *z)
       for (n=0; n < z->s->img_n; ++n) {
          int w = (z->img_comp[n].x+7) >> 3;
          int h = (z->img_comp[n].y+7) >> 3;
+         if (stbi__jpeg_skip_idct(z, n)) continue;
          for (j=0; j < h; ++j) {
             for (i=0; i < w; ++i) {
                short *data = z->img_comp[n].coeff + 64 * (i + j * z->img_comp[n].coeff_w);
                stbi__jpeg_dequantize(data, z->dequant[z->img_comp[n].tq]);
-               z->idct_block_kernel(z->img_comp[n].data+z->img_comp[n].w2*j*8+i*8, z->img_comp[n].w2, data);
+               stbi__jpeg_idct(z, n, i, j, data);
             }
          }
       }
@@ -3294,7 +3436,8 @@ static int stbi__process_frame_header(stbi__jpeg *z, int scan)
 
    if (scan != STBI__SCAN_load) return 1;
 
-   if (!stbi__mad3sizes_valid(s->img_x, s->img_y, s->img_n, 0)) return stbi__err("too large", "Image too large to decode");
+   // [scan-enhancer] row decoding never holds the whole image
+   if (!z->row_callback && !stbi__mad3sizes_valid(s->img_x, s->img_y, s->img_n, 0)) return stbi__err("too large", "Image too large to decode");
 
    for (i=0; i < s->img_n; ++i) {
       if (z->img_comp[i].h > h_max) h_max = z->img_comp[i].h;
@@ -3308,6 +3451,13 @@ static int stbi__process_frame_header(stbi__jpeg *z, int scan)
       if (v_max % z->img_comp[i].v != 0) return stbi__err("bad V","Corrupt JPEG");
    }
 
+   // [scan-enhancer] the rows of Y are final as soon as their MCU row is decoded, if Y is not subsampled and needs no colour conversion
+   if (z->row_callback) {
+      int is_rgb = s->img_n == 3 && (z->rgb == 3 || (z->app14_color_transform == 0 && !z->jfif));
+      if (z->progressive || !(s->img_n == 1 || (s->img_n == 3 && !is_rgb)) || z->img_comp[0].h != h_max || z->img_comp[0].v != v_max)
+         return stbi__err("no row decoding", "JPEG can't be decoded in rows");
+   }
+
    // compute interleaved mcu info
    z->img_h_max = h_max;
    z->img_v_max = v_max;
@@ -3328,8 +3478,10 @@ static int stbi__process_frame_header(stbi__jpeg *z, int scan)
       //
       // img_mcu_x, img_mcu_y: <=17 bits; comp[i].h and .v are <=4 (checked earlier)
       // so these muls can't overflow with 32-bit ints (which we require)
-      z->img_comp[i].w2 = z->img_mcu_x * z->img_comp[i].h * 8;
-      z->img_comp[i].h2 = z->img_mcu_y * z->img_comp[i].v * 8;
+      //
+      // [scan-enhancer] with a reduced IDCT every block only takes (8 >> scale_shift)^2 pixels
+      z->img_comp[i].w2 = z->img_mcu_x * z->img_comp[i].h * (8 >> z->scale_shift);
+      z->img_comp[i].h2 = (z->row_callback ? 1 : z->img_mcu_y) * z->img_comp[i].v * (8 >> z->scale_shift);
       z->img_comp[i].coeff = 0;
       z->img_comp[i].raw_coeff = 0;
       z->img_comp[i].linebuf = NULL;
@@ -3339,10 +3491,10 @@ static int stbi__process_frame_header(stbi__jpeg *z, int scan)
       // align blocks for idct using mmx/sse
       z->img_comp[i].data = (stbi_uc*) (((size_t) z->img_comp[i].raw_data + 15) & ~15);
       if (z->progressive) {
-         // w2, h2 are multiples of 8 (see above)
-         z->img_comp[i].coeff_w = z->img_comp[i].w2 / 8;
-         z->img_comp[i].coeff_h = z->img_comp[i].h2 / 8;
-         z->img_comp[i].raw_coeff = stbi__malloc_mad3(z->img_comp[i].w2, z->img_comp[i].h2, sizeof(short), 15);
+         // one block of 64 coefficients per 8x8 pixels of the full-size image
+         z->img_comp[i].coeff_w = z->img_mcu_x * z->img_comp[i].h;
+         z->img_comp[i].coeff_h = z->img_mcu_y * z->img_comp[i].v;
+         z->img_comp[i].raw_coeff = stbi__malloc_mad3(z->img_comp[i].coeff_w * 8, z->img_comp[i].coeff_h * 8, sizeof(short), 15);
          if (z->img_comp[i].raw_coeff == NULL)
             return stbi__free_jpeg_components(z, i+1, stbi__err("outofmem", "Out of memory"));
          z->img_comp[i].coeff = (short*) (((size_t) z->img_comp[i].raw_coeff + 15) & ~15);
@@ -3417,11 +3569,19 @@ static int stbi__decode_jpeg_image(stbi__jpeg *j)
    }
    j->restart_interval = 0;
    if (!stbi__decode_jpeg_header(j, STBI__SCAN_load)) return 0;
+   // [scan-enhancer] the size of the rows is known before the first row is decoded
+   if (j->row_callback) {
+      int round = (1 << j->scale_shift) - 1;
+      *j->row_x = (j->s->img_x + round) >> j->scale_shift;
+      *j->row_y = (j->s->img_y + round) >> j->scale_shift;
+   }
    m = stbi__get_marker(j);
    while (!stbi__EOI(m)) {
       if (stbi__SOS(m)) {
          if (!stbi__process_scan_header(j)) return 0;
          if (!stbi__parse_entropy_coded_data(j)) return 0;
+         // [scan-enhancer] the scans that follow the last row of Y only hold chroma
+         if (j->row_callback && j->rows_emitted >= *j->row_y) return 1;
          if (j->marker == STBI__MARKER_none ) {
          j->marker = stbi__skip_jpeg_junk_at_end(j);
             // if we reach eof without hitting a marker, stbi__get_marker() below will fail and we'll eventually return 0
@@ -3869,9 +4029,27 @@ static stbi_uc *load_jpeg_image(stbi__jpeg *z, int *out_x, int *out_y, int *comp
    // validate req_comp
    if (req_comp < 0 || req_comp > 4) return stbi__errpuc("bad req_comp", "Internal error");
 
+   // [scan-enhancer] with fewer than 3 output channels, only the Y component of a YCbCr image is used
+   z->luma_only = (req_comp == 1 || req_comp == 2);
+
+   // [scan-enhancer] reduced-size decoding, 1/2, 1/4 or 1/8
+   z->scale_shift = stbi__jpeg_scale_shift;
+   if (z->scale_shift < 0 || z->scale_shift > 3) return stbi__errpuc("bad scale", "Unsupported JPEG decode scale");
+
    // load a jpeg image from whichever source, but leave in YCbCr format
    if (!stbi__decode_jpeg_image(z)) { stbi__cleanup_jpeg(z); return NULL; }
 
+   // [scan-enhancer] the components were decoded into reduced-size buffers, from here on everything works on the reduced size
+   if (z->scale_shift) {
+      int k, round = (1 << z->scale_shift) - 1;
+      z->s->img_x = (z->s->img_x + round) >> z->scale_shift;
+      z->s->img_y = (z->s->img_y + round) >> z->scale_shift;
+      for (k=0; k < z->s->img_n; ++k) {
+         z->img_comp[k].x = (z->img_comp[k].x + round) >> z->scale_shift;
+         z->img_comp[k].y = (z->img_comp[k].y + round) >> z->scale_shift;
+      }
+   }
+
    // determine actual number of components to generate
    n = req_comp ? req_comp : z->s->img_n >= 3 ? 3 : 1;
 
@@ -4038,6 +4216,60 @@ static void *stbi__jpeg_load(stbi__context *s, int *x, int *y, int *comp, int re
    return result;
 }
 
+// [scan-enhancer] row decoding of the JPEG in s, see stbi_load_jpeg_rows
+static int stbi__load_jpeg_rows(stbi__context *s, int *x, int *y, stbi_jpeg_row_callback row_callback, void *user)
+{
+   stbi__jpeg *j;
+   int result;
+   j = (stbi__jpeg*) stbi__malloc(sizeof(stbi__jpeg));
+   if (!j) return stbi__err("outofmem", "Out of memory");
+   memset(j, 0, sizeof(stbi__jpeg));
+   s->img_n = 0; // cleanup frees img_n components, even if the header is never read
+   j->s = s;
+   stbi__setup_jpeg(j);
+   j->luma_only = 1;
+   j->scale_shift = stbi__jpeg_scale_shift;
+   j->row_callback = row_callback;
+   j->row_user = user;
+   j->row_x = x;
+   j->row_y = y;
+   *x = *y = 0;
+
+   if (j->scale_shift < 0 || j->scale_shift > 3)
+      result = stbi__err("bad scale", "Unsupported JPEG decode scale");
+   else if (!stbi__decode_jpeg_image(j))
+      result = 0;
+   else if (j->rows_emitted < *y)
+      result = stbi__err("incomplete", "Corrupt JPEG");
+   else
+      result = 1;
+
+   stbi__cleanup_jpeg(j);
+   STBI_FREE(j);
+   return result;
+}
+
+STBIDEF int stbi_load_jpeg_rows_from_memory(stbi_uc const *buffer, int len, int *x, int *y, stbi_jpeg_row_callback row_callback, void *user)
+{
+   stbi__context s;
+   stbi__start_mem(&s, buffer, len);
+   return stbi__load_jpeg_rows(&s, x, y, row_callback, user);
+}
+
+#ifndef STBI_NO_STDIO
+STBIDEF int stbi_load_jpeg_rows(char const *filename, int *x, int *y, stbi_jpeg_row_callback row_callback, void *user)
+{
+   stbi__context s;
+   int result;
+   FILE *f = stbi__fopen(filename, "rb");
+   if (!f) return stbi__err("can't fopen", "Unable to open file");
+   stbi__start_file(&s, f);
+   result = stbi__load_jpeg_rows(&s, x, y, row_callback, user);
+   fclose(f);
+   return result;
+}
+#endif
+
 static int stbi__jpeg_test(stbi__context *s)
 {
    int r;
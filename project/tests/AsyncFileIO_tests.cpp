@@ -0,0 +1,147 @@
+#include "catch.hpp"
+#include "../AsyncFileIO.h"
+#include <vector>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+namespace fs = std::filesystem;
+
+namespace {
+    std::vector<unsigned char> readWholeFile(const fs::path& path) {
+        std::ifstream stream(path, std::ios::binary);
+        return std::vector<unsigned char>((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    }
+}
+
+TEST_CASE("Input files read on the I/O thread have the bytes of the files", "[correctness]") {
+    std::vector<fs::path> files = {"test_input/heft_(1).jpg", "test_input/does_not_exist.jpg", "test_input/adaptivethresholding1.bmp", "test_input/inputfile1.jpg"};
+
+    //io_uring (where the system supports it) and the blocking fallback, reading ahead of the workers or only on demand
+    for (bool useIoUring : {true, false}) {
+        for (int readAhead : {0, 1, 10}) {
+            AsyncFileIO::Options options;
+            options.useIoUring = useIoUring;
+            options.readAhead = readAhead;
+            AsyncFileIO io(files, options);
+            INFO((io.usesIoUring() ? "io_uring" : "blocking calls") << ", reading " << readAhead << " files ahead");
+            if (!useIoUring) REQUIRE_FALSE( io.usesIoUring() );
+
+            //the workers don't take the files in order
+            for (int index : {0, 2, 1, 3}) {
+                AsyncFileIO::InputFile input = io.takeInput(index);
+                if (index == 1) {
+                    REQUIRE_FALSE( input.ok );
+                    continue;
+                }
+
+                std::vector<unsigned char> expected = readWholeFile(files[index]);
+                REQUIRE( input.ok );
+                REQUIRE( input.size == expected.size() );
+                REQUIRE( std::equal(expected.begin(), expected.end(), input.data) );
+                AsyncFileIO::releaseInput(input);
+            }
+
+            REQUIRE( io.finish() );
+            REQUIRE( io.getStatistics().filesRead == 3 );
+        }
+    }
+}
+
+TEST_CASE("Output files written on the I/O thread have the queued bytes", "[correctness]") {
+    fs::create_directories("test_input/test_output");
+    std::vector<fs::path> noInputs;
+
+    for (bool useIoUring : {true, false}) {
+        for (bool directOutput : {false, true}) {
+            AsyncFileIO::Options options;
+            options.useIoUring = useIoUring;
+            options.directOutput = directOutput;
+            options.queueDepth = 4;   //more files than fit into the queue at once
+
+            std::vector<std::vector<unsigned char>> contents;
+            std::atomic<int> succeeded{0};
+            {
+                AsyncFileIO io(noInputs, options);
+                INFO((io.usesIoUring() ? "io_uring" : "blocking calls") << (directOutput ? " with O_DIRECT" : ""));
+
+                //empty files, files that end in a partial block and files of whole blocks
+                for (size_t size : {size_t(0), size_t(1), size_t(4095), size_t(4096), size_t(100000), size_t(3) << 20}) {
+                    std::vector<unsigned char> bytes(size);
+                    for (size_t i = 0; i < size; i++) bytes[i] = static_cast<unsigned char>((i * 7 + size) % 251);
+                    contents.push_back(bytes);
+
+                    std::string path = "test_input/test_output/async_" + std::to_string(contents.size()) + ".bin";
+                    io.writeOutput(path, std::move(bytes), [&](bool success) { if (success) succeeded++; });
+                }
+
+                REQUIRE( io.finish() );
+                REQUIRE( io.getStatistics().filesWritten == contents.size() );
+
+                //the ring is only given up when it fails, not when the I/O thread stops
+                if (useIoUring && AsyncFileIO::ioUringIsAvailable()) REQUIRE( io.usesIoUring() );
+            }
+            REQUIRE( succeeded == static_cast<int>(contents.size()) );
+
+            for (size_t i = 0; i < contents.size(); i++) {
+                REQUIRE( readWholeFile("test_input/test_output/async_" + std::to_string(i + 1) + ".bin") == contents[i] );
+            }
+        }
+    }
+}
+
+TEST_CASE("A file that can't be written is reported", "[correctness]") {
+    std::vector<fs::path> noInputs;
+
+    for (bool useIoUring : {true, false}) {
+        AsyncFileIO::Options options;
+        options.useIoUring = useIoUring;
+        AsyncFileIO io(noInputs, options);
+
+        bool reported = false, result = true;
+        io.writeOutput("test_input/missing_directory/output.bin", std::vector<unsigned char>(100, 1), [&](bool success) {
+            reported = true;
+            result = success;
+        });
+
+        REQUIRE_FALSE( io.finish() );
+        REQUIRE( reported );
+        REQUIRE_FALSE( result );
+    }
+}
+
+TEST_CASE("The I/O thread goes on with blocking calls when the ring fails", "[correctness]") {
+    if (!AsyncFileIO::ioUringIsAvailable()) return;
+
+    fs::create_directories("test_input/test_output");
+    std::vector<fs::path> files = {"test_input/heft_(1).jpg", "test_input/adaptivethresholding1.bmp", "test_input/inputfile1.jpg"};
+
+    AsyncFileIO::Options options;
+    options.readAhead = 0;
+    options.failRingAfter = 1;
+    AsyncFileIO io(files, options);
+
+    //the first input was still in the ring when it failed, it is read again with a blocking call like the later ones
+    AsyncFileIO::InputFile first = io.takeInput(0);
+    REQUIRE( first.ok );
+    REQUIRE( first.size == readWholeFile(files[0]).size() );
+    AsyncFileIO::releaseInput(first);
+    REQUIRE_FALSE( io.usesIoUring() );
+
+    for (int index : {1, 2}) {
+        AsyncFileIO::InputFile input = io.takeInput(index);
+        REQUIRE( input.ok );
+        REQUIRE( input.size == readWholeFile(files[index]).size() );
+        AsyncFileIO::releaseInput(input);
+    }
+
+    std::atomic<int> succeeded{0};
+    io.writeOutput("test_input/test_output/after_ring_failure.bin", std::vector<unsigned char>(1000, 7), [&](bool success) { if (success) succeeded++; });
+
+    //used to wait forever: the writes were announced on the eventfd of the dead ring
+    REQUIRE( io.finish() );
+    REQUIRE( succeeded == 1 );
+    REQUIRE( readWholeFile("test_input/test_output/after_ring_failure.bin").size() == 1000 );
+    fs::remove("test_input/test_output/after_ring_failure.bin");
+}
@@ -0,0 +1,65 @@
+#include "catch.hpp"
+#include "../BatchSchedule.h"
+#include "../EnhancerImage.h"
+#include <vector>
+#include <filesystem>
+namespace fs = std::filesystem;
+
+TEST_CASE("The pixel estimates are the sizes the images are decoded to", "[correctness]") {
+    std::vector<fs::path> files = {"test_input/heft_(1).jpg", "test_input/adaptivethresholding1.bmp", "test_input/does_not_exist.jpg"};
+
+    for (int scale : {1, 2, 8}) {
+        std::vector<uint64_t> pixels = BatchSchedule::estimatePixels(files, scale);
+        REQUIRE( pixels.size() == files.size() );
+        REQUIRE( pixels[2] == 0 );
+
+        for (size_t i = 0; i < 2; i++) {
+            EnhancerImage image(files[i].string(), EnhancerImage::Original, scale);
+            INFO(files[i].string() << " at 1/" << scale);
+            REQUIRE( pixels[i] == static_cast<uint64_t>(image.width) * image.height );
+        }
+    }
+}
+
+TEST_CASE("Largest first orders by decreasing cost and keeps ties in order", "[correctness]") {
+    REQUIRE( BatchSchedule::largestFirst({}).empty() );
+    REQUIRE( BatchSchedule::largestFirst({5, 100, 5, 0, 100, 7}) == std::vector<int>({1, 4, 5, 0, 2, 3}) );
+}
+
+TEST_CASE("The makespan is the end of the last image on the threads that are free first", "[correctness]") {
+    //a large image at the end of the directory: one thread works on it while the other one has nothing left to do
+    std::vector<double> durations = {1, 1, 1, 1, 4};
+    std::vector<int> directoryOrder = {0, 1, 2, 3, 4};
+    std::vector<int> largest = BatchSchedule::largestFirst({1, 1, 1, 1, 4});
+
+    REQUIRE( BatchSchedule::makespan(durations, directoryOrder, 2) == Approx(6.0) );
+    REQUIRE( BatchSchedule::makespan(durations, largest, 2) == Approx(4.0) );
+
+    //one thread always takes the sum, more threads than images the largest image
+    REQUIRE( BatchSchedule::makespan(durations, largest, 1) == Approx(8.0) );
+    REQUIRE( BatchSchedule::makespan(durations, directoryOrder, 16) == Approx(4.0) );
+    REQUIRE( BatchSchedule::makespan(durations, {}, 4) == 0.0 );
+}
+
+TEST_CASE("Images get more threads once there are fewer images left than threads", "[correctness]") {
+    //one thread per image while every thread has an image of its own
+    REQUIRE( BatchSchedule::threadsPerImage(8, 100, 100) == 1 );
+    REQUIRE( BatchSchedule::threadsPerImage(8, 8, 8) == 1 );
+
+    //then the threads that ran out of images are shared out, rounded up so that none of them stays idle
+    REQUIRE( BatchSchedule::threadsPerImage(8, 3, 3) == 3 );
+    REQUIRE( BatchSchedule::threadsPerImage(8, 1, 1) == 8 );
+    REQUIRE( BatchSchedule::threadsPerImage(8, 0, 0) == 8 );
+    REQUIRE( BatchSchedule::threadsPerImage(1, 5, 5) == 1 );
+}
+
+TEST_CASE("Only the images in flight share the threads", "[correctness]") {
+    //16 threads, but only 2 images at a time (-nt_a 2): both of them are split from the start, not once 16 images are left
+    REQUIRE( BatchSchedule::threadsPerImage(16, 100, 2) == 8 );
+    REQUIRE( BatchSchedule::threadsPerImage(16, 3, 2) == 8 );
+    REQUIRE( BatchSchedule::threadsPerImage(16, 1, 2) == 16 );
+
+    //more images in flight than are left: the ones left count
+    REQUIRE( BatchSchedule::threadsPerImage(16, 4, 16) == 4 );
+    REQUIRE( BatchSchedule::threadsPerImage(16, 100, 16) == 1 );
+}
@@ -0,0 +1,57 @@
+#include "catch.hpp"
+#include "../BilevelPNGWriter.h"
+#include "../BilevelImage.h"
+#include "stb_image.h"
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <filesystem>
+namespace fs = std::filesystem;
+
+TEST_CASE("A PNG file written in segments loads back with the same pixels", "[correctness]") {
+    fs::create_directories("test_input/test_output");
+    std::mt19937 random(17);
+
+    //odd widths end in partial bytes; segments of one row, of a few rows and of the whole image
+    for (int width : {1, 13, 64, 333}) {
+        for (size_t segmentSize : {size_t(1), size_t(200), BilevelPNGWriter::defaultSegmentSize}) {
+            int height = 97;
+
+            //runs of black and white compress, the noise in between doesn't
+            std::vector<unsigned char> pixels(static_cast<size_t>(width) * height);
+            for (size_t i = 0; i < pixels.size(); i++) pixels[i] = ((i / 50) % 3 == 0) ? static_cast<unsigned char>((random() % 2) * 255) : static_cast<unsigned char>(((i / 50) % 2) * 255);
+
+            BilevelImage packed(width, height);
+            for (int y = 0; y < height; y++) packed.packRow(y, pixels.data() + static_cast<size_t>(y) * width);
+
+            for (bool writePacked : {false, true}) {
+                BilevelPNGWriter writer("test_input/test_output/segments.png", width, height, segmentSize);
+                REQUIRE( writer.isOpen() );
+                for (int y = 0; y < height; y++) {
+                    if (writePacked) writer.writePackedRow(packed.row(y));
+                    else writer.writeRow(pixels.data() + static_cast<size_t>(y) * width);
+                }
+                REQUIRE( writer.finish() );
+
+                int savedW, savedH, savedChannels;
+                unsigned char* saved = stbi_load("test_input/test_output/segments.png", &savedW, &savedH, &savedChannels, 1);
+                INFO("width " << width << ", segment size " << segmentSize << (writePacked ? ", packed rows" : ", byte rows"));
+                REQUIRE( saved != nullptr );
+                REQUIRE( (savedW == width && savedH == height && savedChannels == 1) );
+                REQUIRE( std::equal(pixels.begin(), pixels.end(), saved) );
+                stbi_image_free(saved);
+            }
+        }
+    }
+}
+
+TEST_CASE("A PNG file with missing rows is not finished", "[correctness]") {
+    fs::create_directories("test_input/test_output");
+
+    std::vector<unsigned char> row(100, 255);
+    BilevelPNGWriter writer("test_input/test_output/incomplete.png", 100, 10);
+    for (int y = 0; y < 9; y++) writer.writeRow(row.data());
+
+    REQUIRE( writer.getRowsWritten() == 9 );
+    REQUIRE( !writer.finish() );
+}
@@ -0,0 +1,88 @@
+#include "catch.hpp"
+#include "../BoundedQueue.h"
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <memory>
+
+TEST_CASE("The capacity of a bounded queue is rounded up to a power of two", "[correctness]") {
+    REQUIRE( BoundedQueue<int>(1).capacity() == 2 );
+    REQUIRE( BoundedQueue<int>(3).capacity() == 4 );
+    REQUIRE( BoundedQueue<int>(4).capacity() == 4 );
+    REQUIRE( BoundedQueue<int>(100).capacity() == 128 );
+}
+
+TEST_CASE("A bounded queue keeps the order and refuses values when it is full", "[correctness]") {
+    BoundedQueue<int> queue(4);
+
+    //several rounds, so that the positions wrap around the cells
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 4; i++) {
+            int value = round * 10 + i;
+            REQUIRE( queue.tryPush(value) );
+        }
+        int extra = -1;
+        REQUIRE_FALSE( queue.tryPush(extra) );
+
+        for (int i = 0; i < 4; i++) {
+            int value;
+            REQUIRE( queue.tryPop(value) );
+            REQUIRE( value == round * 10 + i );
+        }
+        int value;
+        REQUIRE_FALSE( queue.tryPop(value) );
+    }
+
+    BoundedQueueStatistics statistics = queue.getStatistics();
+    REQUIRE( statistics.pushes == 12 );
+    REQUIRE( statistics.maxDepth == 4 );
+}
+
+TEST_CASE("A closed queue hands out the remaining values before pop fails", "[correctness]") {
+    BoundedQueue<std::unique_ptr<int>> queue(1);
+    queue.push(std::make_unique<int>(1));
+    queue.push(std::make_unique<int>(2));
+    queue.close();
+
+    std::unique_ptr<int> value;
+    REQUIRE( queue.pop(value) );
+    REQUIRE( *value == 1 );
+    REQUIRE( queue.pop(value) );
+    REQUIRE( *value == 2 );
+    REQUIRE_FALSE( queue.pop(value) );
+}
+
+TEST_CASE("Every value pushed by several producers is popped exactly once", "[correctness]") {
+    const int nrOfProducers = 3, nrOfConsumers = 3, valuesPerProducer = 20000;
+
+    //a small queue, so that both the producers and the consumers have to wait
+    BoundedQueue<int> queue(8);
+    std::vector<std::atomic<int>> seen(nrOfProducers * valuesPerProducer);
+    for (auto& count : seen) count = 0;
+
+    std::atomic<int> runningProducers{nrOfProducers};
+    std::vector<std::thread> threads;
+    for (int producer = 0; producer < nrOfProducers; producer++) {
+        threads.emplace_back([&, producer]() {
+            for (int i = 0; i < valuesPerProducer; i++) queue.push(producer * valuesPerProducer + i);
+            if (--runningProducers == 0) queue.close();
+        });
+    }
+    for (int consumer = 0; consumer < nrOfConsumers; consumer++) {
+        threads.emplace_back([&]() {
+            int value;
+            while (queue.pop(value)) seen[value]++;
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+
+    for (size_t i = 0; i < seen.size(); i++) {
+        INFO("value " << i);
+        REQUIRE( seen[i] == 1 );
+    }
+
+    BoundedQueueStatistics statistics = queue.getStatistics();
+    REQUIRE( statistics.pushes == static_cast<uint64_t>(nrOfProducers * valuesPerProducer) );
+    REQUIRE( statistics.maxDepth <= statistics.capacity );
+    REQUIRE( statistics.averageDepth <= statistics.capacity );
+}
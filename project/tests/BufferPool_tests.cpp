@@ -0,0 +1,108 @@
+#include "catch.hpp"
+#include "../BufferPool.h"
+#include <cstdint>
+#include <thread>
+
+TEST_CASE("Size classes cover the request with less than 25% waste", "[correctness]") {
+    REQUIRE( BufferPool::sizeClass(1) == 4096 );
+    REQUIRE( BufferPool::sizeClass(4096) == 4096 );
+    REQUIRE( BufferPool::sizeClass(4097) == 5120 );
+    REQUIRE( BufferPool::sizeClass(8192) == 8192 );
+
+    for (size_t bytes = 4097; bytes < 100000000; bytes = bytes * 3 / 2 + 7) {
+        size_t size = BufferPool::sizeClass(bytes);
+        REQUIRE( size >= bytes );
+        REQUIRE( size - bytes < bytes / 4 + 1 );
+        REQUIRE( size % 1024 == 0 );
+        //every size class is its own class
+        REQUIRE( BufferPool::sizeClass(size) == size );
+    }
+}
+
+TEST_CASE("Released buffers are reused by the next request of the same size class", "[correctness]") {
+    BufferPool::clear();
+    BufferPool::resetStatistics();
+
+    auto* first = BufferPool::acquire<uint64_t>(1562 * 1200);
+    REQUIRE( reinterpret_cast<uintptr_t>(first) % 64 == 0 );
+    first[1562 * 1200 - 1] = 42;
+    BufferPool::release(first);
+
+    //a slightly different image size still falls into the same class
+    auto* second = BufferPool::acquire<uint64_t>(1560 * 1200);
+    REQUIRE( second == first );
+
+    //a second buffer of the same class while the first one is in use has to be new
+    auto* third = BufferPool::acquire<uint64_t>(1560 * 1200);
+    REQUIRE( third != second );
+
+    BufferPool::Statistics statistics = BufferPool::getStatistics();
+    REQUIRE( statistics.requests == 3 );
+    REQUIRE( statistics.reuses == 1 );
+    REQUIRE( statistics.bytesAllocated == 2 * BufferPool::sizeClass(1562 * 1200 * sizeof(uint64_t)) );
+
+    BufferPool::release(second);
+    BufferPool::release(third);
+    BufferPool::release(nullptr);
+    BufferPool::clear();
+}
+
+TEST_CASE("Buffers can be released on another thread", "[correctness]") {
+    BufferPool::clear();
+
+    unsigned char* buffer = nullptr;
+    std::thread producer([&buffer] { buffer = BufferPool::acquire<unsigned char>(100000); });
+    producer.join();
+
+    //the buffer moves into the pool of this thread
+    BufferPool::release(buffer);
+    REQUIRE( BufferPool::acquire<unsigned char>(100000) == buffer );
+
+    BufferPool::release(buffer);
+    BufferPool::clear();
+}
+
+TEST_CASE("A request takes a larger free buffer, but not a much larger one", "[correctness]") {
+    BufferPool::clear();
+
+    auto* large = BufferPool::acquire<unsigned char>(5000000);
+    BufferPool::release(large);
+
+    //a smaller image of a different size class gets the free buffer
+    auto* smaller = BufferPool::acquire<unsigned char>(4000000);
+    REQUIRE( smaller == large );
+    BufferPool::release(smaller);
+
+    //but not an image with less than half the size
+    auto* small = BufferPool::acquire<unsigned char>(2000000);
+    REQUIRE( small != large );
+
+    BufferPool::release(small);
+    BufferPool::clear();
+}
+
+TEST_CASE("Shrinking a buffer keeps its contents and its alignment", "[correctness]") {
+    BufferPool::clear();
+
+    size_t nrOfPixels = 1562 * 1200;
+    auto* buffer = BufferPool::acquire<unsigned char>(3 * nrOfPixels);
+    for (size_t i = 0; i < nrOfPixels; i++) buffer[i] = static_cast<unsigned char>(i * 7);
+
+    auto* shrunk = static_cast<unsigned char*>(BufferPool::shrink(buffer, nrOfPixels));
+    REQUIRE( reinterpret_cast<uintptr_t>(shrunk) % 64 == 0 );
+    REQUIRE( BufferPool::capacity(shrunk) == BufferPool::sizeClass(nrOfPixels) );
+    bool sameContents = true;
+    for (size_t i = 0; i < nrOfPixels; i++) sameContents = sameContents && shrunk[i] == static_cast<unsigned char>(i * 7);
+    REQUIRE( sameContents );
+
+    //growing is not shrinking
+    REQUIRE( BufferPool::shrink(shrunk, 2 * nrOfPixels) == shrunk );
+    REQUIRE( BufferPool::shrink(nullptr, 100) == nullptr );
+
+    //the shrunk buffer goes back into the pool under its new size class
+    BufferPool::release(shrunk);
+    REQUIRE( BufferPool::acquire<unsigned char>(nrOfPixels) == shrunk );
+
+    BufferPool::release(shrunk);
+    BufferPool::clear();
+}
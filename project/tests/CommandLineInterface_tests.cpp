@@ -0,0 +1,45 @@
+#include "catch.hpp"
+#include "../CommandLineInterface.h"
+#include <vector>
+#include <string>
+#include <fstream>
+#include <filesystem>
+namespace fs = std::filesystem;
+
+namespace {
+    //The arguments as main() gets them, they point into the given strings.
+    std::vector<char*> argvOf(std::vector<std::string>& arguments) {
+        std::vector<char*> argv;
+        for (std::string& argument : arguments) argv.push_back(&argument[0]);
+        argv.push_back(nullptr);
+        return argv;
+    }
+}
+
+TEST_CASE("Invalid arguments of the command line and of the profile are rejected", "[correctness]") {
+    std::vector<std::string> valid{"enhancer", "-i", "test_input", "-o", "test_output", "--profile", "none", "--verbose", "false"};
+    std::vector<char*> validArgv = argvOf(valid);
+    CommandLineInterface cli(static_cast<int>(valid.size()), validArgv.data());
+    REQUIRE( cli.parseArguments(static_cast<int>(valid.size()), validArgv.data()).empty() );
+
+    //the errors found while parsing are kept when the settings are validated afterwards
+    std::vector<std::string> invalid{"enhancer", "-i", "test_input", "-o", "test_output", "-pl", "1,x,3", "--profile", "none"};
+    std::vector<char*> invalidArgv = argvOf(invalid);
+    std::string errors = cli.parseArguments(static_cast<int>(invalid.size()), invalidArgv.data());
+    REQUIRE( errors.find("Invalid --pipeline argument.") != std::string::npos );
+
+    fs::path profile = "test_input/test_output/invalid_profile";
+    fs::create_directories(profile.parent_path());
+    {
+        std::ofstream file(profile);
+        file << "--integralWidth 48\n";
+    }
+
+    std::vector<std::string> withProfile{"enhancer", "-i", "test_input", "-o", "test_output", "--profile", profile.string(), "--verbose", "false"};
+    std::vector<char*> withProfileArgv = argvOf(withProfile);
+    errors = cli.parseArguments(static_cast<int>(withProfile.size()), withProfileArgv.data());
+    REQUIRE( errors.find("Invalid --integralWidth argument.") != std::string::npos );
+    REQUIRE( errors.find("were read first") != std::string::npos );
+
+    fs::remove(profile);
+}
@@ -0,0 +1,63 @@
+#include "catch.hpp"
+#include "../DecodeArena.h"
+#include "../BufferPool.h"
+#include "../EnhancerImage.h"
+#include "stb_image.h"
+#include <cstdint>
+#include <cstring>
+
+TEST_CASE("Small allocations come from the arena, which is reset once they are all freed", "[correctness]") {
+    void* first = DecodeArena::allocate(100);
+    void* second = DecodeArena::allocate(5000);
+    REQUIRE( DecodeArena::owns(first) );
+    REQUIRE( DecodeArena::owns(second) );
+    REQUIRE( reinterpret_cast<uintptr_t>(second) % 16 == 0 );
+    REQUIRE( static_cast<unsigned char*>(second) >= static_cast<unsigned char*>(first) + 100 );
+
+    DecodeArena::release(first);
+    DecodeArena::release(second);
+
+    //the next decode starts at the beginning of the arena again
+    void* afterReset = DecodeArena::allocate(100);
+    REQUIRE( afterReset == first );
+    DecodeArena::release(afterReset);
+}
+
+TEST_CASE("Large allocations come from the buffer pool", "[correctness]") {
+    void* large = DecodeArena::allocate(DecodeArena::largeAllocation);
+    REQUIRE_FALSE( DecodeArena::owns(large) );
+    REQUIRE( BufferPool::capacity(large) >= DecodeArena::largeAllocation );
+    DecodeArena::release(large);
+}
+
+TEST_CASE("Reallocation keeps the contents and grows the last allocation in place", "[correctness]") {
+    auto* grown = static_cast<unsigned char*>(DecodeArena::allocate(1000));
+    for (int i = 0; i < 1000; i++) grown[i] = static_cast<unsigned char>(i);
+
+    REQUIRE( DecodeArena::reallocate(grown, 1000, 20000) == grown );
+
+    //growing past the arena limit moves the memory into the buffer pool
+    auto* moved = static_cast<unsigned char*>(DecodeArena::reallocate(grown, 20000, 2 * DecodeArena::largeAllocation));
+    REQUIRE_FALSE( DecodeArena::owns(moved) );
+    for (int i = 0; i < 1000; i++) REQUIRE( moved[i] == static_cast<unsigned char>(i) );
+
+    DecodeArena::release(moved);
+}
+
+TEST_CASE("Decoded images end up in the buffer pool, whatever their size", "[correctness]") {
+    //File 1: 1562 * 1200 px, 3 channels, the 1/8 scale is small enough for the arena
+    for (int decodeScale : {1, 8}) {
+        EnhancerImage image("test_input/inputfile1.jpg", EnhancerImage::Original, decodeScale);
+        REQUIRE( image.getData() != nullptr );
+        REQUIRE_FALSE( DecodeArena::owns(image.getData()) );
+        REQUIRE( BufferPool::capacity(image.getData()) >= static_cast<size_t>(image.width) * image.height * 3 );
+    }
+
+    //the decoder state is gone after the decode, so the arena is empty again
+    void* probe = DecodeArena::allocate(16);
+    void* probe2 = DecodeArena::allocate(16);
+    DecodeArena::release(probe);
+    DecodeArena::release(probe2);
+    REQUIRE( DecodeArena::allocate(16) == probe );
+    DecodeArena::release(probe);
+}
@@ -1,11 +1,27 @@
 #include "catch.hpp"
 #include "../EnhancerImage.h"
+#include "../BufferPool.h"
+#include "../GrayscaleKernels.h"
 #include "stb_image.h"
 #include <iostream>
 #include <omp.h>
 #include <filesystem>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <cstdlib>
+#include <utility>
 namespace fs = std::filesystem;
 
+//Compares the pixels of two images of the same size row by row, the padding at the end of the rows doesn't count.
+static bool samePixels(const EnhancerImage& a, const EnhancerImage& b) {
+    size_t rowBytes = static_cast<size_t>(a.width) * a.nrOfChannels;
+    for (int row = 0; row < a.height; row++) {
+        if (!std::equal(a.getRow(row), a.getRow(row) + rowBytes, b.getRow(row))) return false;
+    }
+    return true;
+}
+
 
 TEST_CASE("Try to load a known image", "[correctness]") {
     //File 1: 1562 * 1200 px, 3 channels
@@ -14,6 +30,16 @@ TEST_CASE("Try to load a known image", "[correctness]") {
     REQUIRE( (img.width == 1562 && img.height == 1200 && img.nrOfChannels == 3) );
 }
 
+TEST_CASE("A file that can't be decoded gives an empty image", "[correctness]") {
+    std::vector<unsigned char> notAnImage(100, 7);
+
+    for (const unsigned char* file : {static_cast<const unsigned char*>(nullptr), static_cast<const unsigned char*>(notAnImage.data())}) {
+        EnhancerImage img(file, file ? notAnImage.size() : 0, EnhancerImage::Original, 1);
+        REQUIRE( img.getData() == nullptr );
+        REQUIRE( (img.width == 0 && img.height == 0 && img.nrOfChannels == 0) );
+    }
+}
+
 TEST_CASE("Try to save an image in different formats", "[correctness]") {
     //File 1: 1562 * 1200 px, 3 channels
     EnhancerImage img("test_input/inputfile1.jpg");
@@ -61,11 +87,455 @@ TEST_CASE("Apply adaptive thresholding to images", "[correctness]") {
     for (const auto & entry : fs::directory_iterator(path)) {
         if (!entry.is_directory() && entry.path().filename().string().find("binarized") == std::string::npos) {
             EnhancerImage img(entry.path().string());
-            img.applyAdaptiveThresholding(nrOfThreads, 0.125, 0.15);
+            img.applyAdaptiveThresholding(nrOfThreads, nrOfThreads, 0.125, 0.15, EnhancerImage::ThresholdingOptions());
             std::string output = (entry.path().parent_path() / "test_output" / (entry.path().stem().string()+"_binarized.jpg")).string();
             img.saveImage(output, EnhancerImage::Filetype::jpg);
         }
     }
 
     std::cout << "Adaptive thresholding test complete. Please also manually inspect the output folder to see if the image/s are free from any visual artifacts." << std::endl;
-}
\ No newline at end of file
+}
+
+TEST_CASE("Parallel integral image matches the sequential summed-area table", "[correctness]") {
+    EnhancerImage img("test_input/inputfile1.jpg");
+    img.convertToGrayscale(1);
+
+    int width = img.width, height = img.height;
+    const unsigned char* gray = img.getData();
+    size_t stride = img.getStride();
+
+    //reference: the column-by-column construction the integral image was originally built with
+    std::vector<uint64_t> reference(static_cast<size_t>(width) * height);
+    for (int column = 0; column < width; column++) {
+        uint64_t columnSum = 0;
+        for (int row = 0; row < height; row++) {
+            size_t index = static_cast<size_t>(row) * width + column;
+            columnSum += gray[row * stride + column];
+            reference[index] = columnSum + (column == 0 ? 0 : reference[index - 1]);
+        }
+    }
+
+    for (int nrOfThreads : {1, 2, 3, 7, omp_get_num_procs()}) {
+        std::vector<uint64_t> integral(reference.size());
+        EnhancerImage::buildIntegralImage(img.view(), integral.data(), nrOfThreads);
+        REQUIRE( integral == reference );
+    }
+}
+
+TEST_CASE("Parallel thresholding gives the same result as the sequential one", "[correctness]") {
+    EnhancerImage sequential("test_input/heft_(4).jpg");
+    EnhancerImage::ThresholdingOptions options;
+    options.fuseGrayscaleAndIntegral = false;
+    options.integralWidth = EnhancerImage::IntegralWidth::Bits64;
+    sequential.applyAdaptiveThresholding(1, 1, 0.125, 0.15, options);
+
+    for (int nrOfThreads : {2, 5, omp_get_num_procs()}) {
+        EnhancerImage parallel("test_input/heft_(4).jpg");
+        parallel.applyAdaptiveThresholding(1, nrOfThreads, 0.125, 0.15, EnhancerImage::ThresholdingOptions());
+        REQUIRE( samePixels(sequential, parallel) );
+    }
+}
+
+TEST_CASE("A thread split that changes from pass to pass gives the same result", "[correctness]") {
+    EnhancerImage fixed("test_input/heft_(4).jpg");
+    fixed.applyAdaptiveThresholding(1, 1, 0.125, 0.15, EnhancerImage::ThresholdingOptions());
+
+    //like an image at the end of a batch, which gets more threads while the other images finish
+    EnhancerImage adaptive("test_input/heft_(4).jpg");
+    EnhancerImage::ThresholdingOptions options;
+    int nrOfPasses = 0;
+    options.threadSplit = [&nrOfPasses]() { return 1 + 2 * nrOfPasses++; };
+    adaptive.applyAdaptiveThresholding(1, 1, 0.125, 0.15, options);
+
+    REQUIRE( nrOfPasses >= 2 );
+    REQUIRE( samePixels(fixed, adaptive) );
+}
+
+TEST_CASE("Fused grayscale + integral image pass matches the two separate passes", "[correctness]") {
+    EnhancerImage separate("test_input/inputfile1.jpg");
+    EnhancerImage fused("test_input/inputfile1.jpg");
+    size_t imageSize = static_cast<size_t>(separate.width) * separate.height;
+
+    std::vector<uint64_t> expectedIntegral(imageSize);
+    separate.convertToGrayscale(1);
+    EnhancerImage::buildIntegralImage(separate.view(), expectedIntegral.data(), 1);
+
+    for (int nrOfThreads : {1, 3, omp_get_num_procs()}) {
+        EnhancerImage grayscale(fused.width, fused.height, 1);
+        std::vector<uint64_t> integral(imageSize);
+        EnhancerImage::buildGrayscaleAndIntegralImage(fused.view(), grayscale.view(), integral.data(), nrOfThreads);
+
+        REQUIRE( samePixels(grayscale, separate) );
+        REQUIRE( integral == expectedIntegral );
+    }
+}
+
+TEST_CASE("32-bit integral image gives the same binarized image as the 64-bit one", "[correctness]") {
+    EnhancerImage wide("test_input/heft_(3).jpg");
+    EnhancerImage narrow("test_input/heft_(3).jpg");
+    REQUIRE( EnhancerImage::integralFitsIn32Bits(static_cast<int>(wide.width * 0.125) / 2) );
+
+    EnhancerImage::ThresholdingOptions options;
+    options.integralWidth = EnhancerImage::IntegralWidth::Bits64;
+    wide.applyAdaptiveThresholding(1, 2, 0.125, 0.15, options);
+    options.integralWidth = EnhancerImage::IntegralWidth::Bits32;
+    narrow.applyAdaptiveThresholding(3, 2, 0.125, 0.15, options);
+
+    REQUIRE( samePixels(wide, narrow) );
+}
+
+TEST_CASE("32-bit integral images are only used while the window sum fits into 32 bits", "[correctness]") {
+    //(2 * 2052)^2 * 255 = 4294918080 is just below 2^32, (2 * 2053)^2 * 255 is above it
+    REQUIRE( EnhancerImage::integralFitsIn32Bits(2052) );
+    REQUIRE_FALSE( EnhancerImage::integralFitsIn32Bits(2053) );
+}
+
+TEST_CASE("Window sums of a wrapped-around 32-bit integral image are exact", "[correctness]") {
+    //the total sum of this image (about 4400 * 4400 * 227) does not fit into 32 bits, so the 32-bit integral image wraps around
+    int width = 4400, height = 4400;
+    std::vector<unsigned char> grayscale(static_cast<size_t>(width) * height);
+    std::mt19937 generator(1);
+    for (auto& pixel : grayscale) pixel = static_cast<unsigned char>(200 + generator() % 56);
+
+    std::vector<uint64_t> wide(grayscale.size());
+    std::vector<uint32_t> narrow(grayscale.size());
+    ImageView view{grayscale.data(), width, height, static_cast<size_t>(width), 1};
+    EnhancerImage::buildIntegralImage(view, wide.data(), 2);
+    EnhancerImage::buildIntegralImage(view, narrow.data(), 3);
+    REQUIRE( wide.back() > UINT32_MAX );
+
+    auto at = [width](int x, int y) { return static_cast<size_t>(y) * width + x; };
+    for (int i = 0; i < 1000; i++) {
+        int x1 = generator() % width, y1 = generator() % height;
+        int x2 = std::min(width - 1, x1 + static_cast<int>(generator() % 2000));
+        int y2 = std::min(height - 1, y1 + static_cast<int>(generator() % 2000));
+
+        uint64_t expected = wide[at(x2, y2)] - wide[at(x2, y1)] - wide[at(x1, y2)] + wide[at(x1, y1)];
+        uint32_t result = narrow[at(x2, y2)] - narrow[at(x2, y1)] - narrow[at(x1, y2)] + narrow[at(x1, y1)];
+        REQUIRE( result == expected );
+    }
+}
+
+TEST_CASE("Packed 1-bit output holds the same pixels as the byte output", "[correctness]") {
+    EnhancerImage bytes("test_input/heft_(2).jpg");
+    EnhancerImage packed("test_input/heft_(2).jpg");
+    EnhancerImage streamed("test_input/heft_(2).jpg");
+
+    EnhancerImage::ThresholdingOptions packedOptions;
+    packedOptions.packedOutput = true;
+
+    bytes.applyAdaptiveThresholding(1, 2, 0.125, 0.15, EnhancerImage::ThresholdingOptions());
+    packed.applyAdaptiveThresholding(1, 2, 0.125, 0.15, packedOptions);
+    streamed.applyAdaptiveThresholding_streaming(0.125, 0.15, true);
+
+    REQUIRE( !bytes.isBilevel() );
+    REQUIRE( (packed.isBilevel() && streamed.isBilevel()) );
+
+    const BilevelImage* bits = packed.getBilevelImage();
+    REQUIRE( bits->getMemoryUsage() <= (static_cast<size_t>(bits->width) / 8 + 8) * bits->height );
+
+    std::vector<unsigned char> row(bytes.width);
+    for (int y = 0; y < bytes.height; y++) {
+        bits->unpackRow(y, row.data());
+        REQUIRE( std::equal(row.begin(), row.end(), bytes.getRow(y)) );
+        REQUIRE( std::equal(bits->row(y), bits->row(y) + bits->wordsPerRow, streamed.getBilevelImage()->row(y)) );
+    }
+
+    //the 1-bit PNG has to load back as the same image
+    REQUIRE( packed.saveImage("test_input/test_output/heft_(2)_packed.png", EnhancerImage::Filetype::png) );
+    int savedW, savedH, savedChannels;
+    unsigned char* saved = stbi_load("test_input/test_output/heft_(2)_packed.png", &savedW, &savedH, &savedChannels, 1);
+    REQUIRE( saved != nullptr );
+    REQUIRE( (savedW == bytes.width && savedH == bytes.height && savedChannels == 1) );
+    for (int y = 0; y < savedH; y++) {
+        REQUIRE( std::equal(saved + static_cast<size_t>(y) * savedW, saved + static_cast<size_t>(y + 1) * savedW, bytes.getRow(y)) );
+    }
+    stbi_image_free(saved);
+}
+
+TEST_CASE("Luma decoding gives the brightness of the full colour decode", "[correctness]") {
+    //File 1: 1562 * 1200 px, 3 channels
+    EnhancerImage luma("test_input/inputfile1.jpg", EnhancerImage::Luma);
+    EnhancerImage colour("test_input/inputfile1.jpg", EnhancerImage::Original);
+
+    REQUIRE( (luma.width == 1562 && luma.height == 1200 && luma.nrOfChannels == 1) );
+
+    //the luma is the Y component straight from the JPEG, the colour decode went through YCbCr -> RGB (with rounding and clamping),
+    //so converting it back to Y with stb's weights can only be off by a little
+    size_t nrOfPixels = static_cast<size_t>(luma.width) * luma.height;
+    double totalDifference = 0;
+    for (int row = 0; row < luma.height; row++) {
+        const unsigned char* y = luma.getRow(row);
+        const unsigned char* rgb = colour.getRow(row);
+        for (int i = 0; i < luma.width; i++) {
+            int recomputed = (rgb[3*i] * 77 + rgb[3*i + 1] * 150 + rgb[3*i + 2] * 29) >> 8;
+            totalDifference += std::abs(recomputed - y[i]);
+        }
+    }
+    REQUIRE( totalDifference / nrOfPixels < 1.0 );
+
+    REQUIRE( luma.applyAdaptiveThresholding(1, 2, 0.125, 0.15, EnhancerImage::ThresholdingOptions()) );
+}
+
+TEST_CASE("Downscaled JPEG decoding matches the box-filtered full-size image", "[correctness]") {
+    //File 1: 1562 * 1200 px, 3 channels
+    EnhancerImage full("test_input/inputfile1.jpg", EnhancerImage::Original);
+
+    for (int scale : {2, 4, 8}) {
+        EnhancerImage reduced("test_input/inputfile1.jpg", EnhancerImage::Original, scale);
+
+        REQUIRE( reduced.width == (full.width + scale - 1) / scale );
+        REQUIRE( reduced.height == (full.height + scale - 1) / scale );
+        REQUIRE( reduced.nrOfChannels == 3 );
+
+        //every reduced pixel should be close to the average of the scale x scale full-size pixels it covers,
+        //up to the dropped high frequencies and the rounding of the two decodes
+        double totalDifference = 0;
+        size_t nrOfSamples = 0;
+        for (int y = 0; y + 1 < reduced.height; y++) {
+            for (int x = 0; x + 1 < reduced.width; x++) {
+                for (int c = 0; c < 3; c++) {
+                    int sum = 0;
+                    for (int dy = 0; dy < scale; dy++) {
+                        for (int dx = 0; dx < scale; dx++) {
+                            sum += full.getRow(y * scale + dy)[(x * scale + dx) * 3 + c];
+                        }
+                    }
+                    totalDifference += std::abs(sum / (scale * scale) - reduced.getRow(y)[x * 3 + c]);
+                    nrOfSamples++;
+                }
+            }
+        }
+        REQUIRE( totalDifference / nrOfSamples < 3.0 );
+    }
+
+    //the scale is only used for the image it was requested for
+    EnhancerImage afterwards("test_input/inputfile1.jpg");
+    REQUIRE( (afterwards.width == 1562 && afterwards.height == 1200) );
+
+    //PNG files are always loaded at full size
+    full.saveImage("test_input/test_output/inputfile1_decodescale.png", EnhancerImage::Filetype::png);
+    EnhancerImage png("test_input/test_output/inputfile1_decodescale.png", EnhancerImage::Original, 4);
+    REQUIRE( (png.width == 1562 && png.height == 1200) );
+
+    EnhancerImage luma("test_input/inputfile1.jpg", EnhancerImage::Luma, 4);
+    REQUIRE( (luma.width == 391 && luma.height == 300 && luma.nrOfChannels == 1) );
+}
+
+TEST_CASE("Rows are 64-byte aligned and padded for whole kernel blocks", "[correctness]") {
+    //File 1: 1562 * 1200 px, 3 channels
+    EnhancerImage img("test_input/inputfile1.jpg");
+
+    REQUIRE( img.getStride() == EnhancerImage::rowStride(1562, 3) );
+    REQUIRE( img.getStride() % 64 == 0 );
+    REQUIRE( img.getStride() >= GrayscaleKernels::paddedSize(1562, 3) );
+    for (int row : {0, 1, 599, 1199}) REQUIRE( reinterpret_cast<uintptr_t>(img.getRow(row)) % 64 == 0 );
+
+    //the same pixels as the tightly packed decode of stb
+    int w, h, channels;
+    unsigned char* decoded = stbi_load("test_input/inputfile1.jpg", &w, &h, &channels, 0);
+    REQUIRE( decoded != nullptr );
+    for (int row = 0; row < h; row++) {
+        REQUIRE( std::equal(decoded + static_cast<size_t>(row) * w * 3, decoded + static_cast<size_t>(row + 1) * w * 3, img.getRow(row)) );
+    }
+    stbi_image_free(decoded);
+
+    img.convertToGrayscale(2);
+    REQUIRE( img.getStride() == EnhancerImage::rowStride(1562, 1) );
+}
+
+TEST_CASE("Images move without copying their pixels", "[correctness]") {
+    EnhancerImage img("test_input/heft_(1).jpg");
+    const unsigned char* pixels = img.getData();
+    int width = img.width;
+
+    std::vector<EnhancerImage> images;
+    images.push_back(std::move(img));
+    REQUIRE( img.getData() == nullptr );
+    REQUIRE( (img.width == 0 && img.height == 0) );
+    REQUIRE( images.back().getData() == pixels );
+    REQUIRE( images.back().width == width );
+
+    //move assignment gives the old pixels of the target back
+    EnhancerImage other("test_input/heft_(2).jpg");
+    other = std::move(images.back());
+    REQUIRE( other.getData() == pixels );
+    REQUIRE( other.applyAdaptiveThresholding(1, 2, 0.125, 0.15, EnhancerImage::ThresholdingOptions()) );
+}
+
+namespace {
+    //Hands out memory from the BufferPool, but keeps track of it.
+    class CountingAllocator : public ImageAllocator {
+    public:
+        int allocations = 0, releases = 0;
+
+        void* allocate(size_t bytes) override {
+            allocations++;
+            return BufferPool::acquire(bytes);
+        }
+
+        void release(void* memory) override {
+            if (memory) releases++;
+            BufferPool::release(memory);
+        }
+    };
+}
+
+TEST_CASE("All buffers of an image come from its allocator", "[correctness]") {
+    CountingAllocator allocator;
+    EnhancerImage reference("test_input/heft_(3).jpg");
+    reference.applyAdaptiveThresholding(1, 1, 0.125, 0.15, EnhancerImage::ThresholdingOptions());
+
+    {
+        EnhancerImage img("test_input/heft_(3).jpg", EnhancerImage::Original, 1, allocator);
+        //the decoded image is copied into the memory of the allocator
+        REQUIRE( allocator.allocations == 1 );
+
+        //grayscale, integral image, binarized image
+        img.applyAdaptiveThresholding(1, 1, 0.125, 0.15, EnhancerImage::ThresholdingOptions());
+        REQUIRE( allocator.allocations == 4 );
+        REQUIRE( allocator.releases == 3 );
+        REQUIRE( samePixels(img, reference) );
+
+        EnhancerImage blank(10, 10, 4, allocator);
+        REQUIRE( blank.getStride() == EnhancerImage::rowStride(10, 4) );
+    }
+
+    REQUIRE( allocator.releases == allocator.allocations );
+}
+
+TEST_CASE("Only full-width bands of a padded view keep the padding", "[correctness]") {
+    EnhancerImage img(100, 80, 3);
+    ImageView whole = img.view();
+
+    REQUIRE( whole.paddedRows );
+    REQUIRE( whole.region(0, 10, 100, 20).paddedRows );
+    REQUIRE_FALSE( whole.region(0, 10, 99, 20).paddedRows );
+    REQUIRE_FALSE( whole.region(1, 10, 99, 20).paddedRows );
+
+    ImageView rectangle = whole.region(7, 5, 30, 40);
+    REQUIRE( rectangle.row(2) == img.getRow(7) + 7 * 3 );
+    REQUIRE( rectangle.stride == img.getStride() );
+}
+
+TEST_CASE("A rectangle is binarized like a separate image, without touching the pixels around it", "[correctness]") {
+    EnhancerImage form("test_input/heft_(1).jpg");
+    int x = 123, y = 77, regionWidth = form.width / 2 + 1, regionHeight = form.height / 3;
+    ImageView textArea = form.view().region(x, y, regionWidth, regionHeight);
+
+    //the same pixels in an image of their own
+    EnhancerImage cropped(regionWidth, regionHeight, form.nrOfChannels);
+    for (int row = 0; row < regionHeight; row++) {
+        std::copy(textArea.row(row), textArea.row(row) + static_cast<size_t>(regionWidth) * form.nrOfChannels, cropped.getRow(row));
+    }
+
+    //grayscale conversion of the rectangle only
+    EnhancerImage grayscale(form.width, form.height, 1);
+    for (int row = 0; row < form.height; row++) std::fill(grayscale.getRow(row), grayscale.getRow(row) + form.width, 7);
+    EnhancerImage::convertToGrayscale(textArea, grayscale.view().region(x, y, regionWidth, regionHeight), 3);
+
+    EnhancerImage expectedGrayscale(regionWidth, regionHeight, form.nrOfChannels);
+    for (int row = 0; row < regionHeight; row++) std::copy(cropped.getRow(row), cropped.getRow(row) + static_cast<size_t>(regionWidth) * form.nrOfChannels, expectedGrayscale.getRow(row));
+    expectedGrayscale.convertToGrayscale(1);
+
+    for (int row = 0; row < form.height; row++) {
+        for (int column = 0; column < form.width; column++) {
+            bool inside = column >= x && column < x + regionWidth && row >= y && row < y + regionHeight;
+            unsigned char expected = inside ? expectedGrayscale.getRow(row - y)[column - x] : 7;
+            if (grayscale.getRow(row)[column] != expected) FAIL("grayscale pixel " << column << ", " << row);
+        }
+    }
+
+    //thresholding the colour rectangle into another image, and the grayscale rectangle in place
+    cropped.applyAdaptiveThresholding(1, 2, 0.125, 0.15, EnhancerImage::ThresholdingOptions());
+
+    EnhancerImage binarized(form.width, form.height, 1);
+    EnhancerImage::binarizeView(textArea, binarized.view().region(x, y, regionWidth, regionHeight), 0.125, 0.15, 2, ImageAllocator::pool());
+    ImageView grayscaleArea = grayscale.view().region(x, y, regionWidth, regionHeight);
+    EnhancerImage::binarizeView(grayscaleArea, grayscaleArea, 0.125, 0.15, 3, ImageAllocator::pool());
+
+    for (int row = 0; row < regionHeight; row++) {
+        REQUIRE( std::equal(cropped.getRow(row), cropped.getRow(row) + regionWidth, binarized.getRow(y + row) + x) );
+        REQUIRE( std::equal(cropped.getRow(row), cropped.getRow(row) + regionWidth, grayscale.getRow(y + row) + x) );
+    }
+    REQUIRE( grayscale.getRow(y - 1)[x] == 7 );
+    REQUIRE( grayscale.getRow(y)[x - 1] == 7 );
+    REQUIRE( grayscale.getRow(y)[x + regionWidth] == 7 );
+    REQUIRE( grayscale.getRow(y + regionHeight)[x] == 7 );
+}
+
+namespace {
+    //Keeps track of the memory that is in use at the same time.
+    class PeakMemoryAllocator : public ImageAllocator {
+    public:
+        size_t inUse = 0, peak = 0;
+
+        void* allocate(size_t bytes) override {
+            void* memory = BufferPool::acquire(bytes);
+            add(BufferPool::capacity(memory));
+            return memory;
+        }
+
+        void release(void* memory) override {
+            if (memory) inUse -= BufferPool::capacity(memory);
+            BufferPool::release(memory);
+        }
+
+        void* shrink(void* memory, size_t bytes) override {
+            inUse -= BufferPool::capacity(memory);
+            memory = BufferPool::shrink(memory, bytes);
+            add(BufferPool::capacity(memory));
+            return memory;
+        }
+
+    private:
+        void add(size_t bytes) {
+            inUse += bytes;
+            peak = std::max(peak, inUse);
+        }
+    };
+}
+
+TEST_CASE("In-place grayscale conversion and binarization give the same pixels with less memory", "[correctness]") {
+    //File 1: 1562 * 1200 px, 3 channels
+    EnhancerImage separate("test_input/inputfile1.jpg");
+    EnhancerImage inPlace("test_input/inputfile1.jpg");
+    separate.convertToGrayscale(2);
+    REQUIRE( inPlace.convertToGrayscale_inPlace(3, false) );
+    REQUIRE( inPlace.getStride() == separate.getStride() );
+    REQUIRE( samePixels(inPlace, separate) );
+    REQUIRE_FALSE( inPlace.convertToGrayscale_inPlace(3, false) );
+
+    for (int nrOfChannels : {2, 4}) {
+        //a random image with this many channels
+        EnhancerImage image(301, 203, nrOfChannels);
+        std::mt19937 generator(nrOfChannels);
+        for (int row = 0; row < image.height; row++) {
+            for (size_t i = 0; i < static_cast<size_t>(image.width) * nrOfChannels; i++) image.getRow(row)[i] = static_cast<unsigned char>(generator());
+        }
+        EnhancerImage expected(image.width, image.height, 1);
+        EnhancerImage::convertToGrayscale(image.view(), expected.view(), 1);
+
+        REQUIRE( image.convertToGrayscale_inPlace(4, true) );
+        REQUIRE( samePixels(image, expected) );
+    }
+
+    PeakMemoryAllocator defaultMemory, inPlaceMemory;
+    EnhancerImage::ThresholdingOptions inPlaceOptions;
+    inPlaceOptions.inPlace = true;
+    inPlaceOptions.shrinkBuffer = true;
+    {
+        EnhancerImage reference("test_input/inputfile1.jpg", EnhancerImage::Original, 1, defaultMemory);
+        EnhancerImage binarized("test_input/inputfile1.jpg", EnhancerImage::Original, 1, inPlaceMemory);
+        reference.applyAdaptiveThresholding(1, 2, 0.125, 0.15, EnhancerImage::ThresholdingOptions());
+        binarized.applyAdaptiveThresholding(2, 2, 0.125, 0.15, inPlaceOptions);
+
+        REQUIRE( samePixels(binarized, reference) );
+        REQUIRE( inPlaceMemory.inUse <= defaultMemory.inUse );
+    }
+
+    //no grayscale and no binarized buffer next to the colour image and the integral image
+    size_t grayscaleBytes = EnhancerImage::rowStride(1562, 1) * 1200;
+    REQUIRE( inPlaceMemory.peak + grayscaleBytes <= defaultMemory.peak );
+    REQUIRE( inPlaceMemory.inUse == 0 );
+}
@@ -0,0 +1,46 @@
+#include "catch.hpp"
+#include "../FilePrefetcher.h"
+#include <vector>
+#include <filesystem>
+#include <fstream>
+namespace fs = std::filesystem;
+
+TEST_CASE("The prefetcher advises every file ahead of the workers once", "[correctness]") {
+    std::vector<fs::path> files;
+    for (const auto& entry : fs::directory_iterator("test_input")) {
+        if (entry.is_regular_file()) files.push_back(entry.path());
+    }
+    REQUIRE( files.size() >= 4 );
+
+    for (int distance : {0, 1, 2, 100}) {
+        FilePrefetcher prefetcher(files, distance);
+        for (int i = 0; i < static_cast<int>(files.size()); i++) prefetcher.startFile(i);
+        prefetcher.stop();
+
+        //every file that was started is either a hit or a stall, and nothing beyond the last file is prefetched
+        FilePrefetcher::Statistics statistics = prefetcher.getStatistics();
+        INFO("distance " << distance);
+        REQUIRE( statistics.hits + statistics.stalls == files.size() );
+        REQUIRE( statistics.prefetched == (distance == 0 ? 0 : files.size()) );
+    }
+
+    //the workers only got halfway, so only the files up to distance files behind the last one are prefetched
+    FilePrefetcher prefetcher(files, 1);
+    prefetcher.startFile(0);
+    prefetcher.startFile(1);
+    prefetcher.stop();
+    REQUIRE( prefetcher.getStatistics().prefetched == 3 );
+}
+
+TEST_CASE("Files that were just read are resident in the page cache", "[correctness]") {
+    fs::create_directories("test_input/test_output");
+    {
+        std::ofstream file("test_input/test_output/resident.bin", std::ios::binary);
+        std::vector<char> bytes(100000, 'x');
+        file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+
+    //written pages stay in the page cache
+    REQUIRE( FilePrefetcher::isResident("test_input/test_output/resident.bin") );
+    REQUIRE_FALSE( FilePrefetcher::isResident("test_input/does_not_exist.jpg") );
+}
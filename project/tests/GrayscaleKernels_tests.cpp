@@ -0,0 +1,131 @@
+#include "catch.hpp"
+#include "../GrayscaleKernels.h"
+#include <vector>
+#include <random>
+#include <algorithm>
+
+TEST_CASE("Fixed-point division of the SIMD kernels is exact for every pixel", "[correctness]") {
+    //every possible r+g+b sum appears at least once; the odd pixel counts also exercise the scalar tails.
+    for (int nrOfChannels : {3, 4}) {
+        for (size_t nrOfPixels : {size_t(1), size_t(67), size_t(766), size_t(4099)}) {
+            std::vector<unsigned char> source(nrOfPixels * nrOfChannels);
+            std::mt19937 generator(42);
+            for (size_t i = 0; i < nrOfPixels; i++) {
+                int sum = static_cast<int>(i % 766);
+                source[i * nrOfChannels] = static_cast<unsigned char>(sum > 255 ? 255 : sum);
+                source[i * nrOfChannels + 1] = static_cast<unsigned char>(sum > 510 ? 255 : (sum > 255 ? sum - 255 : 0));
+                source[i * nrOfChannels + 2] = static_cast<unsigned char>(sum > 510 ? sum - 510 : 0);
+                if (nrOfChannels == 4) source[i * nrOfChannels + 3] = static_cast<unsigned char>(generator());
+            }
+
+            std::vector<unsigned char> expected(nrOfPixels);
+            GrayscaleKernels::convert(GrayscaleKernels::Scalar, source.data(), expected.data(), nrOfPixels, nrOfChannels);
+
+            for (auto instructionSet : {GrayscaleKernels::SSSE3, GrayscaleKernels::AVX2, GrayscaleKernels::AVX512}) {
+                if (!GrayscaleKernels::isSupported(instructionSet)) continue;
+
+                std::vector<unsigned char> result(nrOfPixels);
+                GrayscaleKernels::convert(instructionSet, source.data(), result.data(), nrOfPixels, nrOfChannels);
+                INFO(GrayscaleKernels::name(instructionSet) << ", " << nrOfChannels << " channels, " << nrOfPixels << " pixels");
+                REQUIRE( result == expected );
+            }
+        }
+    }
+}
+
+TEST_CASE("SIMD grayscale kernels match the scalar kernel on random data", "[correctness]") {
+    std::mt19937 generator(7);
+    for (int nrOfChannels : {3, 4}) {
+        size_t nrOfPixels = 100003;
+        std::vector<unsigned char> source(nrOfPixels * nrOfChannels);
+        for (auto& byte : source) byte = static_cast<unsigned char>(generator());
+
+        std::vector<unsigned char> expected(nrOfPixels);
+        GrayscaleKernels::convert(GrayscaleKernels::Scalar, source.data(), expected.data(), nrOfPixels, nrOfChannels);
+
+        std::vector<unsigned char> result(nrOfPixels);
+        GrayscaleKernels::convert(source.data(), result.data(), nrOfPixels, nrOfChannels);
+        INFO(GrayscaleKernels::name(GrayscaleKernels::selectedInstructionSet()));
+        REQUIRE( result == expected );
+    }
+}
+
+TEST_CASE("Every pixel layout gets its own grayscale value", "[correctness]") {
+    //grayscale (+ alpha) keeps the first channel, RGB (+ alpha) is the average of red, green and blue; alpha never counts.
+    std::mt19937 generator(3);
+    for (int nrOfChannels : {1, 2, 3, 4}) {
+        size_t nrOfPixels = 1029;
+        std::vector<unsigned char> source(nrOfPixels * nrOfChannels);
+        for (auto& byte : source) byte = static_cast<unsigned char>(generator());
+
+        std::vector<unsigned char> expected(nrOfPixels);
+        for (size_t i = 0; i < nrOfPixels; i++) {
+            const unsigned char* pixel = source.data() + i * nrOfChannels;
+            expected[i] = (nrOfChannels >= 3) ? static_cast<unsigned char>((pixel[0] + pixel[1] + pixel[2]) / 3) : pixel[0];
+        }
+
+        for (auto instructionSet : {GrayscaleKernels::Scalar, GrayscaleKernels::SSSE3, GrayscaleKernels::AVX2, GrayscaleKernels::AVX512}) {
+            if (!GrayscaleKernels::isSupported(instructionSet)) continue;
+
+            std::vector<unsigned char> result(nrOfPixels);
+            GrayscaleKernels::convert(instructionSet, source.data(), result.data(), nrOfPixels, nrOfChannels);
+            INFO(GrayscaleKernels::name(instructionSet) << ", " << nrOfChannels << " channels");
+            REQUIRE( result == expected );
+        }
+    }
+}
+
+TEST_CASE("Padded rows give the same grayscale values without a scalar tail", "[correctness]") {
+    std::mt19937 generator(11);
+    for (int nrOfChannels : {1, 2, 3, 4}) {
+        for (size_t nrOfPixels : {size_t(1), size_t(63), size_t(64), size_t(1562)}) {
+            std::vector<unsigned char> source(GrayscaleKernels::paddedSize(nrOfPixels, nrOfChannels));
+            for (auto& byte : source) byte = static_cast<unsigned char>(generator());
+
+            std::vector<unsigned char> expected(nrOfPixels);
+            GrayscaleKernels::convert(GrayscaleKernels::Scalar, source.data(), expected.data(), nrOfPixels, nrOfChannels);
+
+            for (auto instructionSet : {GrayscaleKernels::Scalar, GrayscaleKernels::SSSE3, GrayscaleKernels::AVX2, GrayscaleKernels::AVX512}) {
+                if (!GrayscaleKernels::isSupported(instructionSet)) continue;
+
+                std::vector<unsigned char> result(GrayscaleKernels::paddedSize(nrOfPixels, 1));
+                GrayscaleKernels::convertPadded(instructionSet, source.data(), result.data(), nrOfPixels, nrOfChannels);
+                INFO(GrayscaleKernels::name(instructionSet) << ", " << nrOfChannels << " channels, " << nrOfPixels << " pixels");
+                REQUIRE( std::equal(expected.begin(), expected.end(), result.begin()) );
+            }
+        }
+    }
+}
+
+TEST_CASE("A selected grayscale kernel is used until another one is selected", "[correctness]") {
+    GrayscaleKernels::InstructionSet best = GrayscaleKernels::bestInstructionSet();
+    REQUIRE( GrayscaleKernels::selectedInstructionSet() == best );
+
+    for (auto instructionSet : {GrayscaleKernels::Scalar, GrayscaleKernels::SSSE3, GrayscaleKernels::AVX2, GrayscaleKernels::AVX512}) {
+        //an instruction set the CPU doesn't have is refused, and the previous kernel stays
+        REQUIRE( GrayscaleKernels::selectInstructionSet(instructionSet) == GrayscaleKernels::isSupported(instructionSet) );
+        if (GrayscaleKernels::isSupported(instructionSet)) REQUIRE( GrayscaleKernels::selectedInstructionSet() == instructionSet );
+    }
+
+    REQUIRE( GrayscaleKernels::selectInstructionSet(best) );
+    REQUIRE( GrayscaleKernels::selectedInstructionSet() == best );
+}
+
+TEST_CASE("Pixels with more than 4 channels are converted by the scalar loop", "[correctness]") {
+    const int nrOfChannels = 5;
+    const size_t nrOfPixels = 100;
+    std::vector<unsigned char> source(nrOfPixels * nrOfChannels);
+    for (size_t i = 0; i < source.size(); i++) source[i] = static_cast<unsigned char>(i * 37);
+
+    for (auto instructionSet : {GrayscaleKernels::Scalar, GrayscaleKernels::SSSE3, GrayscaleKernels::AVX2, GrayscaleKernels::AVX512}) {
+        if (!GrayscaleKernels::isSupported(instructionSet)) continue;
+
+        std::vector<unsigned char> result(nrOfPixels, 1);
+        GrayscaleKernels::convert(instructionSet, source.data(), result.data(), nrOfPixels, nrOfChannels);
+        INFO(GrayscaleKernels::name(instructionSet));
+        for (size_t i = 0; i < nrOfPixels; i++) {
+            const unsigned char* pixel = source.data() + i * nrOfChannels;
+            REQUIRE( result[i] == (pixel[0] + pixel[1] + pixel[2]) / 3 );
+        }
+    }
+}
@@ -0,0 +1,85 @@
+#include "catch.hpp"
+#include "../ImagePipeline.h"
+#include <vector>
+#include <map>
+#include <mutex>
+#include <fstream>
+#include <iterator>
+#include <filesystem>
+namespace fs = std::filesystem;
+
+namespace {
+    std::vector<unsigned char> readWholeFile(const fs::path& path) {
+        std::ifstream stream(path, std::ios::binary);
+        return std::vector<unsigned char>((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    }
+}
+
+TEST_CASE("The pipeline writes the same files as processing the images one by one", "[correctness]") {
+    fs::create_directories("test_input/test_output");
+    std::vector<fs::path> files = {"test_input/heft_(1).jpg", "test_input/adaptivethresholding1.bmp", "test_input/does_not_exist.jpg", "test_input/inputfile1.jpg"};
+
+    auto binarize = [](EnhancerImage& image, const fs::path& input, fs::path& output, EnhancerImage::Filetype& outputType) {
+        image.applyAdaptiveThresholding_streaming(15, 15, false);
+        output = fs::path("test_input/test_output") / (input.stem().string() + "_pipeline.jpg");
+        outputType = EnhancerImage::jpg;
+        return true;
+    };
+
+    //one thread per stage and several threads in the middle stages, with queues that are full most of the time
+    int threadCounts[2][ImagePipeline::nrOfStages] = {{1, 1, 1, 1, 1}, {1, 2, 3, 2, 2}};
+    for (auto& threads : threadCounts) {
+        ImagePipeline::Options options;
+        std::copy(threads, threads + ImagePipeline::nrOfStages, options.threads);
+        options.queueDepth = 1;
+
+        std::mutex mutex;
+        std::map<std::string, bool> results;
+        std::map<std::string, fs::path> outputs;
+        ImagePipeline pipeline(options, binarize, [&](const fs::path& input, const fs::path& output, bool success) {
+            std::lock_guard<std::mutex> lock(mutex);
+            results[input.string()] = success;
+            outputs[input.string()] = output;
+        });
+        pipeline.run(files);
+
+        REQUIRE( results.size() == files.size() );
+        REQUIRE_FALSE( results["test_input/does_not_exist.jpg"] );
+
+        for (const fs::path& file : files) {
+            if (!fs::exists(file)) continue;
+            INFO(file.string());
+            REQUIRE( results[file.string()] );
+
+            EnhancerImage image(file.string());
+            fs::path expectedPath;
+            EnhancerImage::Filetype outputType;
+            binarize(image, file, expectedPath, outputType);
+            REQUIRE( outputs[file.string()] == expectedPath );
+            std::vector<unsigned char> expected;
+            REQUIRE( image.encodeImage(outputType, expected) );
+            REQUIRE( readWholeFile(expectedPath) == expected );
+        }
+
+        for (int stage = 0; stage < ImagePipeline::nrOfStages; stage++) {
+            ImagePipeline::StageStatistics statistics = pipeline.getStageStatistics(static_cast<ImagePipeline::Stage>(stage));
+            REQUIRE( statistics.threads == threads[stage] );
+            REQUIRE( statistics.images == files.size() );
+            REQUIRE( statistics.utilization >= 0.0 );
+        }
+        REQUIRE( pipeline.getQueueStatistics(ImagePipeline::Read).pushes == files.size() );
+    }
+}
+
+TEST_CASE("Thread counts of the pipeline stages are parsed from a list", "[correctness]") {
+    int threads[ImagePipeline::nrOfStages] = {0, 0, 0, 0, 0};
+    REQUIRE( ImagePipeline::parseThreadCounts("1,2,4,2,1", threads) );
+    REQUIRE( std::vector<int>(threads, threads + ImagePipeline::nrOfStages) == std::vector<int>({1, 2, 4, 2, 1}) );
+
+    //a wrong number of stages, no threads for a stage or no number leave the counts unchanged
+    for (const char* invalid : {"1,2,4,2", "1,2,4,2,1,1", "1,0,4,2,1", "1,2,x,2,1", "1,2,4.5,2,1", ""}) {
+        INFO(invalid);
+        REQUIRE_FALSE( ImagePipeline::parseThreadCounts(invalid, threads) );
+        REQUIRE( threads[2] == 4 );
+    }
+}
@@ -0,0 +1,57 @@
+#include "catch.hpp"
+#include "../MappedFile.h"
+#include "../EnhancerImage.h"
+#include "stb_image.h"
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+namespace fs = std::filesystem;
+
+TEST_CASE("A mapped file holds the bytes of the file", "[correctness]") {
+    for (const char* path : {"test_input/heft_(1).jpg", "test_input/adaptivethresholding1.bmp"}) {
+        std::ifstream stream(path, std::ios::binary);
+        std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+        MappedFile file(path);
+        INFO(path);
+        REQUIRE( file.isOpen() );
+        REQUIRE( file.fitsIntoStb() );
+        REQUIRE( file.size() == bytes.size() );
+        REQUIRE( std::equal(bytes.begin(), bytes.end(), file.data()) );
+    }
+}
+
+TEST_CASE("Missing and empty files can't be mapped", "[correctness]") {
+    fs::create_directories("test_input/test_output");
+    std::ofstream("test_input/test_output/empty.jpg").close();
+
+    REQUIRE_FALSE( MappedFile("test_input/does_not_exist.jpg").isOpen() );
+    REQUIRE_FALSE( MappedFile("test_input/test_output/empty.jpg").isOpen() );
+    REQUIRE_FALSE( MappedFile("test_input").isOpen() );
+
+    //the constructor of EnhancerImage reports them like any file that can't be decoded
+    EnhancerImage image("test_input/test_output/empty.jpg");
+    REQUIRE( image.getRow(0) == nullptr );
+}
+
+TEST_CASE("Images decoded from a mapped file have the same pixels as with stdio", "[correctness]") {
+    for (const char* path : {"test_input/heft_(1).jpg", "test_input/inputfile1.jpg", "test_input/adaptivethresholding1.bmp"}) {
+        for (EnhancerImage::LoadMode mode : {EnhancerImage::Original, EnhancerImage::Luma}) {
+            int width, height, nrOfChannels;
+            unsigned char* reference = stbi_load(path, &width, &height, &nrOfChannels, (mode == EnhancerImage::Luma) ? 1 : 0);
+            if (mode == EnhancerImage::Luma) nrOfChannels = 1;
+
+            EnhancerImage image(path, mode);
+            INFO(path << (mode == EnhancerImage::Luma ? " as luma" : ""));
+            REQUIRE( reference != nullptr );
+            REQUIRE( (image.width == width && image.height == height && image.nrOfChannels == nrOfChannels) );
+            for (int row = 0; row < height; row++) {
+                const unsigned char* expected = reference + static_cast<size_t>(row) * width * nrOfChannels;
+                REQUIRE( std::equal(expected, expected + static_cast<size_t>(width) * nrOfChannels, image.getRow(row)) );
+            }
+            stbi_image_free(reference);
+        }
+    }
+}
@@ -0,0 +1,70 @@
+#include "catch.hpp"
+#include "../StreamingThresholder.h"
+#include "../EnhancerImage.h"
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+TEST_CASE("Streaming thresholding gives the same result as the integral image version", "[correctness]") {
+    for (double windowSize : {0.0, 0.01, 0.125, 0.5, 1.0}) {
+        EnhancerImage reference("test_input/heft_(1).jpg");
+        EnhancerImage streamed("test_input/heft_(1).jpg");
+
+        EnhancerImage::ThresholdingOptions options;
+        options.fuseGrayscaleAndIntegral = false;
+        options.integralWidth = EnhancerImage::IntegralWidth::Bits64;
+        reference.applyAdaptiveThresholding(1, 1, windowSize, 0.15, options);
+        streamed.applyAdaptiveThresholding_streaming(windowSize, 0.15, false);
+
+        INFO("window size " << windowSize);
+        REQUIRE( streamed.nrOfChannels == 1 );
+        for (int row = 0; row < reference.height; row++) {
+            REQUIRE( std::equal(reference.getRow(row), reference.getRow(row) + reference.width, streamed.getRow(row)) );
+        }
+    }
+}
+
+TEST_CASE("Streaming thresholding gives the same result for windows whose sum doesn't fit in 32 bits", "[correctness]") {
+    //a window of 4200x4200 bright pixels sums up to more than 2^32
+    int size = 4200;
+    EnhancerImage reference(size, size, 1);
+    EnhancerImage streamed(size, size, 1);
+    for (int row = 0; row < size; row++) {
+        for (int column = 0; column < size; column++) {
+            unsigned char value = ((row / 64 + column / 64) % 7 == 0) ? 180 : 255;
+            reference.getRow(row)[column] = value;
+            streamed.getRow(row)[column] = value;
+        }
+    }
+
+    EnhancerImage::ThresholdingOptions options;
+    options.fuseGrayscaleAndIntegral = false;
+    options.integralWidth = EnhancerImage::IntegralWidth::Bits64;
+    reference.applyAdaptiveThresholding(1, 1, 1.0, 0.15, options);
+    streamed.applyAdaptiveThresholding_streaming(1.0, 0.15, false);
+
+    for (int row = 0; row < size; row++) {
+        REQUIRE( std::equal(reference.getRow(row), reference.getRow(row) + size, streamed.getRow(row)) );
+    }
+}
+
+TEST_CASE("Streaming thresholder emits rows half a window after they were pushed", "[correctness]") {
+    int width = 300, height = 200, halfWindow = 20;
+    std::vector<int> emittedRows;
+    StreamingThresholder thresholder(width, height, halfWindow, 0.15, [&](int row, const unsigned char*) { emittedRows.push_back(row); });
+
+    std::vector<unsigned char> row(width, 128);
+    for (int i = 0; i < height; i++) {
+        thresholder.pushRow(row.data());
+
+        //row r is finished once row r + halfWindow is available (or the last row of the image)
+        int expected = (i == height - 1) ? height : std::max(0, i - halfWindow + 1);
+        REQUIRE( thresholder.getRowsEmitted() == expected );
+    }
+
+    REQUIRE( thresholder.isFinished() );
+    for (int i = 0; i < height; i++) REQUIRE( emittedRows[i] == i );
+
+    //the buffers only hold the rows of one window, not the whole image
+    REQUIRE( thresholder.getMemoryUsage() < static_cast<size_t>(width) * (2 * halfWindow + 1 + 2 * sizeof(uint64_t) + 1) + 1 );
+}
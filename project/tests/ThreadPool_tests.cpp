@@ -0,0 +1,74 @@
+#include "catch.hpp"
+#include "../ThreadPool.h"
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <stdexcept>
+
+TEST_CASE("Every task of the thread pool runs exactly once", "[correctness]") {
+    //a pool without workers runs everything on the calling thread
+    for (int nrOfWorkers : {0, 1, 3}) {
+        ThreadPool pool(nrOfWorkers);
+        INFO(nrOfWorkers << " workers");
+
+        for (int nrOfTasks : {0, 1, 2, 7, 100}) {
+            std::vector<std::atomic<int>> runs(nrOfTasks);
+            for (auto& count : runs) count = 0;
+            pool.run(nrOfTasks, [&](int task) { runs[task]++; });
+
+            for (int task = 0; task < nrOfTasks; task++) REQUIRE( runs[task] == 1 );
+        }
+
+        //static bands and dynamic tasks cover every index once, also with more bands than indices
+        for (int nrOfBands : {1, 3, 50}) {
+            std::vector<std::atomic<int>> seen(37);
+            for (auto& count : seen) count = 0;
+            std::atomic<int> highestTask{0};
+            pool.parallelFor(5, 37, nrOfBands, [&](int index) { seen[index]++; });
+            pool.parallelForDynamic(5, 37, nrOfBands, [&](int index, int task) {
+                if (task > highestTask) highestTask = task;
+                seen[index]++;
+            });
+
+            REQUIRE( highestTask < nrOfBands );
+            for (int index = 0; index < 37; index++) REQUIRE( seen[index] == (index < 5 ? 0 : 2) );
+        }
+    }
+}
+
+TEST_CASE("Nested tasks of the thread pool use no more threads than the pool has", "[correctness]") {
+    ThreadPool pool(3);
+    std::atomic<int> running{0}, mostRunning{0}, innerTasks{0};
+
+    //like the images of a batch that are split into bands
+    pool.run(8, [&](int) {
+        pool.run(8, [&](int) {
+            int now = ++running;
+            int previous = mostRunning.load();
+            while (now > previous && !mostRunning.compare_exchange_weak(previous, now)) {}
+
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            innerTasks++;
+            running--;
+        });
+    });
+
+    REQUIRE( innerTasks == 64 );
+    //the three workers and the calling thread
+    REQUIRE( mostRunning <= 4 );
+}
+
+TEST_CASE("An exception in a task of the thread pool is passed to the caller", "[correctness]") {
+    ThreadPool pool(2);
+    std::atomic<int> finished{0};
+
+    REQUIRE_THROWS_AS( pool.run(10, [&](int task) {
+        if (task == 6) throw std::runtime_error("task failed");
+        finished++;
+    }), std::runtime_error );
+
+    //the other tasks still ran, and the pool can be used again
+    REQUIRE( finished == 9 );
+    pool.run(4, [&](int) { finished++; });
+    REQUIRE( finished == 13 );
+}
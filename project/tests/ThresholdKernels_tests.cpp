@@ -0,0 +1,115 @@
+#include "catch.hpp"
+#include "../ThresholdKernels.h"
+#include "../EnhancerImage.h"
+#include <vector>
+#include <random>
+#include <algorithm>
+
+TEST_CASE("Sum limits give the same decision as the double-precision comparison", "[correctness]") {
+    std::mt19937 generator(11);
+    for (double tresholdPercentage : {0.0, 0.15, 0.3, 1.0 / 3.0, 0.999, 1.0}) {
+        for (uint64_t nrOfPixelsInWindow : {uint64_t(0), uint64_t(4), uint64_t(36), uint64_t(38416), uint64_t(16777216)}) {
+            ThresholdKernels::SumLimits sumLimits;
+            REQUIRE( ThresholdKernels::buildSumLimits(nrOfPixelsInWindow, tresholdPercentage, sumLimits) );
+
+            //random sums, and the sums right next to every limit where the decision flips
+            std::vector<uint64_t> sums;
+            std::uniform_int_distribution<uint64_t> distribution(0, 255 * nrOfPixelsInWindow);
+            for (int i = 0; i < 1000; i++) sums.push_back(distribution(generator));
+
+            for (int brightness = 0; brightness < 256; brightness++) {
+                uint64_t limit = sumLimits.limits[brightness];
+                std::vector<uint64_t> candidates = sums;
+                for (uint64_t sum : {limit - 1, limit, limit + 1}) {
+                    if (sum <= 255 * nrOfPixelsInWindow) candidates.push_back(sum);
+                }
+
+                for (uint64_t sum : candidates) {
+                    bool expected = static_cast<uint64_t>(brightness * nrOfPixelsInWindow) > static_cast<uint64_t>(sum * (1.0 - tresholdPercentage));
+                    INFO("T = " << tresholdPercentage << ", window = " << nrOfPixelsInWindow << ", brightness = " << brightness << ", sum = " << sum);
+                    REQUIRE( (sum < limit) == expected );
+                }
+            }
+        }
+    }
+
+    ThresholdKernels::SumLimits sumLimits;
+    REQUIRE_FALSE( ThresholdKernels::buildSumLimits(36, 1.5, sumLimits) );
+}
+
+TEST_CASE("SIMD interior threshold kernel matches the scalar kernel", "[correctness]") {
+    if (!ThresholdKernels::isSupported(ThresholdKernels::AVX2)) return;
+
+    std::mt19937 generator(5);
+    int width = 1031, height = 41, halfWindow = 20;
+    std::vector<unsigned char> grayscale(static_cast<size_t>(width) * height);
+    for (auto& pixel : grayscale) pixel = static_cast<unsigned char>(generator());
+
+    std::vector<uint32_t> integralImage(grayscale.size());
+    EnhancerImage::buildIntegralImage(ImageView{grayscale.data(), width, height, static_cast<size_t>(width), 1}, integralImage.data(), 1);
+
+    ThresholdKernels::SumLimits sumLimits;
+    REQUIRE( ThresholdKernels::buildSumLimits(static_cast<uint64_t>(2 * halfWindow) * (2 * halfWindow), 0.15, sumLimits) );
+
+    //every start and end column modulo 16, so the SIMD loop and the scalar tail both get tested
+    int row = halfWindow;
+    const uint32_t* integralRow1 = integralImage.data();
+    const uint32_t* integralRow2 = integralImage.data() + static_cast<size_t>(2 * halfWindow) * width;
+    for (int firstColumn = halfWindow; firstColumn < halfWindow + 16; firstColumn++) {
+        for (int lastColumn = width - halfWindow - 16; lastColumn <= width - halfWindow; lastColumn++) {
+            std::vector<unsigned char> expected(width, 1), result(width, 1);
+            ThresholdKernels::thresholdInterior(ThresholdKernels::Scalar, integralRow1, integralRow2, grayscale.data() + static_cast<size_t>(row) * width, expected.data(), firstColumn, lastColumn, halfWindow, sumLimits);
+            ThresholdKernels::thresholdInterior(ThresholdKernels::AVX2, integralRow1, integralRow2, grayscale.data() + static_cast<size_t>(row) * width, result.data(), firstColumn, lastColumn, halfWindow, sumLimits);
+            REQUIRE( result == expected );
+        }
+    }
+}
+
+TEST_CASE("Interior and border split gives the same image as the clamped loop everywhere", "[correctness]") {
+    //File 1: 1562 * 1200 px, 3 channels
+    for (double windowSize : {0.0, 0.01, 0.125, 0.9, 1.5}) {
+        EnhancerImage image("test_input/inputfile1.jpg");
+        image.convertToGrayscale(1);
+        std::vector<unsigned char> grayscale;
+        for (int row = 0; row < image.height; row++) grayscale.insert(grayscale.end(), image.getRow(row), image.getRow(row) + image.width);
+
+        for (auto width : {EnhancerImage::IntegralWidth::Bits32, EnhancerImage::IntegralWidth::Bits64}) {
+            EnhancerImage binarized("test_input/inputfile1.jpg");
+            EnhancerImage::ThresholdingOptions options;
+            options.integralWidth = width;
+            binarized.applyAdaptiveThresholding(1, 3, windowSize, 0.15, options);
+
+            //the original loop, with the clamping for every pixel
+            std::vector<uint64_t> integralImage(grayscale.size());
+            EnhancerImage::buildIntegralImage(ImageView{grayscale.data(), image.width, image.height, static_cast<size_t>(image.width), 1}, integralImage.data(), 1);
+            int halfWindow = static_cast<int>(image.width * windowSize) / 2;
+            size_t mismatches = 0;
+            for (int row = 0; row < image.height; row++) {
+                int y1 = std::max(row - halfWindow, 0), y2 = std::min(row + halfWindow, image.height - 1);
+                for (int column = 0; column < image.width; column++) {
+                    int x1 = std::max(column - halfWindow, 0), x2 = std::min(column + halfWindow, image.width - 1);
+                    uint64_t sum = integralImage[static_cast<size_t>(y2) * image.width + x2] - integralImage[static_cast<size_t>(y1) * image.width + x2]
+                                 - integralImage[static_cast<size_t>(y2) * image.width + x1] + integralImage[static_cast<size_t>(y1) * image.width + x1];
+                    size_t index = static_cast<size_t>(row) * image.width + column;
+                    bool white = static_cast<uint64_t>(grayscale[index] * static_cast<uint64_t>((x2 - x1) * (y2 - y1))) > static_cast<uint64_t>(sum * (1.0 - 0.15));
+                    if (binarized.getRow(row)[column] != (white ? 255 : 0)) mismatches++;
+                }
+            }
+            INFO("window size " << windowSize);
+            REQUIRE( mismatches == 0 );
+        }
+    }
+}
+
+TEST_CASE("A selected thresholding kernel is used until another one is selected", "[correctness]") {
+    ThresholdKernels::InstructionSet best = ThresholdKernels::bestInstructionSet();
+    REQUIRE( ThresholdKernels::selectedInstructionSet() == best );
+
+    for (auto instructionSet : {ThresholdKernels::Scalar, ThresholdKernels::AVX2}) {
+        REQUIRE( ThresholdKernels::selectInstructionSet(instructionSet) == ThresholdKernels::isSupported(instructionSet) );
+        if (ThresholdKernels::isSupported(instructionSet)) REQUIRE( ThresholdKernels::selectedInstructionSet() == instructionSet );
+    }
+
+    REQUIRE( ThresholdKernels::selectInstructionSet(best) );
+    REQUIRE( ThresholdKernels::selectedInstructionSet() == best );
+}
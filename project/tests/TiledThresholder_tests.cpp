@@ -0,0 +1,88 @@
+#include "catch.hpp"
+#include "../TiledThresholder.h"
+#include "../EnhancerImage.h"
+#include "stb_image.h"
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+namespace fs = std::filesystem;
+
+TEST_CASE("Tiled thresholding gives the same result as the integral image version", "[correctness]") {
+    for (double windowSize : {0.0, 0.01, 0.125, 0.5}) {
+        EnhancerImage grayscale("test_input/heft_(1).jpg", EnhancerImage::Luma);
+        EnhancerImage reference("test_input/heft_(1).jpg", EnhancerImage::Luma);
+        reference.applyAdaptiveThresholding(1, 1, windowSize, 0.15, EnhancerImage::ThresholdingOptions());
+        int halfWindow = static_cast<int>(grayscale.width * windowSize) / 2;
+
+        //tiles of a single pixel, odd sizes, whole kernel blocks and a tile that is larger than the image
+        for (int tileSize : {1, 37, 128, 100000}) {
+            for (int nrOfThreads : {1, 3}) {
+                if (tileSize == 1 && windowSize > 0.01) continue;   //far too slow, the halo is much larger than the tile
+
+                std::vector<unsigned char> binarized(static_cast<size_t>(grayscale.width) * grayscale.height);
+                int nextRow = 0;
+                TiledThresholder thresholder(grayscale.width, grayscale.height, halfWindow, 0.15, tileSize, nrOfThreads, [&](int row, const unsigned char* binarizedRow) {
+                    REQUIRE( row == nextRow++ );
+                    std::copy(binarizedRow, binarizedRow + grayscale.width, binarized.begin() + static_cast<size_t>(row) * grayscale.width);
+                });
+
+                for (int row = 0; row < grayscale.height; row++) thresholder.pushRow(grayscale.getRow(row));
+
+                INFO("window size " << windowSize << ", tile size " << tileSize << ", " << nrOfThreads << " threads");
+                REQUIRE( thresholder.isFinished() );
+                for (int row = 0; row < reference.height; row++) {
+                    REQUIRE( std::equal(reference.getRow(row), reference.getRow(row) + reference.width, binarized.begin() + static_cast<size_t>(row) * grayscale.width) );
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("Tiles are made as large as the memory limit allows", "[correctness]") {
+    int width = 20000, height = 30000, halfWindow = 1250;
+
+    for (size_t memoryLimit : {size_t(256) << 20, size_t(512) << 20, size_t(1) << 30}) {
+        int tileSize = TiledThresholder::tileSizeFor(width, height, halfWindow, memoryLimit, 4);
+        INFO("memory limit " << memoryLimit);
+        REQUIRE( tileSize > 0 );
+        REQUIRE( tileSize % 64 == 0 );
+        REQUIRE( TiledThresholder::memoryUsage(width, height, halfWindow, tileSize, 4) <= memoryLimit );
+        REQUIRE( TiledThresholder::memoryUsage(width, height, halfWindow, tileSize + 64, 4) > memoryLimit );
+    }
+
+    //the rows of one window (about 50 MB here) and a tile integral image per thread always have to fit
+    REQUIRE( TiledThresholder::tileSizeFor(width, height, halfWindow, size_t(64) << 20, 4) == 0 );
+
+    //an image that fits as a whole is a single tile
+    REQUIRE( TiledThresholder::tileSizeFor(500, 400, 30, size_t(1) << 30, 1) == 500 );
+}
+
+TEST_CASE("A file binarized in tiles has the same pixels as the whole image", "[correctness]") {
+    fs::create_directories("test_input/test_output");
+
+    //a baseline JPEG is decoded row by row, the progressive JPEG and the BMP are loaded as a whole first
+    for (const char* file : {"heft_(1).jpg", "inputfile1.jpg", "adaptivethresholding1.bmp"}) {
+        for (int decodeScale : {1, 2}) {
+            std::string path = std::string("test_input/") + file;
+            EnhancerImage reference(path, EnhancerImage::Luma, decodeScale);
+            reference.applyAdaptiveThresholding(1, 1, 0.125, 0.15, EnhancerImage::ThresholdingOptions());
+
+            //a few MB, far less than the integral image of the whole image takes
+            size_t memoryLimit = 4 * 1024 * 1024 + static_cast<size_t>(reference.width) * 200;
+            REQUIRE( EnhancerImage::binarizeTiled(path, "test_input/test_output/tiled.png", EnhancerImage::Luma, decodeScale, 0.125, 0.15, memoryLimit, 2) );
+
+            int savedW, savedH, savedChannels;
+            unsigned char* saved = stbi_load("test_input/test_output/tiled.png", &savedW, &savedH, &savedChannels, 1);
+            INFO(file << " at 1/" << decodeScale);
+            REQUIRE( saved != nullptr );
+            REQUIRE( (savedW == reference.width && savedH == reference.height) );
+            for (int y = 0; y < savedH; y++) {
+                REQUIRE( std::equal(saved + static_cast<size_t>(y) * savedW, saved + static_cast<size_t>(y + 1) * savedW, reference.getRow(y)) );
+            }
+            stbi_image_free(saved);
+        }
+    }
+
+    //a limit that can't even hold the rows of one window fails instead of using more memory
+    REQUIRE( !EnhancerImage::binarizeTiled("test_input/heft_(1).jpg", "test_input/test_output/tiled.png", EnhancerImage::Luma, 1, 0.125, 0.15, 1024, 1) );
+}
@@ -0,0 +1,40 @@
+#include "catch.hpp"
+#include "../TuningProfile.h"
+#include <vector>
+#include <string>
+#include <fstream>
+#include <filesystem>
+namespace fs = std::filesystem;
+
+TEST_CASE("A written profile is read back as the same arguments", "[correctness]") {
+    fs::path path = "test_input/test_output/tuning/profile";
+    fs::remove_all(path.parent_path());
+
+    //the directory is created if it doesn't exist yet
+    REQUIRE( TuningProfile::write(path, {"found by --tune", "second # comment"}, {{"--integralWidth", "64"}, {"--adaptiveSplit", "false"}, {"--tileSize", "512"}}) );
+    REQUIRE( TuningProfile::read(path) == std::vector<std::string>({"--integralWidth", "64", "--adaptiveSplit", "false", "--tileSize", "512"}) );
+
+    //comments may also follow the arguments, and a line may hold several of them
+    {
+        std::ofstream file(path);
+        file << "#only a comment\n\n  -iw 32   -fu false # the rest of the line is ignored -ip true\n-st\ttrue\n";
+    }
+    REQUIRE( TuningProfile::read(path) == std::vector<std::string>({"-iw", "32", "-fu", "false", "-st", "true"}) );
+
+    fs::remove_all(path.parent_path());
+    REQUIRE( TuningProfile::read(path).empty() );
+}
+
+TEST_CASE("The calibration sample spreads over the image sizes", "[correctness]") {
+    std::vector<uint64_t> costs{10, 70, 30, 90, 50, 20, 80, 40, 60};
+
+    //fewer files than the sample: all of them, largest first
+    REQUIRE( TuningProfile::sample({5, 9, 1}, 8) == std::vector<int>({1, 0, 2}) );
+    REQUIRE( TuningProfile::sample(costs, 0).empty() );
+
+    //the largest and the smallest file, and evenly spaced ones between them
+    REQUIRE( TuningProfile::sample(costs, 1) == std::vector<int>({3}) );
+    REQUIRE( TuningProfile::sample(costs, 2) == std::vector<int>({3, 0}) );
+    REQUIRE( TuningProfile::sample(costs, 3) == std::vector<int>({3, 4, 0}) );
+    REQUIRE( TuningProfile::sample(costs, 5) == std::vector<int>({3, 1, 4, 2, 0}) );
+}